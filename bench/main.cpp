@@ -0,0 +1,372 @@
+#include "Camera.h"
+#include "CpuProfiler.h"
+#include "GLExtensions.h"
+#include "HeadlessContext.h"
+#include "HeadlessRunner.h"
+#include "OffscreenFramebuffer.h"
+#include "Scene.h"
+#include "ScriptedCamera.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct BenchOptions
+	{
+		SceneParams scene;
+		std::vector<std::string> models = { "cube", "pyramid" };
+		CullingMode cullingMode = CullingMode::Cpu;
+		InstanceUploadMode uploadMode = InstanceUploadMode::BufferSubData;
+		int frames = 600;
+		// frames rendered before measuring, so shader compilation and first uploads stay out of the numbers
+		int warmup = 60;
+		int width = 1280;
+		int height = 720;
+		std::string outputPath = "bench.json";
+	};
+
+	struct SampleStats
+	{
+		double mean = 0.0;
+		double p50 = 0.0;
+		double p95 = 0.0;
+		double p99 = 0.0;
+		double max = 0.0;
+	};
+
+	// the samples of one measured frame, all in milliseconds
+	struct FrameSample
+	{
+		double frame = 0.0;
+		double gpu = 0.0;
+		ScenePhaseTimes phases;
+	};
+
+	const char* CullingModeNames[] = { "none", "cpu", "gpu" };
+	const char* UploadModeNames[] = { "subdata", "ring" };
+	const char* VertexFormatNames[] = { "float", "packed", "quantized" };
+	const char* TextureBindingNames[] = { "bound", "bindless" };
+
+	void PrintUsage()
+	{
+		std::cout << "usage: bench [--grid ROWSxCOLUMNS] [--lamps N] [--models HOUSE,ROOF] [--culling none|cpu|gpu]\n"
+			"             [--upload-mode subdata|ring] [--vertex-format float|packed|quantized] [--textures bound|bindless]\n"
+			"             [--texture-arrays on|off] [--frames N] [--warmup N] [--size WxH] [--output FILE]" << std::endl;
+	}
+
+	std::string ModelPath(const std::string& name)
+	{
+		return "res/models/" + name + "/" + name + ".obj";
+	}
+
+	bool ParseBenchOptions(int argc, char** argv, BenchOptions& options)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const std::string argument = argv[i];
+			if (i + 1 >= argc)
+			{
+				PrintUsage();
+				return false;
+			}
+			const std::string value = argv[++i];
+
+			bool valid = true;
+			if (argument == "--grid")
+			{
+				valid = ParseSize(value, options.scene.rows, options.scene.columns);
+			}
+			else if (argument == "--lamps")
+			{
+				int lamps = 0;
+				valid = ParseInt(value, lamps) && lamps >= 0 && static_cast<std::size_t>(lamps) <= MaxStreetLamps;
+				options.scene.streetLamps = static_cast<std::size_t>(std::max(lamps, 0));
+			}
+			else if (argument == "--models")
+			{
+				options.models.clear();
+				std::stringstream names(value);
+				std::string name;
+				while (std::getline(names, name, ','))
+					options.models.emplace_back(name);
+				valid = options.models.size() == 2;
+			}
+			else if (argument == "--culling")
+			{
+				const auto mode = std::find(std::begin(CullingModeNames), std::end(CullingModeNames), value);
+				valid = mode != std::end(CullingModeNames);
+				if (valid)
+					options.cullingMode = static_cast<CullingMode>(mode - std::begin(CullingModeNames));
+			}
+			else if (argument == "--upload-mode")
+			{
+				const auto mode = std::find(std::begin(UploadModeNames), std::end(UploadModeNames), value);
+				valid = mode != std::end(UploadModeNames);
+				if (valid)
+					options.uploadMode = static_cast<InstanceUploadMode>(mode - std::begin(UploadModeNames));
+			}
+			else if (argument == "--vertex-format")
+			{
+				const auto format = std::find(std::begin(VertexFormatNames), std::end(VertexFormatNames), value);
+				valid = format != std::end(VertexFormatNames);
+				if (valid)
+					options.scene.vertexCompression = static_cast<VertexCompression>(format - std::begin(VertexFormatNames));
+			}
+			else if (argument == "--textures")
+			{
+				const auto binding = std::find(std::begin(TextureBindingNames), std::end(TextureBindingNames), value);
+				valid = binding != std::end(TextureBindingNames);
+				if (valid)
+					options.scene.textureBinding = static_cast<TextureBinding>(binding - std::begin(TextureBindingNames));
+			}
+			else if (argument == "--texture-arrays")
+			{
+				valid = value == "on" || value == "off";
+				options.scene.textureArrays = value == "on";
+			}
+			else if (argument == "--frames")
+				valid = ParseInt(value, options.frames) && options.frames > 0;
+			else if (argument == "--warmup")
+				valid = ParseInt(value, options.warmup) && options.warmup >= 0;
+			else if (argument == "--size")
+				valid = ParseSize(value, options.width, options.height);
+			else if (argument == "--output")
+				options.outputPath = value;
+			else
+				valid = false;
+
+			if (!valid)
+			{
+				std::cout << "ERROR::BENCH::BAD_ARGUMENT " << argument << " " << value << std::endl;
+				PrintUsage();
+				return false;
+			}
+		}
+
+		options.scene.houseModel = ModelPath(options.models[0]);
+		options.scene.roofModel = ModelPath(options.models[1]);
+		return true;
+	}
+
+	// nearest rank percentiles, samples are sorted in place
+	SampleStats ComputeStats(std::vector<double>& samples)
+	{
+		SampleStats stats;
+		if (samples.empty())
+			return stats;
+
+		std::sort(samples.begin(), samples.end());
+
+		double sum = 0.0;
+		for (double sample : samples)
+			sum += sample;
+		stats.mean = sum / static_cast<double>(samples.size());
+
+		const auto percentile = [&samples](double p)
+		{
+			const auto rank = static_cast<std::size_t>(std::ceil(p / 100.0 * static_cast<double>(samples.size())));
+			return samples[std::max<std::size_t>(rank, 1) - 1];
+		};
+		stats.p50 = percentile(50.0);
+		stats.p95 = percentile(95.0);
+		stats.p99 = percentile(99.0);
+		stats.max = samples.back();
+
+		return stats;
+	}
+
+	template <typename Field>
+	SampleStats ComputeStats(const std::vector<FrameSample>& frames, Field field)
+	{
+		std::vector<double> samples;
+		samples.reserve(frames.size());
+		for (const auto& frame : frames)
+			samples.emplace_back(field(frame));
+		return ComputeStats(samples);
+	}
+
+	void WriteStats(std::ostream& out, const SampleStats& stats)
+	{
+		out << "{ \"mean\": " << stats.mean << ", \"p50\": " << stats.p50 << ", \"p95\": " << stats.p95
+			<< ", \"p99\": " << stats.p99 << ", \"max\": " << stats.max << " }";
+	}
+
+	// names and strings written here never need escaping beyond quotes and backslashes
+	std::string JsonString(const std::string& text)
+	{
+		std::string quoted = "\"";
+		for (char c : text)
+		{
+			if (c == '"' || c == '\\')
+				quoted += '\\';
+			quoted += c;
+		}
+		return quoted + "\"";
+	}
+
+	bool WriteReport(const BenchOptions& options, const std::string& renderer, const std::vector<FrameSample>& frames)
+	{
+		std::ofstream out(options.outputPath);
+		if (!out)
+			return false;
+
+		out << "{\n";
+		out << "  \"renderer\": " << JsonString(renderer) << ",\n";
+		out << "  \"scene\": {\n";
+		out << "    \"rows\": " << options.scene.rows << ",\n";
+		out << "    \"columns\": " << options.scene.columns << ",\n";
+		out << "    \"instances\": " << 2 * options.scene.rows * options.scene.columns << ",\n";
+		out << "    \"lamps\": " << options.scene.streetLamps << ",\n";
+		out << "    \"models\": [" << JsonString(options.models[0]) << ", " << JsonString(options.models[1]) << "],\n";
+		out << "    \"culling\": " << JsonString(CullingModeNames[static_cast<int>(options.cullingMode)]) << ",\n";
+		out << "    \"upload_mode\": " << JsonString(UploadModeNames[static_cast<int>(options.uploadMode)]) << ",\n";
+		// the ring falls back to orphaning where buffer storage isn't supported
+		if (options.uploadMode == InstanceUploadMode::PersistentRing)
+			out << "    \"ring_mapped\": " << (InstanceRingBuffer::IsPersistentMappingSupported() ? "true" : "false") << ",\n";
+		out << "    \"vertex_format\": " << JsonString(VertexFormatNames[static_cast<int>(options.scene.vertexCompression)]) << ",\n";
+		// the binding actually used, bindless falls back to bound where it isn't supported
+		out << "    \"textures\": " << JsonString(BindlessTextures::Default().IsEnabled() ? "bindless" : "bound") << ",\n";
+		out << "    \"texture_arrays\": " << (options.scene.textureArrays ? "true" : "false") << "\n";
+		out << "  },\n";
+		out << "  \"width\": " << options.width << ",\n";
+		out << "  \"height\": " << options.height << ",\n";
+		out << "  \"warmup\": " << options.warmup << ",\n";
+		out << "  \"frames\": " << frames.size() << ",\n";
+
+		out << "  \"frame_ms\": ";
+		WriteStats(out, ComputeStats(frames, [](const FrameSample& f) { return f.frame; }));
+		out << ",\n  \"gpu_ms\": ";
+		WriteStats(out, ComputeStats(frames, [](const FrameSample& f) { return f.gpu; }));
+
+		out << ",\n  \"cpu_phases_ms\": {\n    \"update\": ";
+		WriteStats(out, ComputeStats(frames, [](const FrameSample& f) { return f.phases.update; }));
+		out << ",\n    \"lights\": ";
+		WriteStats(out, ComputeStats(frames, [](const FrameSample& f) { return f.phases.lights; }));
+		out << ",\n    \"shaders\": ";
+		WriteStats(out, ComputeStats(frames, [](const FrameSample& f) { return f.phases.shaders; }));
+		out << ",\n    \"culling\": ";
+		WriteStats(out, ComputeStats(frames, [](const FrameSample& f) { return f.phases.culling; }));
+		out << ",\n    \"draw\": ";
+		WriteStats(out, ComputeStats(frames, [](const FrameSample& f) { return f.phases.draw; }));
+		out << "\n  }\n}\n";
+
+		return static_cast<bool>(out);
+	}
+}
+
+// Renders the scene described by the arguments along the scripted camera path and writes
+// p50/p95/p99 frame times, GPU time and CPU time per scene phase as JSON.
+// Every frame ends with glFinish, so the frame time covers both the CPU and the GPU work of that frame.
+int main(int argc, char** argv)
+{
+	BenchOptions options;
+	if (!ParseBenchOptions(argc, argv, options))
+		return static_cast<int>(HeadlessResult::BadArguments);
+
+	HeadlessContext context;
+	if (!context.Create())
+		return static_cast<int>(HeadlessResult::NoContext);
+
+	if (!gladLoadGLLoader(HeadlessContext::GetLoader()))
+	{
+		std::cout << "ERROR::BENCH::GL_LOADER_FAILED" << std::endl;
+		return static_cast<int>(HeadlessResult::NoContext);
+	}
+	InitGLExtensions(HeadlessContext::GetLoader());
+
+	const std::string renderer = reinterpret_cast<const char*>(glGetString(GL_RENDERER));
+
+	OffscreenFramebuffer framebuffer(options.width, options.height);
+	if (!framebuffer.IsComplete())
+	{
+		std::cout << "ERROR::BENCH::FRAMEBUFFER_INCOMPLETE" << std::endl;
+		return static_cast<int>(HeadlessResult::NoContext);
+	}
+
+	std::vector<FrameSample> frames;
+	frames.reserve(options.frames);
+
+	HeadlessResult result = HeadlessResult::Success;
+	{
+		Scene scene(options.scene);
+		scene.FinishLoading();
+		scene.SetCullingMode(options.cullingMode);
+		scene.SetInstanceUploadMode(options.uploadMode);
+
+		Camera camera;
+
+		unsigned int gpuQuery = 0;
+		glGenQueries(1, &gpuQuery);
+
+		const int totalFrames = options.warmup + options.frames;
+		for (int frame = 0; frame < totalFrames; frame++)
+		{
+			const auto start = std::chrono::steady_clock::now();
+
+			// warmup frames fly the first part of the path, measured frames the whole of it
+			const int pathFrame = frame < options.warmup ? frame : frame - options.warmup;
+			PlaceScriptedCamera(camera, pathFrame, options.frames);
+			scene.Update(static_cast<float>(pathFrame) * ScriptedFrameTime);
+
+			framebuffer.Bind();
+			glBeginQuery(GL_TIME_ELAPSED, gpuQuery);
+			scene.Render(camera, options.width, options.height);
+			glEndQuery(GL_TIME_ELAPSED);
+			glFinish();
+
+			const double frameMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			const GLenum glError = glGetError();
+			if (glError != GL_NO_ERROR)
+			{
+				std::cout << "ERROR::BENCH::GL_ERROR 0x" << std::hex << glError << std::dec << " in frame " << frame << std::endl;
+				result = HeadlessResult::GLError;
+				break;
+			}
+
+			if (frame < options.warmup)
+				continue;
+
+			// available right away after glFinish
+			GLuint64 gpuNanoseconds = 0;
+			glGetQueryObjectui64v(gpuQuery, GL_QUERY_RESULT, &gpuNanoseconds);
+
+			FrameSample& sample = frames.emplace_back();
+			sample.frame = frameMilliseconds;
+			sample.gpu = static_cast<double>(gpuNanoseconds) / 1.0e6;
+			sample.phases = scene.GetPhaseTimes();
+		}
+
+		glDeleteQueries(1, &gpuQuery);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	CPU_PROFILE_EXPORT("cpu_trace.json");
+
+	if (result != HeadlessResult::Success)
+		return static_cast<int>(result);
+
+	if (!WriteReport(options, renderer, frames))
+	{
+		std::cout << "ERROR::BENCH::REPORT_NOT_WRITTEN " << options.outputPath << std::endl;
+		return static_cast<int>(HeadlessResult::WriteFailed);
+	}
+
+	std::vector<double> frameTimes;
+	for (const auto& sample : frames)
+		frameTimes.emplace_back(sample.frame);
+	const SampleStats stats = ComputeStats(frameTimes);
+	std::cout << options.frames << " frames on " << renderer << ": p50 " << stats.p50 << " ms, p95 " << stats.p95
+		<< " ms, p99 " << stats.p99 << " ms, written to " << options.outputPath << std::endl;
+
+	return static_cast<int>(HeadlessResult::Success);
+}
@@ -5,8 +5,12 @@ layout (location = 0) in vec3 aPos;
 uniform mat4 VP;
 uniform mat4 model;
 
+// positions quantized to the mesh bounds are scaled back, offset 0 and scale 1 for float positions
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
 void main()
 { 
-    gl_Position = VP *  model * vec4(aPos, 1.0);
+    gl_Position = VP *  model * vec4(positionOffset + positionScale * aPos, 1.0);
 
 }
\ No newline at end of file
@@ -1,4 +1,6 @@
 #version 430 core
+// only a warning where the driver lacks it, the bindless path is then compiled out
+#extension GL_ARB_bindless_texture : enable
 
 #define NR_POINT_LIGHTS 1
 #define NR_SPOT_LIGHTS 2
@@ -65,22 +67,74 @@ in vec2 TexCoords;
 
 uniform vec3 viewPos;
 
-uniform DirLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform SpotLight spotLights[NR_SPOT_LIGHTS];
+// shared by every program using this shader, filled once per frame from LightBlock.h
+layout (std140, binding = 0) uniform LightBlock
+{
+    DirLight dirLight;
+    PointLight pointLights[NR_POINT_LIGHTS];
+    SpotLight spotLights[NR_SPOT_LIGHTS];
+};
+
+// clustered point lights, any number of them, see LightClusters.h
+struct ClusterPointLight
+{
+    vec4 positionRadius;
+    vec4 color;
+};
+
+layout (std140, binding = 1) uniform ClusterBlock
+{
+    mat4 clusterView;
+    uvec4 clusterGridSize;      // w - 0 when there is nothing clustered
+    vec4 clusterDepthSlicing;   // slice = log(view depth) * x + y
+    vec4 clusterViewportSize;
+};
+
+layout (std430, binding = 3) readonly buffer ClusterLights
+{
+    ClusterPointLight clusterLights[];
+};
+
+layout (std430, binding = 4) readonly buffer ClusterGrid
+{
+    uvec2 clusterCells[];       // x - first index, y - light count
+};
+
+layout (std430, binding = 5) readonly buffer ClusterIndices
+{
+    uint clusterLightIndices[];
+};
 
 //MATERIAL
 uniform sampler2D texture_diffuse1;
 uniform sampler2D texture_specular1;
+// the same textures when they were packed into a texture array, see TextureArrays.h
+uniform sampler2DArray texture_diffuse1_layers;
+uniform sampler2DArray texture_specular1_layers;
+uniform ivec4 materialLayers = ivec4(-1);   // diffuse1, specular1, normal1, height1, -1 where not packed
 uniform float shininess;
 
+#ifdef GL_ARB_bindless_texture
+// resident handles of every material, 4 per material, see BindlessTextures.h
+layout (std430, binding = 6) readonly buffer MaterialTextures
+{
+    uvec2 materialTextures[];   // diffuse1, specular1, normal1, height1
+};
+
+uniform bool bindlessTextures;
+uniform int materialIndex;
+#endif
+
 uniform bool isBlinn;
 uniform float blinnExponent;
 
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);  
 vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcClusterLight(ClusterPointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+uint findCluster(vec3 fragPos);
 float calcBlinn(vec3 lDir, vec3 vDir, vec3 normal);
+vec4 sampleMaterial(sampler2D boundTexture, sampler2DArray layeredTexture, int slot);
 
 void main()
 {	
@@ -105,6 +159,14 @@ void main()
     if(dirLight.isActive)
         result += CalcDirLight(dirLight, norm, viewDir);
 
+    if(clusterGridSize.w != 0u)
+    {
+        // only the lights reaching this fragment's cluster
+        uvec2 cell = clusterCells[findCluster(FragPos)];
+        for(uint i = cell.x; i < cell.x + cell.y; i++)
+            result += CalcClusterLight(clusterLights[clusterLightIndices[i]], norm, FragPos, viewDir);
+    }
+
  
     FragColor = vec4(result, 1.0);
 } 
@@ -128,9 +190,9 @@ vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir)
     }
     
     // combine results
-    vec3 ambient = light.colors.ambient * vec3(texture(texture_diffuse1, TexCoords));
-    vec3 diffuse = light.colors.diffuse * diff * vec3(texture(texture_diffuse1, TexCoords));
-    vec3 specular = light.colors.specular * spec * vec3(texture(texture_specular1, TexCoords));
+    vec3 ambient = light.colors.ambient * vec3(sampleMaterial(texture_diffuse1, texture_diffuse1_layers, 0));
+    vec3 diffuse = light.colors.diffuse * diff * vec3(sampleMaterial(texture_diffuse1, texture_diffuse1_layers, 0));
+    vec3 specular = light.colors.specular * spec * vec3(sampleMaterial(texture_specular1, texture_specular1_layers, 1));
 
     return (ambient + diffuse + specular);
 }
@@ -158,9 +220,9 @@ vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     float distance = length(light.position - fragPos);
     float attenuation = calcAttenuation(light.att, distance);//1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
     // combine results
-    vec3 ambient = light.colors.ambient * vec3(texture(texture_diffuse1, TexCoords));
-    vec3 diffuse = light.colors.diffuse * diff * vec3(texture(texture_diffuse1, TexCoords));
-    vec3 specular = light.colors.specular * spec * vec3(texture(texture_specular1, TexCoords));
+    vec3 ambient = light.colors.ambient * vec3(sampleMaterial(texture_diffuse1, texture_diffuse1_layers, 0));
+    vec3 diffuse = light.colors.diffuse * diff * vec3(sampleMaterial(texture_diffuse1, texture_diffuse1_layers, 0));
+    vec3 specular = light.colors.specular * spec * vec3(sampleMaterial(texture_specular1, texture_specular1_layers, 1));
     ambient *= attenuation;
     diffuse *= attenuation;
     specular *= attenuation;
@@ -194,9 +256,9 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     float epsilon = light.cutOff - light.outerCutOff;
     float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
     // combine results
-    vec3 ambient = light.colors.ambient * vec3(texture(texture_diffuse1, TexCoords));
-    vec3 diffuse = light.colors.diffuse * diff * vec3(texture(texture_diffuse1, TexCoords));
-    vec3 specular = light.colors.specular * spec * vec3(texture(texture_specular1, TexCoords));
+    vec3 ambient = light.colors.ambient * vec3(sampleMaterial(texture_diffuse1, texture_diffuse1_layers, 0));
+    vec3 diffuse = light.colors.diffuse * diff * vec3(sampleMaterial(texture_diffuse1, texture_diffuse1_layers, 0));
+    vec3 specular = light.colors.specular * spec * vec3(sampleMaterial(texture_specular1, texture_specular1_layers, 1));
     
     ambient *= attenuation * intensity;
     diffuse *= attenuation * intensity;
@@ -205,9 +267,62 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     return (ambient + diffuse + specular);
 }
 
+vec3 CalcClusterLight(ClusterPointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 toLight = light.positionRadius.xyz - fragPos;
+    float distance = length(toLight);
+    float radius = light.positionRadius.w;
+    if(distance >= radius)
+        return vec3(0.0);
+
+    vec3 lightDir = toLight / distance;
+    // diffuse shading
+    float diff = max(dot(normal, lightDir), 0.0);
+    // specular shading
+    float spec = 0.0f;
+    if(isBlinn)
+    {
+        spec = calcBlinn(lightDir, viewDir, normal);
+    }
+    else
+    {
+        spec = pow(max(dot(viewDir, reflect(-lightDir, normal)), 0.0), shininess);
+    }
+
+    // falls off to exactly zero at the radius the light was clustered with
+    float falloff = 1.0 - (distance * distance) / (radius * radius);
+    falloff *= falloff;
+
+    vec3 diffuse = diff * vec3(sampleMaterial(texture_diffuse1, texture_diffuse1_layers, 0));
+    vec3 specular = spec * vec3(sampleMaterial(texture_specular1, texture_specular1_layers, 1));
+    return light.color.rgb * (diffuse + specular) * falloff;
+}
+
+uint findCluster(vec3 fragPos)
+{
+    float depth = -(clusterView * vec4(fragPos, 1.0)).z;
+    uint slice = uint(clamp(log(depth) * clusterDepthSlicing.x + clusterDepthSlicing.y, 0.0, float(clusterGridSize.z - 1u)));
+
+    uvec2 tile = uvec2(gl_FragCoord.xy / clusterViewportSize.xy * vec2(clusterGridSize.xy));
+    tile = min(tile, clusterGridSize.xy - 1u);
+
+    return (slice * clusterGridSize.y + tile.y) * clusterGridSize.x + tile.x;
+}
+
 float calcBlinn(vec3 lDir, vec3 vDir, vec3 normal)
 {
     vec3 halfwayDir = normalize(lDir + vDir);
     float spec = pow(max(dot(normal, halfwayDir), 0.0f), blinnExponent);
     return spec;
-}
\ No newline at end of file
+}
+
+vec4 sampleMaterial(sampler2D boundTexture, sampler2DArray layeredTexture, int slot)
+{
+#ifdef GL_ARB_bindless_texture
+    if(bindlessTextures)
+        return texture(sampler2D(materialTextures[materialIndex * 4 + slot]), TexCoords);
+#endif
+    if(materialLayers[slot] >= 0)
+        return texture(layeredTexture, vec3(TexCoords, float(materialLayers[slot])));
+    return texture(boundTexture, TexCoords);
+}
@@ -14,9 +14,13 @@ uniform vec3 offset;
 uniform int chosenInstance;
 uniform mat4 mainObjectModel;
 
+// positions quantized to the mesh bounds are scaled back, offset 0 and scale 1 for float positions
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
 void main()
 {
-    vec3 pos = aPos;
+    vec3 pos = positionOffset + positionScale * aPos;
 
     //if(gl_InstanceID  == chosenInstance)
     //{
@@ -11,9 +11,13 @@ out vec2 TexCoords;
 uniform mat4 VP;
 uniform mat4 model;
 
+// positions quantized to the mesh bounds are scaled back, offset 0 and scale 1 for float positions
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
+    FragPos = vec3(model * vec4(positionOffset + positionScale * aPos, 1.0));
     Normal = mat3(transpose(inverse(model))) * aNormal;  
     TexCoords = aTexCoords;
     
@@ -0,0 +1,141 @@
+#include "AsyncLoader.h"
+
+#include <algorithm>
+#include <chrono>
+
+AsyncLoader::AsyncLoader(unsigned int threadCount)
+{
+	threadCount = std::max(threadCount, 1u);
+	workers.reserve(threadCount);
+	for (unsigned int i = 0; i < threadCount; i++)
+		workers.emplace_back(&AsyncLoader::WorkerLoop, this);
+}
+
+AsyncLoader::~AsyncLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(taskMutex);
+		stopping = true;
+		tasks.clear();
+	}
+	taskAvailable.notify_all();
+
+	for (auto& worker : workers)
+		worker.join();
+}
+
+void AsyncLoader::Enqueue(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(taskMutex);
+		if (stopping)
+			return;
+
+		tasks.emplace_back(std::move(task));
+		unfinishedTasks++;
+	}
+	taskAvailable.notify_one();
+}
+
+void AsyncLoader::EnqueueUpload(std::function<void()> upload)
+{
+	{
+		std::lock_guard<std::mutex> lock(uploadMutex);
+		uploads.emplace_back(std::move(upload));
+	}
+	uploadAvailable.notify_all();
+}
+
+std::size_t AsyncLoader::ProcessUploads(double budgetMilliseconds)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	std::size_t processed = 0;
+	for (;;)
+	{
+		std::function<void()> upload;
+		{
+			std::lock_guard<std::mutex> lock(uploadMutex);
+			if (uploads.empty())
+				break;
+
+			upload = std::move(uploads.front());
+			uploads.pop_front();
+		}
+
+		upload();
+		processed++;
+
+		const double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (elapsed >= budgetMilliseconds)
+			break;
+	}
+
+	return processed;
+}
+
+void AsyncLoader::Finish()
+{
+	for (;;)
+	{
+		ProcessUploads(1.0e9);
+
+		{
+			std::unique_lock<std::mutex> taskLock(taskMutex);
+			if (unfinishedTasks == 0)
+			{
+				taskLock.unlock();
+
+				// the last task may have queued uploads right before finishing
+				std::lock_guard<std::mutex> uploadLock(uploadMutex);
+				if (uploads.empty())
+					return;
+				continue;
+			}
+		}
+
+		// woken by new uploads, the timeout catches tasks finishing without queueing any
+		std::unique_lock<std::mutex> lock(uploadMutex);
+		uploadAvailable.wait_for(lock, std::chrono::milliseconds(1), [this] { return !uploads.empty(); });
+	}
+}
+
+bool AsyncLoader::IsIdle() const
+{
+	{
+		std::lock_guard<std::mutex> lock(taskMutex);
+		if (unfinishedTasks > 0)
+			return false;
+	}
+
+	std::lock_guard<std::mutex> lock(uploadMutex);
+	return uploads.empty();
+}
+
+std::size_t AsyncLoader::GetPendingUploadCount() const
+{
+	std::lock_guard<std::mutex> lock(uploadMutex);
+	return uploads.size();
+}
+
+void AsyncLoader::WorkerLoop()
+{
+	for (;;)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(taskMutex);
+			taskAvailable.wait(lock, [this] { return stopping || !tasks.empty(); });
+			if (stopping)
+				return;
+
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+
+		task();
+
+		std::lock_guard<std::mutex> lock(taskMutex);
+		unfinishedTasks--;
+	}
+}
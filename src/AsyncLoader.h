@@ -0,0 +1,61 @@
+#pragma once
+#ifndef ASYNC_LOADER_H
+#define ASYNC_LOADER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs loading work (file parsing, image decoding, mipmap generation) on worker threads and
+// hands whatever needs the GL context back to the thread owning it through an upload queue.
+// The GL thread drains the queue with ProcessUploads under a time budget, so loading never stalls a frame for long.
+class AsyncLoader
+{
+public:
+	explicit AsyncLoader(unsigned int threadCount);
+	// lets running tasks finish, queued tasks and uploads are dropped
+	~AsyncLoader();
+
+	AsyncLoader(const AsyncLoader&) = delete;
+	AsyncLoader& operator=(const AsyncLoader&) = delete;
+
+	// runs task on a worker thread, tasks may enqueue further tasks and uploads
+	void Enqueue(std::function<void()> task);
+
+	// runs upload on the next ProcessUploads, in the order the uploads were enqueued
+	void EnqueueUpload(std::function<void()> upload);
+
+	// runs queued uploads on the calling thread until the budget is spent, at least one when any is queued.
+	// returns the number of uploads run
+	std::size_t ProcessUploads(double budgetMilliseconds);
+
+	// blocks until every task finished and every upload ran, the uploads run on the calling thread
+	void Finish();
+
+	// true when no task or upload is waiting or running
+	bool IsIdle() const;
+
+	std::size_t GetPendingUploadCount() const;
+
+private:
+	void WorkerLoop();
+
+	std::vector<std::thread> workers;
+
+	mutable std::mutex taskMutex;
+	std::condition_variable taskAvailable;
+	std::deque<std::function<void()>> tasks;
+	// queued plus running tasks
+	std::size_t unfinishedTasks = 0;
+	bool stopping = false;
+
+	mutable std::mutex uploadMutex;
+	std::condition_variable uploadAvailable;
+	std::deque<std::function<void()>> uploads;
+};
+
+#endif
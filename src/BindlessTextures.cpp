@@ -0,0 +1,185 @@
+#include "BindlessTextures.h"
+
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include "TextureCache.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	const char* SlotSamplers[BindlessTextures::SlotCount] = { "texture_diffuse1", "texture_specular1", "texture_normal1", "texture_height1" };
+
+	constexpr std::size_t InitialBufferRows = 64;
+}
+
+BindlessTextures& BindlessTextures::Default()
+{
+	static BindlessTextures textures;
+	return textures;
+}
+
+bool BindlessTextures::IsSupported()
+{
+	return glGetTextureHandleARB != nullptr;
+}
+
+int BindlessTextures::GetSlot(const char* samplerName)
+{
+	for (unsigned int slot = 0; slot < SlotCount; slot++)
+	{
+		if (std::strcmp(SlotSamplers[slot], samplerName) == 0)
+			return static_cast<int>(slot);
+	}
+	return -1;
+}
+
+void BindlessTextures::SetMode(TextureBinding newMode)
+{
+	mode = newMode;
+}
+
+TextureBinding BindlessTextures::GetMode() const
+{
+	return mode;
+}
+
+bool BindlessTextures::IsEnabled() const
+{
+	return mode == TextureBinding::Bindless && IsSupported();
+}
+
+int BindlessTextures::GetRow(const Slots& textures, int row)
+{
+	if (row >= 0 && static_cast<std::size_t>(row) < rows.size() && rows[row].complete && rows[row].textures == textures)
+		return row;
+
+	auto found = rowIndices.find(textures);
+	if (found == rowIndices.end())
+	{
+		found = rowIndices.emplace(textures, rows.size()).first;
+		rows.push_back({ textures, false });
+		rowHandles.resize(rows.size() * SlotCount, 0);
+	}
+
+	if (!rows[found->second].complete)
+		Resolve(found->second);
+	return static_cast<int>(found->second);
+}
+
+void BindlessTextures::Forget(unsigned int texture)
+{
+	const auto found = handles.find(texture);
+	if (found == handles.end())
+		return;
+
+	glMakeTextureHandleNonResidentARB(found->second);
+	handles.erase(found);
+
+	// the name may come back as another texture, the rows find out on their next use
+	for (Row& row : rows)
+	{
+		if (std::find(row.textures.begin(), row.textures.end(), texture) != row.textures.end())
+			row.complete = false;
+	}
+}
+
+std::size_t BindlessTextures::GetRowCount() const
+{
+	return rows.size();
+}
+
+std::size_t BindlessTextures::GetResidentCount() const
+{
+	return handles.size();
+}
+
+GLuint64 BindlessTextures::GetHandle(unsigned int texture)
+{
+	const auto found = handles.find(texture);
+	if (found != handles.end())
+		return found->second;
+
+	// getting a handle makes the texture immutable, an asynchronous load must have filled it first
+	if (!TextureCache::Default().IsUploaded(texture))
+		return 0;
+
+	const GLuint64 handle = glGetTextureHandleARB(texture);
+	if (handle == 0)
+		return 0;
+
+	glMakeTextureHandleResidentARB(handle);
+	handles.emplace(texture, handle);
+	return handle;
+}
+
+GLuint64 BindlessTextures::GetBlackHandle()
+{
+	if (blackHandle != 0)
+		return blackHandle;
+
+	const unsigned char black[4] = { 0, 0, 0, 255 };
+	glGenTextures(1, &blackTexture);
+	GLStateCache::Default().BindTexture(GL_TEXTURE_2D, blackTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, black);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	blackHandle = glGetTextureHandleARB(blackTexture);
+	glMakeTextureHandleResidentARB(blackHandle);
+	return blackHandle;
+}
+
+void BindlessTextures::Resolve(std::size_t row)
+{
+	Row& entry = rows[row];
+	entry.complete = true;
+
+	bool changed = false;
+	for (unsigned int slot = 0; slot < SlotCount; slot++)
+	{
+		GLuint64 handle = entry.textures[slot] != 0 ? GetHandle(entry.textures[slot]) : GetBlackHandle();
+		if (handle == 0)
+		{
+			handle = GetBlackHandle();
+			entry.complete = false;
+		}
+
+		GLuint64& uploaded = rowHandles[row * SlotCount + slot];
+		changed = changed || uploaded != handle;
+		uploaded = handle;
+	}
+
+	if (changed)
+		Upload(row);
+}
+
+void BindlessTextures::Upload(std::size_t row)
+{
+	GLStateCache& glState = GLStateCache::Default();
+	constexpr std::size_t RowBytes = SlotCount * sizeof(GLuint64);
+
+	if (row < bufferRows)
+	{
+		glState.BindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, static_cast<GLintptr>(row * RowBytes), RowBytes, &rowHandles[row * SlotCount]);
+		glState.BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		return;
+	}
+
+	// grown buffers start over with every row uploaded so far
+	if (buffer == 0)
+		glGenBuffers(1, &buffer);
+	bufferRows = std::max(InitialBufferRows, bufferRows * 2);
+	while (bufferRows <= row)
+		bufferRows *= 2;
+
+	std::vector<GLuint64> contents(bufferRows * SlotCount, 0);
+	std::copy(rowHandles.begin(), rowHandles.end(), contents.begin());
+
+	glState.BindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<GLsizeiptr>(contents.size() * sizeof(GLuint64)), contents.data(), GL_DYNAMIC_DRAW);
+	glState.BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	glState.BindBufferBase(GL_SHADER_STORAGE_BUFFER, StorageBinding, buffer);
+}
@@ -0,0 +1,91 @@
+#pragma once
+#ifndef BINDLESS_TEXTURES_H
+#define BINDLESS_TEXTURES_H
+
+#include <glad/glad.h>
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+// how materials hand their textures to the shaders
+enum class TextureBinding
+{
+	// glBindTexture to the unit of every sampler
+	Bound,
+	// resident handles read from a shader storage buffer, needs ARB_bindless_texture
+	Bindless
+};
+
+// Resident ARB_bindless_texture handles of material textures, in a shader storage buffer light.frag indexes with materialIndex.
+// Every distinct set of textures gets one row of SlotCount handles, so switching materials is a uniform instead of texture binds.
+// Handles are only made for textures the TextureCache has uploaded, since a handle freezes the texture, until then
+// (and for slots without a texture) the row points at a 1x1 black texture, which samples like an unbound unit.
+// Only used from the GL thread.
+class BindlessTextures
+{
+public:
+	// must match light.frag
+	static constexpr unsigned int StorageBinding = 6;
+	// texture_diffuse1, texture_specular1, texture_normal1, texture_height1
+	static constexpr unsigned int SlotCount = 4;
+
+	using Slots = std::array<unsigned int, SlotCount>;
+
+	// handles of the one context the application renders with
+	static BindlessTextures& Default();
+
+	// whether the context has ARB_bindless_texture, InitGLExtensions must have run
+	static bool IsSupported();
+	// slot of a sampler name, -1 for samplers without one
+	static int GetSlot(const char* samplerName);
+
+	// Bindless falls back to Bound where it isn't supported
+	void SetMode(TextureBinding newMode);
+	TextureBinding GetMode() const;
+	bool IsEnabled() const;
+
+	// row holding the handles of the textures, 0 in a slot for none. row is what the last call for the same textures returned,
+	// -1 the first time, and spares the lookup once all of them have handles
+	int GetRow(const Slots& textures, int row);
+
+	// drops the handle of a texture about to be deleted, rows using it fall back to black until the name is uploaded again
+	void Forget(unsigned int texture);
+
+	std::size_t GetRowCount() const;
+	std::size_t GetResidentCount() const;
+
+private:
+	BindlessTextures() = default;
+
+	struct Row
+	{
+		Slots textures{};
+		// false while a texture of the row has no handle yet
+		bool complete = false;
+	};
+
+	// 0 while the texture isn't uploaded
+	GLuint64 GetHandle(unsigned int texture);
+	GLuint64 GetBlackHandle();
+	void Resolve(std::size_t row);
+	void Upload(std::size_t row);
+
+	TextureBinding mode = TextureBinding::Bound;
+
+	std::vector<Row> rows;
+	std::map<Slots, std::size_t> rowIndices;
+	// SlotCount per row, as uploaded
+	std::vector<GLuint64> rowHandles;
+	std::unordered_map<unsigned int, GLuint64> handles;
+
+	unsigned int blackTexture = 0;
+	GLuint64 blackHandle = 0;
+
+	unsigned int buffer = 0;
+	std::size_t bufferRows = 0;
+};
+
+#endif
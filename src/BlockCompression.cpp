@@ -0,0 +1,237 @@
+#include "BlockCompression.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace
+{
+	constexpr int BlockTexels = 16;
+
+	// copies a 4x4 block, texels outside the image repeat the last row and column
+	void FetchBlock(const unsigned char* rgba, int width, int height, int blockX, int blockY, unsigned char block[BlockTexels][4])
+	{
+		for (int y = 0; y < 4; y++)
+		{
+			const int sourceY = std::min(blockY * 4 + y, height - 1);
+			for (int x = 0; x < 4; x++)
+			{
+				const int sourceX = std::min(blockX * 4 + x, width - 1);
+				const unsigned char* texel = rgba + (static_cast<std::size_t>(sourceY) * width + sourceX) * 4;
+				std::copy(texel, texel + 4, block[y * 4 + x]);
+			}
+		}
+	}
+
+	std::uint16_t PackRgb565(const float color[3])
+	{
+		const auto quantize = [](float value, int maximum)
+		{
+			return static_cast<std::uint16_t>(std::clamp(static_cast<int>(std::lround(value / 255.0f * maximum)), 0, maximum));
+		};
+		return static_cast<std::uint16_t>(quantize(color[0], 31) << 11 | quantize(color[1], 63) << 5 | quantize(color[2], 31));
+	}
+
+	void UnpackRgb565(std::uint16_t packed, int color[3])
+	{
+		const int r = packed >> 11 & 31;
+		const int g = packed >> 5 & 63;
+		const int b = packed & 31;
+		color[0] = r << 3 | r >> 2;
+		color[1] = g << 2 | g >> 4;
+		color[2] = b << 3 | b >> 2;
+	}
+
+	// 8 byte color block: two 565 endpoints followed by 2 bit indices, always in four color mode
+	void EncodeColorBlock(const unsigned char block[BlockTexels][4], unsigned char* out)
+	{
+		float mean[3] = { 0.0f, 0.0f, 0.0f };
+		for (int i = 0; i < BlockTexels; i++)
+			for (int c = 0; c < 3; c++)
+				mean[c] += block[i][c];
+		for (float& component : mean)
+			component /= BlockTexels;
+
+		float covariance[6] = {};
+		for (int i = 0; i < BlockTexels; i++)
+		{
+			const float r = block[i][0] - mean[0];
+			const float g = block[i][1] - mean[1];
+			const float b = block[i][2] - mean[2];
+			covariance[0] += r * r;
+			covariance[1] += r * g;
+			covariance[2] += r * b;
+			covariance[3] += g * g;
+			covariance[4] += g * b;
+			covariance[5] += b * b;
+		}
+
+		// a few power iterations find the principal axis well enough for 16 texels
+		float axis[3] = { 1.0f, 1.0f, 1.0f };
+		for (int iteration = 0; iteration < 8; iteration++)
+		{
+			const float next[3] = {
+				covariance[0] * axis[0] + covariance[1] * axis[1] + covariance[2] * axis[2],
+				covariance[1] * axis[0] + covariance[3] * axis[1] + covariance[4] * axis[2],
+				covariance[2] * axis[0] + covariance[4] * axis[1] + covariance[5] * axis[2] };
+			const float length = std::max({ std::fabs(next[0]), std::fabs(next[1]), std::fabs(next[2]) });
+			if (length < 1e-6f)
+				break;
+			for (int c = 0; c < 3; c++)
+				axis[c] = next[c] / length;
+		}
+
+		const float axisLengthSquared = axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2];
+		float minProjection = 0.0f;
+		float maxProjection = 0.0f;
+		for (int i = 0; i < BlockTexels; i++)
+		{
+			const float projection = ((block[i][0] - mean[0]) * axis[0] + (block[i][1] - mean[1]) * axis[1] +
+				(block[i][2] - mean[2]) * axis[2]) / axisLengthSquared;
+			minProjection = std::min(minProjection, projection);
+			maxProjection = std::max(maxProjection, projection);
+		}
+
+		// pulling the endpoints in by half a palette step lowers the error of the texels between them
+		const float inset = (maxProjection - minProjection) / 16.0f;
+		float endpoints[2][3];
+		for (int c = 0; c < 3; c++)
+		{
+			endpoints[0][c] = mean[c] + axis[c] * (maxProjection - inset);
+			endpoints[1][c] = mean[c] + axis[c] * (minProjection + inset);
+		}
+
+		std::uint16_t color0 = PackRgb565(endpoints[0]);
+		std::uint16_t color1 = PackRgb565(endpoints[1]);
+		// color0 > color1 selects the four color mode
+		if (color0 < color1)
+			std::swap(color0, color1);
+
+		std::uint32_t indices = 0;
+		if (color0 != color1)
+		{
+			int palette[4][3];
+			UnpackRgb565(color0, palette[0]);
+			UnpackRgb565(color1, palette[1]);
+			for (int c = 0; c < 3; c++)
+			{
+				palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+				palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+			}
+
+			for (int i = 0; i < BlockTexels; i++)
+			{
+				int bestIndex = 0;
+				int bestDistance = INT32_MAX;
+				for (int p = 0; p < 4; p++)
+				{
+					int distance = 0;
+					for (int c = 0; c < 3; c++)
+						distance += (block[i][c] - palette[p][c]) * (block[i][c] - palette[p][c]);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = p;
+					}
+				}
+				indices |= static_cast<std::uint32_t>(bestIndex) << (2 * i);
+			}
+		}
+
+		out[0] = static_cast<unsigned char>(color0 & 0xFF);
+		out[1] = static_cast<unsigned char>(color0 >> 8);
+		out[2] = static_cast<unsigned char>(color1 & 0xFF);
+		out[3] = static_cast<unsigned char>(color1 >> 8);
+		for (int i = 0; i < 4; i++)
+			out[4 + i] = static_cast<unsigned char>(indices >> (8 * i));
+	}
+
+	// 8 byte single channel block, as the alpha of BC3 and each channel of BC5:
+	// the channel's maximum and minimum followed by 3 bit indices into 8 values between them
+	void EncodeChannelBlock(const unsigned char block[BlockTexels][4], int channel, unsigned char* out)
+	{
+		int maximum = 0;
+		int minimum = 255;
+		for (int i = 0; i < BlockTexels; i++)
+		{
+			maximum = std::max<int>(maximum, block[i][channel]);
+			minimum = std::min<int>(minimum, block[i][channel]);
+		}
+
+		std::uint64_t indices = 0;
+		if (maximum != minimum)
+		{
+			int palette[8] = { maximum, minimum };
+			for (int p = 2; p < 8; p++)
+				palette[p] = ((8 - p) * maximum + (p - 1) * minimum) / 7;
+
+			for (int i = 0; i < BlockTexels; i++)
+			{
+				int bestIndex = 0;
+				int bestDistance = INT32_MAX;
+				for (int p = 0; p < 8; p++)
+				{
+					const int distance = std::abs(block[i][channel] - palette[p]);
+					if (distance < bestDistance)
+					{
+						bestDistance = distance;
+						bestIndex = p;
+					}
+				}
+				indices |= static_cast<std::uint64_t>(bestIndex) << (3 * i);
+			}
+		}
+
+		out[0] = static_cast<unsigned char>(maximum);
+		out[1] = static_cast<unsigned char>(minimum);
+		for (int i = 0; i < 6; i++)
+			out[2 + i] = static_cast<unsigned char>(indices >> (8 * i));
+	}
+}
+
+std::size_t GetBlockBytes(BlockFormat format)
+{
+	return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+std::size_t GetCompressedSize(BlockFormat format, int width, int height)
+{
+	const std::size_t blocksX = (static_cast<std::size_t>(width) + 3) / 4;
+	const std::size_t blocksY = (static_cast<std::size_t>(height) + 3) / 4;
+	return blocksX * blocksY * GetBlockBytes(format);
+}
+
+std::vector<unsigned char> CompressImage(const unsigned char* rgba, int width, int height, BlockFormat format)
+{
+	std::vector<unsigned char> blocks(GetCompressedSize(format, width, height));
+	const std::size_t blockBytes = GetBlockBytes(format);
+	const int blocksX = (width + 3) / 4;
+	const int blocksY = (height + 3) / 4;
+
+	unsigned char block[BlockTexels][4];
+	for (int blockY = 0; blockY < blocksY; blockY++)
+	{
+		for (int blockX = 0; blockX < blocksX; blockX++)
+		{
+			FetchBlock(rgba, width, height, blockX, blockY, block);
+			unsigned char* out = blocks.data() + (static_cast<std::size_t>(blockY) * blocksX + blockX) * blockBytes;
+
+			switch (format)
+			{
+			case BlockFormat::BC1:
+				EncodeColorBlock(block, out);
+				break;
+			case BlockFormat::BC3:
+				EncodeChannelBlock(block, 3, out);
+				EncodeColorBlock(block, out + 8);
+				break;
+			case BlockFormat::BC5:
+				EncodeChannelBlock(block, 0, out);
+				EncodeChannelBlock(block, 1, out + 8);
+				break;
+			}
+		}
+	}
+
+	return blocks;
+}
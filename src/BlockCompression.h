@@ -0,0 +1,28 @@
+#pragma once
+#ifndef BLOCK_COMPRESSION_H
+#define BLOCK_COMPRESSION_H
+
+#include <cstddef>
+#include <vector>
+
+// block compressed formats baked by texbake, every block covers 4x4 texels
+enum class BlockFormat
+{
+	// opaque color, 8 bytes per block
+	BC1,
+	// color with alpha, 16 bytes per block
+	BC3,
+	// two independent channels, for tangent space normal maps whose z is rebuilt in the shader, 16 bytes per block
+	BC5
+};
+
+std::size_t GetBlockBytes(BlockFormat format);
+
+// bytes of one level, partial blocks at the right and bottom edges count as whole
+std::size_t GetCompressedSize(BlockFormat format, int width, int height);
+
+// encodes an RGBA8 image. endpoints are fitted along the principal axis of each block's colors,
+// which is fast and close enough to the exhaustive encoders for diffuse and specular maps
+std::vector<unsigned char> CompressImage(const unsigned char* rgba, int width, int height, BlockFormat format);
+
+#endif
@@ -72,6 +72,18 @@ void Camera::ProcessMouseScroll(float yoffset)
 		Zoom = 45.0f;
 }
 
+// moves the camera to position and turns it towards target, used by scripted camera paths
+void Camera::LookAt(glm::vec3 position, glm::vec3 target)
+{
+	Position = position;
+
+	const glm::vec3 direction = glm::normalize(target - position);
+	Yaw = glm::degrees(glm::atan(direction.z, direction.x));
+	Pitch = glm::degrees(glm::asin(direction.y));
+
+	updateCameraVectors();
+}
+
 
 // calculates the front vector from the Camera's (updated) Euler Angles
 void Camera::updateCameraVectors()
@@ -56,6 +56,9 @@ public:
     // processes input received from a mouse scroll-wheel event. Only requires input on the vertical wheel-axis
     void ProcessMouseScroll(float yoffset);
 
+    // moves the camera to position and turns it towards target, used by scripted camera paths
+    void LookAt(glm::vec3 position, glm::vec3 target);
+
 private:
     // calculates the front vector from the Camera's (updated) Euler Angles
     void updateCameraVectors();
@@ -0,0 +1,109 @@
+#include "CpuProfiler.h"
+
+#ifdef OPENGLPAG_CPU_PROFILING
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+	struct Event
+	{
+		const char* name;
+		std::uint64_t start;
+		std::uint64_t end;
+	};
+
+	// written only by its own thread, the count is published after the event so readers never see a half written one
+	struct ThreadRing
+	{
+		std::unique_ptr<Event[]> events{ new Event[CpuProfiler::RingCapacity] };
+		std::atomic<std::uint64_t> written{ 0 };
+		unsigned int threadId = 0;
+	};
+
+	// the registry is only locked when a thread records its first marker and during the export
+	std::mutex registryMutex;
+	std::vector<std::shared_ptr<ThreadRing>> registry;
+
+	const auto Epoch = std::chrono::steady_clock::now();
+
+	ThreadRing& GetThreadRing()
+	{
+		// the registry keeps the ring of a finished thread alive until the export
+		thread_local std::shared_ptr<ThreadRing> ring;
+		if (!ring)
+		{
+			ring = std::make_shared<ThreadRing>();
+
+			std::lock_guard<std::mutex> lock(registryMutex);
+			ring->threadId = static_cast<unsigned int>(registry.size());
+			registry.emplace_back(ring);
+		}
+		return *ring;
+	}
+
+	void WriteJsonString(std::ostream& out, const char* text)
+	{
+		out << '"';
+		for (; *text; text++)
+		{
+			if (*text == '"' || *text == '\\')
+				out << '\\';
+			out << *text;
+		}
+		out << '"';
+	}
+}
+
+std::uint64_t CpuProfiler::Now()
+{
+	return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - Epoch).count());
+}
+
+void CpuProfiler::Record(const char* name, std::uint64_t start, std::uint64_t end)
+{
+	ThreadRing& ring = GetThreadRing();
+	const std::uint64_t index = ring.written.load(std::memory_order_relaxed);
+	ring.events[index % RingCapacity] = { name, start, end };
+	ring.written.store(index + 1, std::memory_order_release);
+}
+
+bool CpuProfiler::ExportChromeTrace(const std::string& path)
+{
+	std::ofstream out(path);
+	if (!out)
+		return false;
+
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	bool first = true;
+	std::lock_guard<std::mutex> lock(registryMutex);
+	for (const auto& ring : registry)
+	{
+		const std::uint64_t written = ring->written.load(std::memory_order_acquire);
+		const std::uint64_t begin = written > RingCapacity ? written - RingCapacity : 0;
+		for (std::uint64_t i = begin; i < written; i++)
+		{
+			const Event& event = ring->events[i % RingCapacity];
+
+			if (!first)
+				out << ",\n";
+			first = false;
+
+			out << "{\"name\":";
+			WriteJsonString(out, event.name);
+			out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->threadId << ",\"ts\":" << event.start
+				<< ",\"dur\":" << event.end - event.start << "}";
+		}
+	}
+
+	out << "\n]}\n";
+	return static_cast<bool>(out);
+}
+
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+#ifndef CPU_PROFILER_H
+#define CPU_PROFILER_H
+
+// Scoped CPU timing markers, compiled in only when the build defines OPENGLPAG_CPU_PROFILING
+// (cmake -DOPENGLPAG_CPU_PROFILING=ON). Otherwise CPU_PROFILE_SCOPE and CPU_PROFILE_EXPORT expand to nothing.
+//
+//     CPU_PROFILE_SCOPE("Model::LoadModel");
+//
+// Every thread records its markers into its own ring buffer without locking,
+// the rings are merged when exported as Chrome trace-event JSON (chrome://tracing, Perfetto).
+
+#ifdef OPENGLPAG_CPU_PROFILING
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace CpuProfiler
+{
+	// markers kept per thread, the oldest ones are overwritten first
+	constexpr std::size_t RingCapacity = 1 << 16;
+
+	// microseconds since the first marker of the process
+	std::uint64_t Now();
+
+	// name has to outlive the export, string literals are expected
+	void Record(const char* name, std::uint64_t start, std::uint64_t end);
+
+	// writes the markers of all threads, exact while no other thread is recording
+	bool ExportChromeTrace(const std::string& path);
+
+	class ScopedMarker
+	{
+	public:
+		explicit ScopedMarker(const char* name) : name(name), start(Now())
+		{
+		}
+
+		~ScopedMarker()
+		{
+			Record(name, start, Now());
+		}
+
+		ScopedMarker(const ScopedMarker&) = delete;
+		ScopedMarker& operator=(const ScopedMarker&) = delete;
+
+	private:
+		const char* name;
+		std::uint64_t start;
+	};
+}
+
+#define CPU_PROFILE_CONCAT_INNER(a, b) a##b
+#define CPU_PROFILE_CONCAT(a, b) CPU_PROFILE_CONCAT_INNER(a, b)
+#define CPU_PROFILE_SCOPE(name) CpuProfiler::ScopedMarker CPU_PROFILE_CONCAT(cpuProfileMarker, __LINE__)(name)
+#define CPU_PROFILE_EXPORT(path) CpuProfiler::ExportChromeTrace(path)
+
+#else
+
+#define CPU_PROFILE_SCOPE(name)
+#define CPU_PROFILE_EXPORT(path)
+
+#endif
+
+#endif
@@ -0,0 +1,53 @@
+#include "DirtyRangeSet.h"
+
+#include <algorithm>
+
+void DirtyRangeSet::Add(std::size_t index)
+{
+	Add(index, index + 1);
+}
+
+void DirtyRangeSet::Add(std::size_t begin, std::size_t end)
+{
+	if (begin >= end)
+		return;
+
+	// indices usually arrive in ascending order, so most of them just extend the last range
+	if (!ranges.empty() && ranges.back().end == begin)
+	{
+		ranges.back().end = end;
+		return;
+	}
+
+	ranges.push_back({ begin, end });
+}
+
+void DirtyRangeSet::Clear()
+{
+	ranges.clear();
+}
+
+bool DirtyRangeSet::Empty() const
+{
+	return ranges.empty();
+}
+
+const std::vector<DirtyRangeSet::Range>& DirtyRangeSet::Coalesce(std::size_t maxGap)
+{
+	if (ranges.size() < 2)
+		return ranges;
+
+	std::sort(ranges.begin(), ranges.end(), [](const Range& a, const Range& b) { return a.begin < b.begin; });
+
+	std::size_t last = 0;
+	for (std::size_t i = 1; i < ranges.size(); i++)
+	{
+		if (ranges[i].begin <= ranges[last].end + maxGap)
+			ranges[last].end = std::max(ranges[last].end, ranges[i].end);
+		else
+			ranges[++last] = ranges[i];
+	}
+
+	ranges.resize(last + 1);
+	return ranges;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#ifndef DIRTY_RANGE_SET_H
+#define DIRTY_RANGE_SET_H
+
+#include <cstddef>
+#include <vector>
+
+// Collects indices of modified elements as half-open [begin, end) ranges,
+// so buffers mirroring the elements can be updated with as few uploads as possible.
+class DirtyRangeSet
+{
+public:
+	struct Range
+	{
+		std::size_t begin;
+		std::size_t end;
+	};
+
+	void Add(std::size_t index);
+	void Add(std::size_t begin, std::size_t end);
+	void Clear();
+
+	bool Empty() const;
+
+	// sorts and merges the collected ranges, ranges closer than maxGap elements are joined
+	// because one slightly larger upload is cheaper than two separate ones
+	const std::vector<Range>& Coalesce(std::size_t maxGap = 0);
+
+private:
+	std::vector<Range> ranges;
+};
+
+#endif
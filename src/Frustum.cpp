@@ -0,0 +1,90 @@
+#include "Frustum.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define FRUSTUM_USE_SSE 1
+#include <xmmintrin.h>
+#endif
+
+Frustum Frustum::FromMatrix(const glm::mat4& viewProjection)
+{
+	// rows of the matrix, glm stores columns
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; i++)
+		rows[i] = glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+
+	Frustum frustum;
+	frustum.planes[Left] = rows[3] + rows[0];
+	frustum.planes[Right] = rows[3] - rows[0];
+	frustum.planes[Bottom] = rows[3] + rows[1];
+	frustum.planes[Top] = rows[3] - rows[1];
+	frustum.planes[Near] = rows[3] + rows[2];
+	frustum.planes[Far] = rows[3] - rows[2];
+
+	for (auto& plane : frustum.planes)
+		plane = plane / glm::length(glm::vec3(plane));
+
+	return frustum;
+}
+
+bool Frustum::IntersectsSphere(const glm::vec3& center, float radius) const
+{
+	for (const auto& plane : planes)
+	{
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+			return false;
+	}
+
+	return true;
+}
+
+void Frustum::CullSpheres(const float* centersX, const float* centersY, const float* centersZ, const float* radii,
+	std::size_t count, std::vector<unsigned int>& visible) const
+{
+	std::size_t i = 0;
+
+#ifdef FRUSTUM_USE_SSE
+	__m128 planeX[PlaneCount], planeY[PlaneCount], planeZ[PlaneCount], planeW[PlaneCount];
+	for (int p = 0; p < PlaneCount; p++)
+	{
+		planeX[p] = _mm_set1_ps(planes[p].x);
+		planeY[p] = _mm_set1_ps(planes[p].y);
+		planeZ[p] = _mm_set1_ps(planes[p].z);
+		planeW[p] = _mm_set1_ps(planes[p].w);
+	}
+
+	const __m128 zero = _mm_setzero_ps();
+
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 x = _mm_loadu_ps(centersX + i);
+		const __m128 y = _mm_loadu_ps(centersY + i);
+		const __m128 z = _mm_loadu_ps(centersZ + i);
+		const __m128 negativeRadius = _mm_sub_ps(zero, _mm_loadu_ps(radii + i));
+
+		// a sphere is culled as soon as it lies entirely behind one of the planes
+		__m128 inside = _mm_cmpeq_ps(zero, zero);
+		for (int p = 0; p < PlaneCount; p++)
+		{
+			__m128 distance = _mm_mul_ps(planeX[p], x);
+			distance = _mm_add_ps(distance, _mm_mul_ps(planeY[p], y));
+			distance = _mm_add_ps(distance, _mm_mul_ps(planeZ[p], z));
+			distance = _mm_add_ps(distance, planeW[p]);
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+		}
+
+		int mask = _mm_movemask_ps(inside);
+		while (mask != 0)
+		{
+			const int lane = mask & 1 ? 0 : mask & 2 ? 1 : mask & 4 ? 2 : 3;
+			visible.emplace_back(static_cast<unsigned int>(i + lane));
+			mask &= mask - 1;
+		}
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		if (IntersectsSphere(glm::vec3(centersX[i], centersY[i], centersZ[i]), radii[i]))
+			visible.emplace_back(static_cast<unsigned int>(i));
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+// View frustum as six normalized planes, a point p is inside a plane when dot(plane.xyz, p) + plane.w >= 0.
+struct Frustum
+{
+	enum Plane { Left, Right, Bottom, Top, Near, Far, PlaneCount };
+
+	glm::vec4 planes[PlaneCount];
+
+	// extracts the planes of a projection * view (* model) matrix, the planes end up in the space the matrix transforms from
+	static Frustum FromMatrix(const glm::mat4& viewProjection);
+
+	bool IntersectsSphere(const glm::vec3& center, float radius) const;
+
+	// tests count spheres given as separate coordinate arrays and appends the indices of the ones touching the frustum to visible.
+	// batches of four spheres are tested at once when SSE is available.
+	void CullSpheres(const float* centersX, const float* centersY, const float* centersZ, const float* radii,
+		std::size_t count, std::vector<unsigned int>& visible) const;
+};
+
+#endif
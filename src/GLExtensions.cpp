@@ -0,0 +1,56 @@
+#include "GLExtensions.h"
+
+#include <string>
+#include <unordered_set>
+
+namespace
+{
+	GLADloadproc glLoader = nullptr;
+	std::unordered_set<std::string> extensions;
+}
+
+PFNGLGETTEXTUREHANDLEARBPROC glGetTextureHandleARB = nullptr;
+PFNGLMAKETEXTUREHANDLERESIDENTARBPROC glMakeTextureHandleResidentARB = nullptr;
+PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC glMakeTextureHandleNonResidentARB = nullptr;
+
+void InitGLExtensions(GLADloadproc loader)
+{
+	glLoader = loader;
+	extensions.clear();
+
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; i++)
+		extensions.emplace(reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i)));
+
+	// ARB_buffer_storage exposes the core 4.4 entry point on older contexts
+	if (glBufferStorage == nullptr && HasGLExtension("GL_ARB_buffer_storage"))
+		glad_glBufferStorage = reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(GetGLProcAddress("glBufferStorage"));
+
+	glGetTextureHandleARB = nullptr;
+	glMakeTextureHandleResidentARB = nullptr;
+	glMakeTextureHandleNonResidentARB = nullptr;
+	if (HasGLExtension("GL_ARB_bindless_texture"))
+	{
+		const auto getHandle = reinterpret_cast<PFNGLGETTEXTUREHANDLEARBPROC>(GetGLProcAddress("glGetTextureHandleARB"));
+		const auto makeResident = reinterpret_cast<PFNGLMAKETEXTUREHANDLERESIDENTARBPROC>(GetGLProcAddress("glMakeTextureHandleResidentARB"));
+		const auto makeNonResident = reinterpret_cast<PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC>(GetGLProcAddress("glMakeTextureHandleNonResidentARB"));
+		// a partly loaded extension is no extension
+		if (getHandle != nullptr && makeResident != nullptr && makeNonResident != nullptr)
+		{
+			glGetTextureHandleARB = getHandle;
+			glMakeTextureHandleResidentARB = makeResident;
+			glMakeTextureHandleNonResidentARB = makeNonResident;
+		}
+	}
+}
+
+bool HasGLExtension(const char* name)
+{
+	return extensions.find(name) != extensions.end();
+}
+
+void* GetGLProcAddress(const char* name)
+{
+	return glLoader != nullptr ? glLoader(name) : nullptr;
+}
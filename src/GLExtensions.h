@@ -0,0 +1,24 @@
+#pragma once
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <glad/glad.h>
+
+// Must be called once after gladLoadGLLoader with the same loader.
+// Fetches entry points of extensions that glad only loads together with the core version promoting them, or not at all.
+void InitGLExtensions(GLADloadproc loader);
+
+bool HasGLExtension(const char* name);
+
+void* GetGLProcAddress(const char* name);
+
+// ARB_bindless_texture, which glad was generated without. all three are null unless the context has the extension
+typedef GLuint64 (APIENTRYP PFNGLGETTEXTUREHANDLEARBPROC)(GLuint texture);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLERESIDENTARBPROC)(GLuint64 handle);
+typedef void (APIENTRYP PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC)(GLuint64 handle);
+
+extern PFNGLGETTEXTUREHANDLEARBPROC glGetTextureHandleARB;
+extern PFNGLMAKETEXTUREHANDLERESIDENTARBPROC glMakeTextureHandleResidentARB;
+extern PFNGLMAKETEXTUREHANDLENONRESIDENTARBPROC glMakeTextureHandleNonResidentARB;
+
+#endif
@@ -0,0 +1,386 @@
+#include "GLStateCache.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+
+namespace
+{
+	const GLenum BufferTargets[] = { GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER,
+		GL_DRAW_INDIRECT_BUFFER, GL_DISPATCH_INDIRECT_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GL_PIXEL_UNPACK_BUFFER };
+	const GLenum BufferBindings[] = { GL_ARRAY_BUFFER_BINDING, GL_ELEMENT_ARRAY_BUFFER_BINDING, GL_UNIFORM_BUFFER_BINDING,
+		GL_SHADER_STORAGE_BUFFER_BINDING, GL_DRAW_INDIRECT_BUFFER_BINDING, GL_DISPATCH_INDIRECT_BUFFER_BINDING,
+		GL_COPY_READ_BUFFER_BINDING, GL_COPY_WRITE_BUFFER_BINDING, GL_PIXEL_UNPACK_BUFFER_BINDING };
+	const char* BufferNames[] = { "array buffer", "element array buffer", "uniform buffer", "shader storage buffer",
+		"draw indirect buffer", "dispatch indirect buffer", "copy read buffer", "copy write buffer", "pixel unpack buffer" };
+	constexpr int ElementArrayBuffer = 1;
+
+	const GLenum TextureTargets[] = { GL_TEXTURE_2D, GL_TEXTURE_2D_ARRAY };
+	const GLenum TextureBindings[] = { GL_TEXTURE_BINDING_2D, GL_TEXTURE_BINDING_2D_ARRAY };
+	const char* TextureNames[] = { "2D", "2D array" };
+
+	const GLenum Capabilities[] = { GL_DEPTH_TEST, GL_CULL_FACE, GL_BLEND };
+	const char* CapabilityNames[] = { "depth test", "cull face", "blend" };
+
+	template <std::size_t N>
+	int IndexOf(const GLenum (&targets)[N], GLenum target)
+	{
+		const auto found = std::find(std::begin(targets), std::end(targets), target);
+		return found == std::end(targets) ? -1 : static_cast<int>(found - std::begin(targets));
+	}
+
+	void ReportDesync(const std::string& name, unsigned int cached, unsigned int actual)
+	{
+		std::cout << "ERROR::GL_STATE_CACHE::DESYNC " << name << " cached " << cached << " driver " << actual << std::endl;
+	}
+}
+
+GLStateCache& GLStateCache::Default()
+{
+	static GLStateCache cache;
+	return cache;
+}
+
+GLStateCache::GLStateCache()
+{
+	Invalidate();
+}
+
+void GLStateCache::Invalidate()
+{
+	program = Unknown;
+	vertexArray = Unknown;
+	std::fill(std::begin(buffers), std::end(buffers), Unknown);
+	activeUnit = Unknown;
+	for (auto& unit : textures)
+		std::fill(std::begin(unit), std::end(unit), Unknown);
+	std::fill(std::begin(capabilities), std::end(capabilities), Unknown);
+	cullFaceMode = Unknown;
+	depthFunction = Unknown;
+	blendSource = Unknown;
+	blendDestination = Unknown;
+}
+
+bool GLStateCache::UseProgram(unsigned int newProgram)
+{
+	program = Check("program", program, GL_CURRENT_PROGRAM);
+	if (Skip(program == newProgram))
+		return false;
+
+	glUseProgram(newProgram);
+	program = newProgram;
+	return true;
+}
+
+bool GLStateCache::BindVertexArray(unsigned int newVertexArray)
+{
+	vertexArray = Check("vertex array", vertexArray, GL_VERTEX_ARRAY_BINDING);
+	if (Skip(vertexArray == newVertexArray))
+		return false;
+
+	glBindVertexArray(newVertexArray);
+	vertexArray = newVertexArray;
+	buffers[ElementArrayBuffer] = Unknown;
+	return true;
+}
+
+bool GLStateCache::BindBuffer(GLenum target, unsigned int buffer)
+{
+	const int index = IndexOf(BufferTargets, target);
+	if (index < 0)
+	{
+		glBindBuffer(target, buffer);
+		stats.calls++;
+		return true;
+	}
+
+	buffers[index] = Check(BufferNames[index], buffers[index], BufferBindings[index]);
+	if (Skip(buffers[index] == buffer))
+		return false;
+
+	glBindBuffer(target, buffer);
+	buffers[index] = buffer;
+	return true;
+}
+
+void GLStateCache::BindBufferBase(GLenum target, unsigned int index, unsigned int buffer)
+{
+	glBindBufferBase(target, index, buffer);
+	stats.calls++;
+
+	const int targetIndex = IndexOf(BufferTargets, target);
+	if (targetIndex >= 0)
+		buffers[targetIndex] = buffer;
+}
+
+bool GLStateCache::ActiveTexture(unsigned int unit)
+{
+	if (activeUnit != Unknown)
+		activeUnit = Check("active texture", GL_TEXTURE0 + activeUnit, GL_ACTIVE_TEXTURE) - GL_TEXTURE0;
+	if (Skip(activeUnit == unit))
+		return false;
+
+	glActiveTexture(GL_TEXTURE0 + unit);
+	activeUnit = unit;
+	return true;
+}
+
+bool GLStateCache::BindTexture(GLenum target, unsigned int texture)
+{
+	if (activeUnit != Unknown)
+		return BindTextureUnit(activeUnit, target, texture);
+
+	// without knowing the unit the binding can't be remembered
+	glBindTexture(target, texture);
+	stats.calls++;
+	return true;
+}
+
+bool GLStateCache::BindTextureUnit(unsigned int unit, GLenum target, unsigned int texture)
+{
+	const int targetIndex = IndexOf(TextureTargets, target);
+	if (targetIndex < 0 || unit >= MaxTextureUnits)
+	{
+		ActiveTexture(unit);
+		glBindTexture(target, texture);
+		stats.calls++;
+		return true;
+	}
+
+	unsigned int& bound = textures[unit][targetIndex];
+	bound = CheckTexture(unit, targetIndex, bound);
+	if (Skip(bound == texture))
+		return false;
+
+	ActiveTexture(unit);
+	glBindTexture(target, texture);
+	bound = texture;
+	return true;
+}
+
+bool GLStateCache::SetCapability(GLCapability capability, bool enabled)
+{
+	const int index = static_cast<int>(capability);
+	unsigned int& cached = capabilities[index];
+
+	if (validating && cached != Unknown)
+	{
+		const unsigned int actual = glIsEnabled(Capabilities[index]) ? 1 : 0;
+		if (actual != cached)
+		{
+			ReportDesync(CapabilityNames[index], cached, actual);
+			desyncs++;
+			cached = actual;
+		}
+	}
+
+	if (Skip(cached == (enabled ? 1u : 0u)))
+		return false;
+
+	if (enabled)
+		glEnable(Capabilities[index]);
+	else
+		glDisable(Capabilities[index]);
+	cached = enabled ? 1 : 0;
+	return true;
+}
+
+bool GLStateCache::CullFace(GLenum mode)
+{
+	cullFaceMode = Check("cull face mode", cullFaceMode, GL_CULL_FACE_MODE);
+	if (Skip(cullFaceMode == mode))
+		return false;
+
+	glCullFace(mode);
+	cullFaceMode = mode;
+	return true;
+}
+
+bool GLStateCache::DepthFunc(GLenum function)
+{
+	depthFunction = Check("depth function", depthFunction, GL_DEPTH_FUNC);
+	if (Skip(depthFunction == function))
+		return false;
+
+	glDepthFunc(function);
+	depthFunction = function;
+	return true;
+}
+
+bool GLStateCache::BlendFunc(GLenum source, GLenum destination)
+{
+	blendSource = Check("blend source", blendSource, GL_BLEND_SRC_RGB);
+	blendDestination = Check("blend destination", blendDestination, GL_BLEND_DST_RGB);
+	if (Skip(blendSource == source && blendDestination == destination))
+		return false;
+
+	glBlendFunc(source, destination);
+	blendSource = source;
+	blendDestination = destination;
+	return true;
+}
+
+void GLStateCache::DeleteBuffers(GLsizei count, const unsigned int* deleted)
+{
+	for (GLsizei i = 0; i < count; i++)
+	{
+		if (deleted[i] == 0)
+			continue;
+
+		// the element array binding is only reset in the bound vertex array, which is the one mirrored
+		for (auto& buffer : buffers)
+		{
+			if (buffer == deleted[i])
+				buffer = 0;
+		}
+	}
+	glDeleteBuffers(count, deleted);
+}
+
+void GLStateCache::DeleteVertexArrays(GLsizei count, const unsigned int* deleted)
+{
+	for (GLsizei i = 0; i < count; i++)
+	{
+		if (deleted[i] != 0 && deleted[i] == vertexArray)
+		{
+			vertexArray = 0;
+			buffers[ElementArrayBuffer] = Unknown;
+		}
+	}
+	glDeleteVertexArrays(count, deleted);
+}
+
+void GLStateCache::DeleteTextures(GLsizei count, const unsigned int* deleted)
+{
+	for (GLsizei i = 0; i < count; i++)
+	{
+		if (deleted[i] == 0)
+			continue;
+
+		for (auto& unit : textures)
+		{
+			for (auto& texture : unit)
+			{
+				if (texture == deleted[i])
+					texture = 0;
+			}
+		}
+	}
+	glDeleteTextures(count, deleted);
+}
+
+void GLStateCache::SetValidation(bool enabled)
+{
+	validating = enabled;
+}
+
+bool GLStateCache::IsValidating() const
+{
+	return validating;
+}
+
+bool GLStateCache::Validate()
+{
+	const bool wasValidating = validating;
+	const std::size_t desyncsBefore = desyncs;
+	validating = true;
+
+	program = Check("program", program, GL_CURRENT_PROGRAM);
+	vertexArray = Check("vertex array", vertexArray, GL_VERTEX_ARRAY_BINDING);
+	for (unsigned int i = 0; i < BufferTargetCount; i++)
+		buffers[i] = Check(BufferNames[i], buffers[i], BufferBindings[i]);
+	if (activeUnit != Unknown)
+		activeUnit = Check("active texture", GL_TEXTURE0 + activeUnit, GL_ACTIVE_TEXTURE) - GL_TEXTURE0;
+
+	for (unsigned int unit = 0; unit < MaxTextureUnits; unit++)
+	{
+		for (int target = 0; target < static_cast<int>(TextureTargetCount); target++)
+			textures[unit][target] = CheckTexture(unit, target, textures[unit][target]);
+	}
+
+	for (int i = 0; i < static_cast<int>(GLCapability::Count); i++)
+	{
+		const unsigned int actual = glIsEnabled(Capabilities[i]) ? 1 : 0;
+		if (capabilities[i] != Unknown && capabilities[i] != actual)
+		{
+			ReportDesync(CapabilityNames[i], capabilities[i], actual);
+			desyncs++;
+			capabilities[i] = actual;
+		}
+	}
+
+	cullFaceMode = Check("cull face mode", cullFaceMode, GL_CULL_FACE_MODE);
+	depthFunction = Check("depth function", depthFunction, GL_DEPTH_FUNC);
+	blendSource = Check("blend source", blendSource, GL_BLEND_SRC_RGB);
+	blendDestination = Check("blend destination", blendDestination, GL_BLEND_DST_RGB);
+
+	validating = wasValidating;
+	return desyncs == desyncsBefore;
+}
+
+std::size_t GLStateCache::GetDesyncCount() const
+{
+	return desyncs;
+}
+
+const GLStateCacheStats& GLStateCache::GetStats() const
+{
+	return stats;
+}
+
+void GLStateCache::ResetStats()
+{
+	stats = {};
+}
+
+bool GLStateCache::Skip(bool unchanged)
+{
+	if (unchanged)
+		stats.skipped++;
+	else
+		stats.calls++;
+	return unchanged;
+}
+
+unsigned int GLStateCache::Check(const char* name, unsigned int cached, GLenum query)
+{
+	if (!validating || cached == Unknown)
+		return cached;
+
+	GLint actual = 0;
+	glGetIntegerv(query, &actual);
+	if (static_cast<unsigned int>(actual) == cached)
+		return cached;
+
+	ReportDesync(name, cached, static_cast<unsigned int>(actual));
+	desyncs++;
+	return static_cast<unsigned int>(actual);
+}
+
+unsigned int GLStateCache::CheckTexture(unsigned int unit, int targetIndex, unsigned int cached)
+{
+	if (!validating || cached == Unknown)
+		return cached;
+
+	const unsigned int actual = QueryTexture(unit, targetIndex);
+	if (actual == cached)
+		return cached;
+
+	ReportDesync(std::string(TextureNames[targetIndex]) + " texture on unit " + std::to_string(unit), cached, actual);
+	desyncs++;
+	return actual;
+}
+
+unsigned int GLStateCache::QueryTexture(unsigned int unit, int targetIndex)
+{
+	// bindings can only be read from the active unit
+	GLint previousUnit = GL_TEXTURE0;
+	glGetIntegerv(GL_ACTIVE_TEXTURE, &previousUnit);
+	glActiveTexture(GL_TEXTURE0 + unit);
+
+	GLint texture = 0;
+	glGetIntegerv(TextureBindings[targetIndex], &texture);
+
+	glActiveTexture(static_cast<GLenum>(previousUnit));
+	return static_cast<unsigned int>(texture);
+}
@@ -0,0 +1,102 @@
+#pragma once
+#ifndef GL_STATE_CACHE_H
+#define GL_STATE_CACHE_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+
+// switches mirrored by the cache, other glEnable capabilities go to the driver directly
+enum class GLCapability
+{
+	DepthTest,
+	CullFace,
+	Blend,
+	Count
+};
+
+// calls made through the cache since the last reset, "skipped" ones would not have changed anything
+struct GLStateCacheStats
+{
+	std::size_t calls = 0;
+	std::size_t skipped = 0;
+};
+
+// Shadow of the GL state the renderer touches every frame: program, vertex array, buffer bindings,
+// texture units and the depth, cull and blend state. Calls that would set what is already set never reach the driver.
+// State changed behind its back desyncs the shadow, either route the change through the cache or call Invalidate.
+// The element array binding belongs to the vertex array, so it is forgotten whenever the vertex array changes.
+class GLStateCache
+{
+public:
+	static constexpr unsigned int MaxTextureUnits = 32;
+
+	// cache of the one context the application renders with
+	static GLStateCache& Default();
+
+	// forgets everything, the next call of each kind reaches the driver
+	void Invalidate();
+
+	// each returns whether the call reached the driver
+	bool UseProgram(unsigned int program);
+	bool BindVertexArray(unsigned int vertexArray);
+	bool BindBuffer(GLenum target, unsigned int buffer);
+	// always reaches the driver, like glBindBufferBase it also replaces the target's generic binding
+	void BindBufferBase(GLenum target, unsigned int index, unsigned int buffer);
+	bool ActiveTexture(unsigned int unit);
+	// binds to the active unit
+	bool BindTexture(GLenum target, unsigned int texture);
+	// binds to the given unit, which is only made active when the binding changes
+	bool BindTextureUnit(unsigned int unit, GLenum target, unsigned int texture);
+	bool SetCapability(GLCapability capability, bool enabled);
+	bool CullFace(GLenum mode);
+	bool DepthFunc(GLenum function);
+	bool BlendFunc(GLenum source, GLenum destination);
+
+	// deleting a bound object resets its bindings to 0, which the shadow has to follow before the name is reused
+	void DeleteBuffers(GLsizei count, const unsigned int* buffers);
+	void DeleteVertexArrays(GLsizei count, const unsigned int* vertexArrays);
+	void DeleteTextures(GLsizei count, const unsigned int* textures);
+
+	// while validating every call compares the shadow of the state it sets with glGet first,
+	// mismatches are reported as ERROR::GL_STATE_CACHE::DESYNC and counted
+	void SetValidation(bool enabled);
+	bool IsValidating() const;
+	// compares all known state with glGet, false on any mismatch. the active texture unit is left as it was
+	bool Validate();
+	std::size_t GetDesyncCount() const;
+
+	const GLStateCacheStats& GetStats() const;
+	void ResetStats();
+
+private:
+	GLStateCache();
+
+	static constexpr unsigned int Unknown = ~0u;
+	static constexpr unsigned int BufferTargetCount = 9;
+	static constexpr unsigned int TextureTargetCount = 2;
+
+	bool Skip(bool unchanged);
+
+	// the mirrored value after comparing it with the driver's, which wins on a mismatch
+	unsigned int Check(const char* name, unsigned int cached, GLenum query);
+	unsigned int CheckTexture(unsigned int unit, int targetIndex, unsigned int cached);
+	unsigned int QueryTexture(unsigned int unit, int targetIndex);
+
+	unsigned int program = Unknown;
+	unsigned int vertexArray = Unknown;
+	unsigned int buffers[BufferTargetCount];
+	unsigned int activeUnit = Unknown;
+	unsigned int textures[MaxTextureUnits][TextureTargetCount];
+	unsigned int capabilities[static_cast<int>(GLCapability::Count)];
+	unsigned int cullFaceMode = Unknown;
+	unsigned int depthFunction = Unknown;
+	unsigned int blendSource = Unknown;
+	unsigned int blendDestination = Unknown;
+
+	bool validating = false;
+	std::size_t desyncs = 0;
+	GLStateCacheStats stats;
+};
+
+#endif
@@ -0,0 +1,213 @@
+#include "GpuProfiler.h"
+
+#include <glad/glad.h>
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+GpuProfiler::~GpuProfiler()
+{
+	for (auto& frameQueries : frames)
+	{
+		if (!frameQueries.queries.empty())
+			glDeleteQueries(static_cast<GLsizei>(frameQueries.queries.size()), frameQueries.queries.data());
+	}
+}
+
+GpuProfiler::Scope::Scope(GpuProfiler* profiler, const char* name) : profiler(profiler)
+{
+	if (profiler)
+		scope = profiler->PushScope(name);
+}
+
+GpuProfiler::Scope::~Scope()
+{
+	if (profiler)
+		profiler->PopScope(scope);
+}
+
+void GpuProfiler::BeginFrame()
+{
+	if (!enabled || inFrame)
+		return;
+
+	FrameQueries& frameQueries = frames[frameNumber % FrameLatency];
+	if (frameQueries.pending)
+		Resolve(frameQueries);
+
+	frameQueries.usedQueries = 0;
+	frameQueries.scopes.clear();
+	frameQueries.frame = frameNumber;
+
+	inFrame = true;
+	depth = 0;
+
+	// the frame itself is the outermost scope
+	PushScope("Frame");
+}
+
+void GpuProfiler::EndFrame()
+{
+	if (!inFrame)
+		return;
+
+	PopScope(0);
+
+	frames[frameNumber % FrameLatency].pending = true;
+	inFrame = false;
+	frameNumber++;
+}
+
+void GpuProfiler::SetEnabled(bool enable)
+{
+	enabled = enable;
+}
+
+bool GpuProfiler::IsEnabled() const
+{
+	return enabled;
+}
+
+const GpuFrameTimes& GpuProfiler::GetLastFrame() const
+{
+	return lastFrame;
+}
+
+std::size_t GpuProfiler::GetDroppedFrameCount() const
+{
+	return droppedFrames;
+}
+
+std::size_t GpuProfiler::IssueTimestamp()
+{
+	FrameQueries& frameQueries = frames[frameNumber % FrameLatency];
+	if (frameQueries.usedQueries == frameQueries.queries.size())
+	{
+		// the pool only grows, so after the first frames no query objects are created anymore
+		frameQueries.queries.emplace_back(0);
+		glGenQueries(1, &frameQueries.queries.back());
+	}
+
+	const std::size_t query = frameQueries.usedQueries++;
+	glQueryCounter(frameQueries.queries[query], GL_TIMESTAMP);
+	return query;
+}
+
+std::size_t GpuProfiler::PushScope(const char* name)
+{
+	if (!inFrame)
+		return 0;
+
+	FrameQueries& frameQueries = frames[frameNumber % FrameLatency];
+	frameQueries.scopes.push_back({ name, depth++, IssueTimestamp(), 0 });
+	return frameQueries.scopes.size() - 1;
+}
+
+void GpuProfiler::PopScope(std::size_t scope)
+{
+	if (!inFrame)
+		return;
+
+	FrameQueries& frameQueries = frames[frameNumber % FrameLatency];
+	frameQueries.scopes[scope].endQuery = IssueTimestamp();
+	depth--;
+}
+
+void GpuProfiler::Resolve(FrameQueries& frameQueries)
+{
+	frameQueries.pending = false;
+
+	// timestamps complete in order, so the last one being available means all of them are
+	GLint available = 0;
+	glGetQueryObjectiv(frameQueries.queries[frameQueries.usedQueries - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+	if (!available)
+	{
+		droppedFrames++;
+		return;
+	}
+
+	std::vector<GLuint64> timestamps(frameQueries.usedQueries);
+	for (std::size_t i = 0; i < frameQueries.usedQueries; i++)
+		glGetQueryObjectui64v(frameQueries.queries[i], GL_QUERY_RESULT, &timestamps[i]);
+
+	const GLuint64 frameStart = timestamps[frameQueries.scopes[0].beginQuery];
+
+	GpuFrameTimes result;
+	result.frame = frameQueries.frame;
+	result.total = static_cast<double>(timestamps[frameQueries.scopes[0].endQuery] - frameStart) / 1.0e6;
+	for (std::size_t i = 1; i < frameQueries.scopes.size(); i++)
+	{
+		const PendingScope& scope = frameQueries.scopes[i];
+		GpuPassTime& pass = result.passes.emplace_back();
+		pass.name = scope.name;
+		pass.depth = scope.depth - 1;
+		pass.start = static_cast<double>(timestamps[scope.beginQuery] - frameStart) / 1.0e6;
+		pass.duration = static_cast<double>(timestamps[scope.endQuery] - timestamps[scope.beginQuery]) / 1.0e6;
+	}
+
+	lastFrame = result;
+	history.emplace_back(std::move(result));
+	if (history.size() > HistorySize)
+		history.pop_front();
+}
+
+bool GpuProfiler::ExportCsv(const std::string& path) const
+{
+	std::ofstream out(path);
+	if (!out)
+		return false;
+
+	out << "frame,pass,depth,start_ms,duration_ms\n";
+	for (const auto& frame : history)
+	{
+		out << frame.frame << ",Frame,0,0," << frame.total << "\n";
+		for (const auto& pass : frame.passes)
+			out << frame.frame << "," << pass.name << "," << pass.depth + 1 << "," << pass.start << "," << pass.duration << "\n";
+	}
+
+	return static_cast<bool>(out);
+}
+
+void GpuProfiler::DrawFlameView()
+{
+	ImGui::Text("GPU frame %.3f ms (%zu frames dropped)", lastFrame.total, droppedFrames);
+
+	const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+	int maxDepth = 0;
+	for (const auto& pass : lastFrame.passes)
+		maxDepth = std::max(maxDepth, pass.depth);
+
+	const ImVec2 origin = ImGui::GetCursorScreenPos();
+	const float width = std::max(ImGui::GetContentRegionAvail().x, 1.0f);
+	const float height = rowHeight * static_cast<float>(maxDepth + 1);
+	const double scale = lastFrame.total > 0.0 ? width / lastFrame.total : 0.0;
+
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	for (std::size_t i = 0; i < lastFrame.passes.size(); i++)
+	{
+		const GpuPassTime& pass = lastFrame.passes[i];
+		const ImVec2 min(origin.x + static_cast<float>(pass.start * scale), origin.y + rowHeight * static_cast<float>(pass.depth));
+		const ImVec2 max(std::max(min.x + 1.0f, origin.x + static_cast<float>((pass.start + pass.duration) * scale)), min.y + rowHeight - 1.0f);
+
+		// a different hue for every pass, stable from frame to frame
+		const ImU32 color = IM_COL32(80 + (i * 67) % 160, 80 + (i * 131) % 160, 160, 255);
+		drawList->AddRectFilled(min, max, color);
+
+		drawList->PushClipRect(min, max, true);
+		drawList->AddText(ImVec2(min.x + 2.0f, min.y + 2.0f), IM_COL32(255, 255, 255, 255), pass.name.c_str());
+		drawList->PopClipRect();
+
+		if (ImGui::IsMouseHoveringRect(min, max))
+			ImGui::SetTooltip("%s: %.3f ms", pass.name.c_str(), pass.duration);
+	}
+	ImGui::Dummy(ImVec2(width, height));
+
+	for (const auto& pass : lastFrame.passes)
+		ImGui::Text("%*s%s: %.3f ms", pass.depth * 2, "", pass.name.c_str(), pass.duration);
+
+	if (ImGui::Button("Export GPU profile CSV") && !ExportCsv("gpu_profile.csv"))
+		std::cout << "ERROR::GPU_PROFILER::CSV_NOT_WRITTEN" << std::endl;
+}
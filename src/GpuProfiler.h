@@ -0,0 +1,107 @@
+#pragma once
+#ifndef GPU_PROFILER_H
+#define GPU_PROFILER_H
+
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+// one timed scope of a resolved frame, times in milliseconds from the start of the frame
+struct GpuPassTime
+{
+	std::string name;
+	int depth = 0;
+	double start = 0.0;
+	double duration = 0.0;
+};
+
+struct GpuFrameTimes
+{
+	unsigned long long frame = 0;
+	double total = 0.0;
+	std::vector<GpuPassTime> passes;
+};
+
+// Measures GPU time of nested scopes with GL_TIMESTAMP queries.
+// The queries of a frame are read FrameLatency frames later, once the GPU is done with them, so reading never stalls;
+// a frame whose queries are still not available by then is dropped instead of waited for.
+class GpuProfiler
+{
+public:
+	static constexpr unsigned int FrameLatency = 3;
+	// resolved frames kept for the CSV export
+	static constexpr std::size_t HistorySize = 600;
+
+	GpuProfiler() = default;
+	~GpuProfiler();
+
+	GpuProfiler(const GpuProfiler&) = delete;
+	GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+	// times the GPU work issued between its construction and destruction, does nothing without a profiler
+	class Scope
+	{
+	public:
+		Scope(GpuProfiler* profiler, const char* name);
+		~Scope();
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		GpuProfiler* profiler;
+		std::size_t scope = 0;
+	};
+
+	void BeginFrame();
+	void EndFrame();
+
+	void SetEnabled(bool enable);
+	bool IsEnabled() const;
+
+	// latest frame whose queries were read back, empty until FrameLatency frames were profiled
+	const GpuFrameTimes& GetLastFrame() const;
+	std::size_t GetDroppedFrameCount() const;
+
+	// frame, pass, depth, start and duration in milliseconds of every frame in the history
+	bool ExportCsv(const std::string& path) const;
+
+	// bars of the last frame laid out over time, nested scopes below their parents, needs an ImGui window in progress
+	void DrawFlameView();
+
+private:
+	struct PendingScope
+	{
+		const char* name;
+		int depth;
+		std::size_t beginQuery;
+		std::size_t endQuery;
+	};
+
+	struct FrameQueries
+	{
+		std::vector<unsigned int> queries;
+		std::size_t usedQueries = 0;
+		std::vector<PendingScope> scopes;
+		unsigned long long frame = 0;
+		bool pending = false;
+	};
+
+	std::size_t IssueTimestamp();
+	std::size_t PushScope(const char* name);
+	void PopScope(std::size_t scope);
+	void Resolve(FrameQueries& frameQueries);
+
+	FrameQueries frames[FrameLatency];
+	unsigned long long frameNumber = 0;
+	int depth = 0;
+	bool inFrame = false;
+	bool enabled = true;
+
+	GpuFrameTimes lastFrame;
+	std::deque<GpuFrameTimes> history;
+	std::size_t droppedFrames = 0;
+};
+
+#endif
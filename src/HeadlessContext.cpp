@@ -0,0 +1,158 @@
+#include "HeadlessContext.h"
+
+#include <cstring>
+#include <iostream>
+
+#ifdef OPENGLPAG_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+namespace
+{
+	bool HasExtension(const char* extensions, const char* name)
+	{
+		if (extensions == nullptr)
+			return false;
+
+		// extension strings are space separated, so whole names have to be matched
+		const std::size_t length = std::strlen(name);
+		for (const char* found = std::strstr(extensions, name); found != nullptr; found = std::strstr(found + length, name))
+		{
+			const bool startsName = found == extensions || found[-1] == ' ';
+			const bool endsName = found[length] == ' ' || found[length] == '\0';
+			if (startsName && endsName)
+				return true;
+		}
+		return false;
+	}
+
+	EGLDisplay OpenDisplay()
+	{
+		const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+		// the surfaceless platform needs neither a display server nor a GPU
+		if (HasExtension(clientExtensions, "EGL_MESA_platform_surfaceless") && HasExtension(clientExtensions, "EGL_EXT_platform_base"))
+		{
+			auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+			if (getPlatformDisplay != nullptr)
+			{
+				EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+				if (display != EGL_NO_DISPLAY)
+					return display;
+			}
+		}
+
+		return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+	}
+}
+
+HeadlessContext::~HeadlessContext()
+{
+	if (display == nullptr)
+		return;
+
+	eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (context != nullptr)
+		eglDestroyContext(display, context);
+	if (surface != nullptr)
+		eglDestroySurface(display, surface);
+	eglTerminate(display);
+}
+
+bool HeadlessContext::Create()
+{
+	EGLDisplay eglDisplay = OpenDisplay();
+	if (eglDisplay == EGL_NO_DISPLAY || !eglInitialize(eglDisplay, nullptr, nullptr))
+	{
+		std::cout << "ERROR::HEADLESS::NO_EGL_DISPLAY" << std::endl;
+		return false;
+	}
+	display = eglDisplay;
+
+	if (!eglBindAPI(EGL_OPENGL_API))
+	{
+		std::cout << "ERROR::HEADLESS::NO_DESKTOP_GL" << std::endl;
+		return false;
+	}
+
+	// rendering goes into a framebuffer object, a surface is only created when the driver insists on one
+	const bool surfaceless = HasExtension(eglQueryString(eglDisplay, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_NONE
+	};
+
+	EGLConfig config;
+	EGLint configCount = 0;
+	if (!eglChooseConfig(eglDisplay, configAttributes, &config, 1, &configCount) || configCount == 0)
+	{
+		std::cout << "ERROR::HEADLESS::NO_MATCHING_EGL_CONFIG" << std::endl;
+		return false;
+	}
+
+	if (!surfaceless)
+	{
+		const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+		surface = eglCreatePbufferSurface(eglDisplay, config, pbufferAttributes);
+		if (surface == EGL_NO_SURFACE)
+		{
+			surface = nullptr;
+			std::cout << "ERROR::HEADLESS::PBUFFER_CREATION_FAILED" << std::endl;
+			return false;
+		}
+	}
+
+	// GL 4.3 core, the same version the window asks GLFW for
+	const EGLint contextAttributes[] = {
+		EGL_CONTEXT_MAJOR_VERSION, 4,
+		EGL_CONTEXT_MINOR_VERSION, 3,
+		EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+		EGL_NONE
+	};
+
+	context = eglCreateContext(eglDisplay, config, EGL_NO_CONTEXT, contextAttributes);
+	if (context == EGL_NO_CONTEXT)
+	{
+		context = nullptr;
+		std::cout << "ERROR::HEADLESS::GL_4_3_CONTEXT_CREATION_FAILED" << std::endl;
+		return false;
+	}
+
+	EGLSurface eglSurface = surface != nullptr ? surface : EGL_NO_SURFACE;
+	if (!eglMakeCurrent(eglDisplay, eglSurface, eglSurface, context))
+	{
+		std::cout << "ERROR::HEADLESS::MAKE_CURRENT_FAILED" << std::endl;
+		return false;
+	}
+
+	return true;
+}
+
+GLADloadproc HeadlessContext::GetLoader()
+{
+	return reinterpret_cast<GLADloadproc>(eglGetProcAddress);
+}
+
+#else
+
+HeadlessContext::~HeadlessContext() = default;
+
+bool HeadlessContext::Create()
+{
+	std::cout << "ERROR::HEADLESS::BUILT_WITHOUT_EGL" << std::endl;
+	return false;
+}
+
+GLADloadproc HeadlessContext::GetLoader()
+{
+	return nullptr;
+}
+
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+#ifndef HEADLESS_CONTEXT_H
+#define HEADLESS_CONTEXT_H
+
+#include <glad/glad.h>
+
+// OpenGL 4.3 core context without any window, created through EGL.
+// Mesa's surfaceless platform is preferred, so no display server or GPU is needed, with a pbuffer as the fallback.
+// Only available when the build found EGL (OPENGLPAG_HAS_EGL), otherwise Create always fails.
+class HeadlessContext
+{
+public:
+	HeadlessContext() = default;
+	~HeadlessContext();
+
+	HeadlessContext(const HeadlessContext&) = delete;
+	HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+	// creates the context and makes it current, prints the reason and returns false on failure
+	bool Create();
+
+	// loader for gladLoadGLLoader and InitGLExtensions
+	static GLADloadproc GetLoader();
+
+private:
+	// EGL handles, kept opaque so EGL headers stay out of the rest of the code
+	void* display = nullptr;
+	void* surface = nullptr;
+	void* context = nullptr;
+};
+
+#endif
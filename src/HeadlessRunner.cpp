@@ -0,0 +1,392 @@
+#include "HeadlessRunner.h"
+
+#include "Camera.h"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include "HeadlessContext.h"
+#include "OffscreenFramebuffer.h"
+#include "PngWriter.h"
+#include "Scene.h"
+#include "ScriptedCamera.h"
+
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+	void PrintUsage()
+	{
+		std::cout << "usage: OpenGLPAG --headless [--frames N] [--size WxH] [--capture F1,F2,...] [--output DIR]\n"
+			"                  [--reference DIR] [--tolerance N] [--max-diff FRACTION] [--lamps N] [--culling none|cpu|gpu]\n"
+			"                  [--upload-mode subdata|ring] [--texture-binding bound|bindless] [--texture-arrays on|off] [--validate-gl-state]\n"
+			"                  [--validate-clusters] [--cluster-workers N] [--expect-static-instances]" << std::endl;
+	}
+
+	std::string FrameFileName(int frame)
+	{
+		char name[32];
+		std::snprintf(name, sizeof(name), "frame_%04d.png", frame);
+		return name;
+	}
+
+	// returns false when the reference is missing or too many pixels differ
+	bool CompareWithReference(const std::string& referencePath, const std::vector<unsigned char>& pixels, int width, int height, const HeadlessOptions& options)
+	{
+		int referenceWidth = 0, referenceHeight = 0, channels = 0;
+		unsigned char* reference = stbi_load(referencePath.c_str(), &referenceWidth, &referenceHeight, &channels, 4);
+		if (reference == nullptr)
+		{
+			std::cout << "ERROR::HEADLESS::REFERENCE_NOT_LOADED " << referencePath << std::endl;
+			return false;
+		}
+
+		if (referenceWidth != width || referenceHeight != height)
+		{
+			std::cout << "ERROR::HEADLESS::REFERENCE_SIZE_MISMATCH " << referencePath << std::endl;
+			stbi_image_free(reference);
+			return false;
+		}
+
+		std::size_t differentPixels = 0;
+		int maxDifference = 0;
+		for (std::size_t pixel = 0; pixel < static_cast<std::size_t>(width) * height; pixel++)
+		{
+			int pixelDifference = 0;
+			for (std::size_t channel = 0; channel < 4; channel++)
+				pixelDifference = std::max(pixelDifference, std::abs(pixels[pixel * 4 + channel] - reference[pixel * 4 + channel]));
+
+			maxDifference = std::max(maxDifference, pixelDifference);
+			if (pixelDifference > options.tolerance)
+				differentPixels++;
+		}
+		stbi_image_free(reference);
+
+		const double differentFraction = static_cast<double>(differentPixels) / (static_cast<double>(width) * height);
+		std::cout << referencePath << ": " << differentPixels << " pixels differ, max channel difference " << maxDifference << std::endl;
+		return differentFraction <= options.maxDifferentPixels;
+	}
+}
+
+bool ParseInt(const std::string& text, int& value)
+{
+	char* end = nullptr;
+	errno = 0;
+	const long parsed = std::strtol(text.c_str(), &end, 10);
+	if (text.empty() || *end != '\0' || errno == ERANGE || parsed < INT_MIN || parsed > INT_MAX)
+		return false;
+
+	value = static_cast<int>(parsed);
+	return true;
+}
+
+bool ParseDouble(const std::string& text, double& value)
+{
+	char* end = nullptr;
+	value = std::strtod(text.c_str(), &end);
+	return !text.empty() && *end == '\0' && std::isfinite(value);
+}
+
+bool ParseSize(const std::string& text, int& width, int& height)
+{
+	const std::size_t separator = text.find('x');
+	if (separator == std::string::npos)
+		return false;
+
+	return ParseInt(text.substr(0, separator), width) && ParseInt(text.substr(separator + 1), height) && width > 0 && height > 0;
+}
+
+bool IsHeadlessRun(int argc, char** argv)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		if (std::strcmp(argv[i], "--headless") == 0)
+			return true;
+	}
+	return false;
+}
+
+bool ParseHeadlessOptions(int argc, char** argv, HeadlessOptions& options)
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string argument = argv[i];
+		if (argument == "--headless")
+			continue;
+		if (argument == "--validate-gl-state")
+		{
+			options.validateGLState = true;
+			continue;
+		}
+		if (argument == "--validate-clusters")
+		{
+			options.validateClusters = true;
+			continue;
+		}
+		if (argument == "--expect-static-instances")
+		{
+			options.expectStaticInstances = true;
+			continue;
+		}
+
+		if (i + 1 >= argc)
+		{
+			PrintUsage();
+			return false;
+		}
+		const std::string value = argv[++i];
+
+		bool valid = true;
+		if (argument == "--frames")
+		{
+			valid = ParseInt(value, options.frames) && options.frames > 0;
+		}
+		else if (argument == "--size")
+		{
+			valid = ParseSize(value, options.width, options.height);
+		}
+		else if (argument == "--capture")
+		{
+			// checked against --frames once all arguments are read, it may come later
+			options.captureFrames.clear();
+			std::stringstream frames(value);
+			std::string frame;
+			while (valid && std::getline(frames, frame, ','))
+			{
+				int index = 0;
+				valid = ParseInt(frame, index) && index >= 0;
+				options.captureFrames.emplace_back(index);
+			}
+			valid = valid && !options.captureFrames.empty();
+		}
+		else if (argument == "--output")
+			options.outputDirectory = value;
+		else if (argument == "--reference")
+			options.referenceDirectory = value;
+		else if (argument == "--tolerance")
+			valid = ParseInt(value, options.tolerance) && options.tolerance >= 0 && options.tolerance <= 255;
+		else if (argument == "--max-diff")
+			valid = ParseDouble(value, options.maxDifferentPixels) && options.maxDifferentPixels >= 0.0 && options.maxDifferentPixels <= 1.0;
+		else if (argument == "--lamps")
+		{
+			int lamps = 0;
+			valid = ParseInt(value, lamps) && lamps >= 0 && static_cast<std::size_t>(lamps) <= MaxStreetLamps;
+			options.streetLamps = static_cast<std::size_t>(std::max(lamps, 0));
+		}
+		else if (argument == "--culling")
+		{
+			if (value == "none")
+				options.cullingMode = CullingMode::None;
+			else if (value == "cpu")
+				options.cullingMode = CullingMode::Cpu;
+			else if (value == "gpu")
+				options.cullingMode = CullingMode::Gpu;
+			else
+				valid = false;
+		}
+		else if (argument == "--upload-mode")
+		{
+			if (value == "subdata")
+				options.uploadMode = InstanceUploadMode::BufferSubData;
+			else if (value == "ring")
+				options.uploadMode = InstanceUploadMode::PersistentRing;
+			else
+				valid = false;
+		}
+		else if (argument == "--texture-binding")
+		{
+			if (value == "bound")
+				options.textureBinding = TextureBinding::Bound;
+			else if (value == "bindless")
+				options.textureBinding = TextureBinding::Bindless;
+			else
+				valid = false;
+		}
+		else if (argument == "--cluster-workers")
+			valid = ParseInt(value, options.clusterWorkers) && options.clusterWorkers > 0;
+		else if (argument == "--texture-arrays")
+		{
+			valid = value == "on" || value == "off";
+			options.textureArrays = value == "on";
+		}
+		else
+			valid = false;
+
+		if (!valid)
+		{
+			std::cout << "ERROR::HEADLESS::BAD_ARGUMENT " << argument << " " << value << std::endl;
+			PrintUsage();
+			return false;
+		}
+	}
+
+	for (const int frame : options.captureFrames)
+	{
+		if (frame >= options.frames)
+		{
+			std::cout << "ERROR::HEADLESS::CAPTURE_OUT_OF_RANGE frame " << frame << " of " << options.frames << std::endl;
+			PrintUsage();
+			return false;
+		}
+	}
+
+	if (options.expectStaticInstances && options.cullingMode == CullingMode::Cpu)
+	{
+		std::cout << "ERROR::HEADLESS::STATIC_INSTANCES_NEED_CULLING none or gpu" << std::endl;
+		PrintUsage();
+		return false;
+	}
+
+	return true;
+}
+
+HeadlessResult RunHeadless(const HeadlessOptions& options)
+{
+	HeadlessContext context;
+	if (!context.Create())
+		return HeadlessResult::NoContext;
+
+	if (!gladLoadGLLoader(HeadlessContext::GetLoader()))
+	{
+		std::cout << "ERROR::HEADLESS::GL_LOADER_FAILED" << std::endl;
+		return HeadlessResult::NoContext;
+	}
+	InitGLExtensions(HeadlessContext::GetLoader());
+
+	std::cout << "Rendering headless on " << glGetString(GL_RENDERER) << ", " << glGetString(GL_VERSION) << std::endl;
+
+	// the window's default framebuffer is replaced by one of our own
+	OffscreenFramebuffer framebuffer(options.width, options.height);
+	if (!framebuffer.IsComplete())
+	{
+		std::cout << "ERROR::HEADLESS::FRAMEBUFFER_INCOMPLETE" << std::endl;
+		return HeadlessResult::NoContext;
+	}
+
+	GLStateCache& glState = GLStateCache::Default();
+	glState.SetValidation(options.validateGLState);
+
+	HeadlessResult result = HeadlessResult::Success;
+	{
+		SceneParams sceneParams;
+		sceneParams.textureArrays = options.textureArrays;
+		Scene scene(sceneParams);
+		// every frame has to look the same on every run
+		scene.FinishLoading();
+		scene.SetCullingMode(options.cullingMode);
+		scene.SetInstanceUploadMode(options.uploadMode);
+		if (options.uploadMode == InstanceUploadMode::PersistentRing && !InstanceRingBuffer::IsPersistentMappingSupported())
+			std::cout << "GL_ARB_buffer_storage is not supported, the instance ring orphans its buffer" << std::endl;
+		scene.SetStreetLampCount(options.streetLamps);
+		if (options.clusterWorkers > 0)
+			scene.GetLightClusters().SetWorkerCount(static_cast<unsigned int>(options.clusterWorkers));
+		scene.SetTextureBinding(options.textureBinding);
+		if (options.textureBinding == TextureBinding::Bindless && !BindlessTextures::IsSupported())
+			std::cout << "GL_ARB_bindless_texture is not supported, textures are bound" << std::endl;
+
+		Camera camera;
+
+		std::vector<int> captureFrames = options.captureFrames;
+		if (captureFrames.empty())
+			captureFrames.emplace_back(options.frames - 1);
+
+		std::error_code error;
+		std::filesystem::create_directories(options.outputDirectory, error);
+
+		std::vector<unsigned char> pixels;
+
+		// the ring writes every region once before it holds all instances
+		const int settleFrames = options.uploadMode == InstanceUploadMode::PersistentRing ? static_cast<int>(InstanceRingBuffer::RegionCount) : 1;
+
+		const auto start = std::chrono::steady_clock::now();
+
+		for (int frame = 0; frame < options.frames; frame++)
+		{
+			PlaceScriptedCamera(camera, frame, options.frames);
+
+			scene.Update(static_cast<float>(frame) * ScriptedFrameTime);
+
+			framebuffer.Bind();
+			scene.Render(camera, options.width, options.height);
+
+			const GLenum glError = glGetError();
+			if (glError != GL_NO_ERROR)
+			{
+				std::cout << "ERROR::HEADLESS::GL_ERROR 0x" << std::hex << glError << std::dec << " in frame " << frame << std::endl;
+				result = HeadlessResult::GLError;
+				break;
+			}
+
+			// desyncs are also found by the checks made while the frame was drawn
+			if (options.validateGLState && (!glState.Validate() || glState.GetDesyncCount() > 0))
+			{
+				std::cout << "ERROR::HEADLESS::GL_STATE_DESYNC in frame " << frame << std::endl;
+				result = HeadlessResult::StateDesync;
+				break;
+			}
+
+			if (options.validateClusters)
+			{
+				const std::size_t mismatches = scene.GetLightClusters().Validate();
+				if (mismatches > 0)
+				{
+					std::cout << "ERROR::HEADLESS::CLUSTER_MISMATCH " << mismatches << " clusters in frame " << frame << std::endl;
+					result = HeadlessResult::ClusterMismatch;
+					break;
+				}
+			}
+
+			if (options.expectStaticInstances && frame >= settleFrames)
+			{
+				const InstanceUploadStats& uploadStats = InstancedObject::GetFrameUploadStats();
+				if (uploadStats.bytes > 0 || uploadStats.scannedInstances > 0)
+				{
+					std::cout << "ERROR::HEADLESS::STATIC_INSTANCES_UPLOADED " << uploadStats.scannedInstances << " instances scanned, "
+						<< uploadStats.bytes << " bytes uploaded in frame " << frame << std::endl;
+					result = HeadlessResult::InstanceUpload;
+					break;
+				}
+			}
+
+			if (std::find(captureFrames.begin(), captureFrames.end(), frame) == captureFrames.end())
+				continue;
+
+			framebuffer.ReadPixels(pixels);
+
+			const std::string fileName = FrameFileName(frame);
+			const std::string outputPath = (std::filesystem::path(options.outputDirectory) / fileName).string();
+			if (!WritePng(outputPath, options.width, options.height, pixels.data()))
+			{
+				std::cout << "ERROR::HEADLESS::PNG_NOT_WRITTEN " << outputPath << std::endl;
+				result = HeadlessResult::WriteFailed;
+				break;
+			}
+
+			if (!options.referenceDirectory.empty())
+			{
+				const std::string referencePath = (std::filesystem::path(options.referenceDirectory) / fileName).string();
+				if (!CompareWithReference(referencePath, pixels, options.width, options.height, options))
+					result = HeadlessResult::ReferenceMismatch;
+			}
+		}
+
+		glFinish();
+		const double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		std::cout << "Rendered " << options.frames << " frames in " << milliseconds << " ms ("
+			<< milliseconds / options.frames << " ms/frame)" << std::endl;
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	return result;
+}
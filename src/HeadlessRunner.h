@@ -0,0 +1,83 @@
+#pragma once
+#ifndef HEADLESS_RUNNER_H
+#define HEADLESS_RUNNER_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "BindlessTextures.h"
+#include "Object.h"
+
+// process exit codes of a headless run, so scripts can tell the failures apart
+enum class HeadlessResult
+{
+	Success = 0,
+	BadArguments = 1,
+	// no EGL, or the driver can't create a GL 4.3 core context
+	NoContext = 2,
+	// glGetError reported an error after a frame
+	GLError = 3,
+	WriteFailed = 4,
+	// a captured frame differs from its reference image, or the reference is missing
+	ReferenceMismatch = 5,
+	// with state validation, the GLStateCache disagreed with the driver
+	StateDesync = 6,
+	// with cluster validation, a light list differed from the brute force test
+	ClusterMismatch = 7,
+	// with --expect-static-instances, instances were scanned or uploaded although none of them moved
+	InstanceUpload = 8
+};
+
+// upper bound of --lamps, far above the inspector's largest amount
+constexpr std::size_t MaxStreetLamps = 1000000;
+
+struct HeadlessOptions
+{
+	int frames = 120;
+	int width = 1280;
+	int height = 720;
+	// frames written to PNG, the last frame when empty
+	std::vector<int> captureFrames;
+	std::string outputDirectory = "capture";
+	// directory with frame_NNNN.png images the captures are compared against, no comparison when empty
+	std::string referenceDirectory;
+	// largest per channel difference still treated as equal
+	int tolerance = 2;
+	// fraction of pixels allowed to differ by more than the tolerance
+	double maxDifferentPixels = 0.001;
+	std::size_t streetLamps = 0;
+	CullingMode cullingMode = CullingMode::Cpu;
+	InstanceUploadMode uploadMode = InstanceUploadMode::BufferSubData;
+	// both produce the same images, bindless falls back to bound where it isn't supported
+	TextureBinding textureBinding = TextureBinding::Bound;
+	// packs textures into texture arrays, which must not change the images either
+	bool textureArrays = true;
+	// checks the GLStateCache against glGet on every call and after every frame
+	bool validateGLState = false;
+	// compares the light clusters with a brute force test after every frame
+	bool validateClusters = false;
+	// threads building the light clusters, 0 keeps the scene's choice
+	int clusterWorkers = 0;
+	// fails the run when an instanced object looks at or uploads its instances once the first frame wrote them,
+	// needs culling none or gpu since CPU culling uploads the visible instances every frame
+	bool expectStaticInstances = false;
+};
+
+// command line numbers shared with bench, the whole text has to be a number, unlike atoi which reads "abc" as 0
+bool ParseInt(const std::string& text, int& value);
+bool ParseDouble(const std::string& text, double& value);
+// WxH with both sides positive, nothing may follow the height
+bool ParseSize(const std::string& text, int& width, int& height);
+
+// true when the command line asks for --headless
+bool IsHeadlessRun(int argc, char** argv);
+
+// fills options from the command line, prints the usage and returns false on unknown or malformed arguments
+bool ParseHeadlessOptions(int argc, char** argv, HeadlessOptions& options);
+
+// renders options.frames frames of the scene from a scripted camera into an offscreen framebuffer,
+// with a fixed time step, so the same options always produce the same images
+HeadlessResult RunHeadless(const HeadlessOptions& options);
+
+#endif
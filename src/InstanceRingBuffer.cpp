@@ -0,0 +1,174 @@
+#include "InstanceRingBuffer.h"
+
+#include "GLStateCache.h"
+
+#include <iostream>
+
+namespace
+{
+	// regions start at offsets usable for every kind of buffer binding
+	constexpr std::size_t RegionAlignment = 256;
+
+	// one second, waiting longer means the GPU is hung anyway
+	constexpr GLuint64 FenceTimeout = 1000000000;
+}
+
+InstanceRingBuffer::InstanceRingBuffer(std::size_t regionSize) : regionSize(regionSize)
+{
+	persistent = IsPersistentMappingSupported();
+
+	glGenBuffers(1, &buffer);
+	GLStateCache::Default().BindBuffer(GL_ARRAY_BUFFER, buffer);
+
+	if (persistent)
+	{
+		regionStride = (regionSize + RegionAlignment - 1) / RegionAlignment * RegionAlignment;
+
+		const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, regionStride * RegionCount, nullptr, flags);
+		mappedMemory = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, regionStride * RegionCount, flags));
+
+		// start on the last region, so the first write lands in region 0
+		currentRegion = RegionCount - 1;
+	}
+	else
+	{
+		regionStride = regionSize;
+		stagingMemory.resize(regionSize);
+		glBufferData(GL_ARRAY_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+	}
+
+	GLStateCache::Default().BindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+InstanceRingBuffer::~InstanceRingBuffer()
+{
+	for (auto& fence : fences)
+	{
+		if (fence != nullptr)
+			glDeleteSync(fence);
+	}
+
+	if (mappedMemory != nullptr)
+	{
+		GLStateCache::Default().BindBuffer(GL_ARRAY_BUFFER, buffer);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		GLStateCache::Default().BindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	GLStateCache::Default().DeleteBuffers(1, &buffer);
+	if (fallbackBuffer != 0)
+		GLStateCache::Default().DeleteBuffers(1, &fallbackBuffer);
+}
+
+bool InstanceRingBuffer::IsPersistentMappingSupported()
+{
+	return glBufferStorage != nullptr;
+}
+
+void* InstanceRingBuffer::BeginWrite()
+{
+	if (!persistent)
+		return stagingMemory.data();
+
+	currentRegion = (currentRegion + 1) % RegionCount;
+	fallingBack = !WaitForRegion(currentRegion);
+
+	if (!fallingBack)
+		return mappedMemory + GetRegionOffset();
+
+	// the region may still be read, so this write is orphaned like without buffer storage
+	if (fallbackBuffer == 0)
+		glGenBuffers(1, &fallbackBuffer);
+	stagingMemory.resize(regionSize);
+
+	return stagingMemory.data();
+}
+
+void InstanceRingBuffer::EndWrite()
+{
+	if (!persistent)
+		OrphanAndUpload(buffer);
+	else if (fallingBack)
+		OrphanAndUpload(fallbackBuffer);
+
+	// otherwise the coherent mapping makes the writes visible on their own
+}
+
+void InstanceRingBuffer::FenceCurrentRegion()
+{
+	// the draws read the fallback buffer, the region's pending fence still guards it
+	if (!persistent || fallingBack)
+		return;
+
+	GLsync& fence = fences[currentRegion];
+	if (fence != nullptr)
+		glDeleteSync(fence);
+
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool InstanceRingBuffer::IsPersistent() const
+{
+	return persistent;
+}
+
+bool InstanceRingBuffer::IsFallingBack() const
+{
+	return fallingBack;
+}
+
+unsigned int InstanceRingBuffer::GetBuffer() const
+{
+	return fallingBack ? fallbackBuffer : buffer;
+}
+
+unsigned int InstanceRingBuffer::GetRegionIndex() const
+{
+	return currentRegion;
+}
+
+unsigned int InstanceRingBuffer::GetRegionCount() const
+{
+	return persistent ? RegionCount : 1;
+}
+
+std::size_t InstanceRingBuffer::GetRegionSize() const
+{
+	return regionSize;
+}
+
+std::size_t InstanceRingBuffer::GetRegionOffset() const
+{
+	return fallingBack ? 0 : currentRegion * regionStride;
+}
+
+bool InstanceRingBuffer::WaitForRegion(unsigned int region)
+{
+	GLsync& fence = fences[region];
+	if (fence == nullptr)
+		return true;
+
+	const GLenum result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, FenceTimeout);
+	if (result == GL_TIMEOUT_EXPIRED || result == GL_WAIT_FAILED)
+	{
+		// the fence is kept, the region is waited for again the next time around
+		if (!fallingBack)
+			std::cout << "ERROR::INSTANCE_RING_BUFFER::" << (result == GL_WAIT_FAILED ? "WAIT_FAILED" : "WAIT_TIMEOUT")
+				<< " region " << region << ", orphaning instead" << std::endl;
+		return false;
+	}
+
+	glDeleteSync(fence);
+	fence = nullptr;
+	return true;
+}
+
+void InstanceRingBuffer::OrphanAndUpload(unsigned int target)
+{
+	// orphaning hands the old storage to the driver, so the GPU can keep reading it while we fill a new one
+	GLStateCache::Default().BindBuffer(GL_ARRAY_BUFFER, target);
+	glBufferData(GL_ARRAY_BUFFER, regionSize, nullptr, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, regionSize, stagingMemory.data());
+	GLStateCache::Default().BindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,67 @@
+#pragma once
+#ifndef INSTANCE_RING_BUFFER_H
+#define INSTANCE_RING_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <vector>
+
+// Streams per-instance data through a buffer the GPU may still be reading from.
+// With ARB_buffer_storage the buffer is persistently mapped and split into RegionCount regions guarded by fences,
+// so the CPU fills the region for frame N+2 while the GPU still draws frame N.
+// Without it the buffer has a single region which is orphaned on every write.
+// When the GPU doesn't release a region in time, that write goes to a separate buffer which is orphaned instead.
+class InstanceRingBuffer
+{
+public:
+	static constexpr unsigned int RegionCount = 3;
+
+	explicit InstanceRingBuffer(std::size_t regionSize);
+	~InstanceRingBuffer();
+
+	InstanceRingBuffer(const InstanceRingBuffer&) = delete;
+	InstanceRingBuffer& operator=(const InstanceRingBuffer&) = delete;
+
+	static bool IsPersistentMappingSupported();
+
+	// moves to the next region, waiting for the GPU to release it, and returns memory the region's data is written to.
+	// in orphan mode the returned memory holds the data written last time, unless IsFallingBack says otherwise.
+	void* BeginWrite();
+	// publishes the data written since BeginWrite
+	void EndWrite();
+
+	// marks the end of all draw calls reading the current region
+	void FenceCurrentRegion();
+
+	bool IsPersistent() const;
+	// true when the region's fence failed or timed out and the last write went to the orphaned fallback buffer,
+	// whose memory does not hold the earlier data, so such a write has to fill the whole region
+	bool IsFallingBack() const;
+	// buffer and offset holding the data written last
+	unsigned int GetBuffer() const;
+	unsigned int GetRegionIndex() const;
+	// number of regions data is spread over, 1 when falling back to orphaning
+	unsigned int GetRegionCount() const;
+	std::size_t GetRegionSize() const;
+	std::size_t GetRegionOffset() const;
+
+private:
+	// false when the GPU may still be reading the region
+	bool WaitForRegion(unsigned int region);
+	void OrphanAndUpload(unsigned int target);
+
+	unsigned int buffer = 0;
+	unsigned int fallbackBuffer = 0;
+	bool persistent = false;
+	bool fallingBack = false;
+	std::size_t regionSize = 0;
+	std::size_t regionStride = 0;
+	unsigned int currentRegion = 0;
+
+	unsigned char* mappedMemory = nullptr;
+	std::vector<unsigned char> stagingMemory;
+	GLsync fences[RegionCount] = {};
+};
+
+#endif
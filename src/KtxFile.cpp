@@ -0,0 +1,301 @@
+#include "KtxFile.h"
+
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <utility>
+
+namespace
+{
+	const unsigned char Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+
+	const char WriterKey[] = "KTXwriter";
+	const char WriterValue[] = "OpenGLPAG texbake";
+	const char SourceHashKey[] = "OpenGLPAGSourceHash";
+
+	// VkFormat values of the formats texbake writes
+	constexpr std::uint32_t VkFormatBC1RgbUnorm = 131;
+	constexpr std::uint32_t VkFormatBC3Unorm = 137;
+	constexpr std::uint32_t VkFormatBC5Unorm = 141;
+
+	// Khronos data format descriptor color models and channels of the block formats
+	constexpr std::uint32_t ModelBC1A = 128;
+	constexpr std::uint32_t ModelBC3 = 130;
+	constexpr std::uint32_t ModelBC5 = 132;
+	constexpr std::uint32_t ChannelColor = 0;
+	constexpr std::uint32_t ChannelGreen = 1;
+	constexpr std::uint32_t ChannelAlpha = 15;
+
+	struct KtxHeader
+	{
+		unsigned char identifier[12];
+		std::uint32_t vkFormat;
+		std::uint32_t typeSize;
+		std::uint32_t pixelWidth;
+		std::uint32_t pixelHeight;
+		std::uint32_t pixelDepth;
+		std::uint32_t layerCount;
+		std::uint32_t faceCount;
+		std::uint32_t levelCount;
+		std::uint32_t supercompressionScheme;
+		std::uint32_t dfdByteOffset;
+		std::uint32_t dfdByteLength;
+		std::uint32_t kvdByteOffset;
+		std::uint32_t kvdByteLength;
+		std::uint64_t sgdByteOffset;
+		std::uint64_t sgdByteLength;
+	};
+	static_assert(sizeof(KtxHeader) == 80, "KTX2 header must not be padded");
+
+	struct KtxLevel
+	{
+		std::uint64_t byteOffset;
+		std::uint64_t byteLength;
+		std::uint64_t uncompressedByteLength;
+	};
+
+	std::uint32_t ToVkFormat(BlockFormat format)
+	{
+		switch (format)
+		{
+		case BlockFormat::BC1:
+			return VkFormatBC1RgbUnorm;
+		case BlockFormat::BC3:
+			return VkFormatBC3Unorm;
+		default:
+			return VkFormatBC5Unorm;
+		}
+	}
+
+	bool FromVkFormat(std::uint32_t vkFormat, BlockFormat& format)
+	{
+		switch (vkFormat)
+		{
+		case VkFormatBC1RgbUnorm:
+			format = BlockFormat::BC1;
+			return true;
+		case VkFormatBC3Unorm:
+			format = BlockFormat::BC3;
+			return true;
+		case VkFormatBC5Unorm:
+			format = BlockFormat::BC5;
+			return true;
+		default:
+			return false;
+		}
+	}
+
+	void AppendUint(std::vector<unsigned char>& data, std::uint32_t value)
+	{
+		const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+		data.insert(data.end(), bytes, bytes + sizeof(value));
+	}
+
+	// sample of a basic descriptor block, covering 64 bits of the block from bitOffset
+	void AppendSample(std::vector<unsigned char>& data, std::uint32_t bitOffset, std::uint32_t channel)
+	{
+		AppendUint(data, bitOffset | 63u << 16 | channel << 24);
+		AppendUint(data, 0);
+		AppendUint(data, 0);
+		AppendUint(data, 0xFFFFFFFFu);
+	}
+
+	// data format descriptor with one basic block, as required by KTX2 even though the VkFormat says it all
+	std::vector<unsigned char> MakeDataFormatDescriptor(BlockFormat format)
+	{
+		std::vector<std::pair<std::uint32_t, std::uint32_t>> samples;
+		std::uint32_t model = ModelBC1A;
+		switch (format)
+		{
+		case BlockFormat::BC1:
+			samples = { { 0, ChannelColor } };
+			break;
+		case BlockFormat::BC3:
+			model = ModelBC3;
+			samples = { { 0, ChannelAlpha }, { 64, ChannelColor } };
+			break;
+		case BlockFormat::BC5:
+			model = ModelBC5;
+			samples = { { 0, ChannelColor }, { 64, ChannelGreen } };
+			break;
+		}
+
+		const auto blockSize = static_cast<std::uint32_t>(24 + 16 * samples.size());
+		std::vector<unsigned char> descriptor;
+		AppendUint(descriptor, 4 + blockSize);
+		// vendor Khronos, basic descriptor type
+		AppendUint(descriptor, 0);
+		// version 2
+		AppendUint(descriptor, 2 | blockSize << 16);
+		// BT.709 primaries, linear transfer, straight alpha
+		AppendUint(descriptor, model | 1u << 8 | 1u << 16);
+		// 4x4 texel blocks
+		AppendUint(descriptor, 3 | 3u << 8);
+		AppendUint(descriptor, static_cast<std::uint32_t>(GetBlockBytes(format)));
+		AppendUint(descriptor, 0);
+		for (const auto& [bitOffset, channel] : samples)
+			AppendSample(descriptor, bitOffset, channel);
+		return descriptor;
+	}
+
+	void AppendKeyValue(std::vector<unsigned char>& data, const std::string& key, const std::string& value)
+	{
+		// key and value are both stored with their terminating zero
+		AppendUint(data, static_cast<std::uint32_t>(key.size() + 1 + value.size() + 1));
+		data.insert(data.end(), key.c_str(), key.c_str() + key.size() + 1);
+		data.insert(data.end(), value.c_str(), value.c_str() + value.size() + 1);
+		data.resize((data.size() + 3) / 4 * 4, 0);
+	}
+
+	// length of a zero terminated string stored in at most maxLength bytes
+	std::size_t BoundedLength(const char* text, std::size_t maxLength)
+	{
+		const void* end = std::memchr(text, 0, maxLength);
+		return end != nullptr ? static_cast<std::size_t>(static_cast<const char*>(end) - text) : maxLength;
+	}
+
+	// finds the value of key in the key/value data, empty when it is missing
+	std::string FindValue(const unsigned char* data, std::size_t size, const std::string& key)
+	{
+		std::size_t offset = 0;
+		while (size - offset >= sizeof(std::uint32_t))
+		{
+			std::uint32_t length;
+			std::memcpy(&length, data + offset, sizeof(length));
+			offset += sizeof(length);
+			if (length > size - offset)
+				break;
+
+			const auto* pair = reinterpret_cast<const char*>(data + offset);
+			const std::size_t keyLength = BoundedLength(pair, length);
+			if (keyLength + 1 < length && key.compare(0, std::string::npos, pair, keyLength) == 0)
+				return std::string(pair + keyLength + 1, BoundedLength(pair + keyLength + 1, length - keyLength - 1));
+
+			offset += (static_cast<std::size_t>(length) + 3) / 4 * 4;
+		}
+		return std::string();
+	}
+}
+
+std::string GetBakedTexturePath(const std::string& sourcePath)
+{
+	return sourcePath + ".ktx2";
+}
+
+bool ReadKtxFile(const std::string& path, KtxTexture& texture)
+{
+	MappedFile file;
+	if (!file.Open(path) || file.GetSize() < sizeof(KtxHeader))
+		return false;
+
+	const unsigned char* data = file.GetData();
+	const std::size_t size = file.GetSize();
+
+	KtxHeader header;
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.identifier, Identifier, sizeof(Identifier)) != 0 || header.pixelDepth != 0 ||
+		header.layerCount != 0 || header.faceCount != 1 || header.supercompressionScheme != 0 ||
+		header.pixelWidth == 0 || header.pixelHeight == 0 || header.levelCount == 0 || header.levelCount > 32)
+		return false;
+
+	KtxTexture read;
+	if (!FromVkFormat(header.vkFormat, read.format))
+		return false;
+	read.width = static_cast<int>(header.pixelWidth);
+	read.height = static_cast<int>(header.pixelHeight);
+
+	if (header.kvdByteOffset > size || header.kvdByteLength > size - header.kvdByteOffset)
+		return false;
+	const std::string hash = FindValue(data + header.kvdByteOffset, header.kvdByteLength, SourceHashKey);
+	read.sourceHash = std::strtoull(hash.c_str(), nullptr, 16);
+
+	if (header.levelCount * sizeof(KtxLevel) > size - sizeof(KtxHeader))
+		return false;
+
+	int width = read.width;
+	int height = read.height;
+	read.levels.resize(header.levelCount);
+	for (std::uint32_t level = 0; level < header.levelCount; level++)
+	{
+		KtxLevel entry;
+		std::memcpy(&entry, data + sizeof(KtxHeader) + level * sizeof(KtxLevel), sizeof(entry));
+		if (entry.byteLength != GetCompressedSize(read.format, width, height) || entry.byteOffset > size ||
+			entry.byteLength > size - entry.byteOffset)
+			return false;
+
+		read.levels[level].assign(data + entry.byteOffset, data + entry.byteOffset + entry.byteLength);
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+
+	texture = std::move(read);
+	return true;
+}
+
+bool WriteKtxFile(const std::string& path, const KtxTexture& texture)
+{
+	const std::vector<unsigned char> descriptor = MakeDataFormatDescriptor(texture.format);
+
+	// keys sorted by their bytes, as the format asks
+	char hash[17];
+	std::snprintf(hash, sizeof(hash), "%016llx", static_cast<unsigned long long>(texture.sourceHash));
+	std::vector<unsigned char> keyValues;
+	AppendKeyValue(keyValues, WriterKey, WriterValue);
+	AppendKeyValue(keyValues, SourceHashKey, hash);
+
+	KtxHeader header{};
+	std::memcpy(header.identifier, Identifier, sizeof(Identifier));
+	header.vkFormat = ToVkFormat(texture.format);
+	header.typeSize = 1;
+	header.pixelWidth = static_cast<std::uint32_t>(texture.width);
+	header.pixelHeight = static_cast<std::uint32_t>(texture.height);
+	header.faceCount = 1;
+	header.levelCount = static_cast<std::uint32_t>(texture.levels.size());
+	header.dfdByteOffset = static_cast<std::uint32_t>(sizeof(KtxHeader) + texture.levels.size() * sizeof(KtxLevel));
+	header.dfdByteLength = static_cast<std::uint32_t>(descriptor.size());
+	header.kvdByteOffset = header.dfdByteOffset + header.dfdByteLength;
+	header.kvdByteLength = static_cast<std::uint32_t>(keyValues.size());
+
+	// levels are stored smallest first, each aligned to the block size
+	const std::size_t alignment = GetBlockBytes(texture.format);
+	std::vector<KtxLevel> levelIndex(texture.levels.size());
+	std::size_t offset = header.kvdByteOffset + header.kvdByteLength;
+	for (std::size_t level = texture.levels.size(); level-- > 0;)
+	{
+		offset = (offset + alignment - 1) / alignment * alignment;
+		levelIndex[level] = { offset, texture.levels[level].size(), texture.levels[level].size() };
+		offset += texture.levels[level].size();
+	}
+
+	// written under a temporary name first, like the mesh cache
+	const std::string temporaryPath = path + ".tmp";
+	{
+		std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!out)
+			return false;
+
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.write(reinterpret_cast<const char*>(levelIndex.data()), static_cast<std::streamsize>(levelIndex.size() * sizeof(KtxLevel)));
+		out.write(reinterpret_cast<const char*>(descriptor.data()), static_cast<std::streamsize>(descriptor.size()));
+		out.write(reinterpret_cast<const char*>(keyValues.data()), static_cast<std::streamsize>(keyValues.size()));
+
+		std::size_t written = header.kvdByteOffset + header.kvdByteLength;
+		for (std::size_t level = texture.levels.size(); level-- > 0;)
+		{
+			const std::vector<char> padding(levelIndex[level].byteOffset - written, 0);
+			out.write(padding.data(), static_cast<std::streamsize>(padding.size()));
+			out.write(reinterpret_cast<const char*>(texture.levels[level].data()), static_cast<std::streamsize>(texture.levels[level].size()));
+			written = levelIndex[level].byteOffset + levelIndex[level].byteLength;
+		}
+
+		if (!out)
+			return false;
+	}
+
+	std::remove(path.c_str());
+	return std::rename(temporaryPath.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#ifndef KTX_FILE_H
+#define KTX_FILE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BlockCompression.h"
+
+// A block compressed 2D texture with its mip chain, as stored in the KTX2 files texbake writes next to the images.
+// Only the subset texbake produces is read back: one face, one layer, no supercompression, BC1/BC3/BC5 in UNORM,
+// the loader picks the sRGB variant itself. The FNV-1a hash of the source image is kept in the key/value data,
+// so a bake is ignored once its image changes.
+struct KtxTexture
+{
+	BlockFormat format = BlockFormat::BC1;
+	int width = 0;
+	int height = 0;
+	std::uint64_t sourceHash = 0;
+	// level 0 first
+	std::vector<std::vector<unsigned char>> levels;
+};
+
+std::string GetBakedTexturePath(const std::string& sourcePath);
+
+// false when the file is missing, malformed or uses anything outside the subset above
+bool ReadKtxFile(const std::string& path, KtxTexture& texture);
+
+bool WriteKtxFile(const std::string& path, const KtxTexture& texture);
+
+#endif
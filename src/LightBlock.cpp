@@ -0,0 +1,40 @@
+#include "LightBlock.h"
+
+#include "GLStateCache.h"
+
+#include <cstring>
+
+LightBlock::LightBlock()
+{
+	glGenBuffers(1, &buffer);
+	GLStateCache::Default().BindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlockData), nullptr, GL_DYNAMIC_DRAW);
+	GLStateCache::Default().BindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	GLStateCache::Default().BindBufferBase(GL_UNIFORM_BUFFER, BindingPoint, buffer);
+}
+
+LightBlock::~LightBlock()
+{
+	GLStateCache::Default().DeleteBuffers(1, &buffer);
+}
+
+bool LightBlock::Upload(const LightBlockData& data)
+{
+	// the padding is part of the comparison, it stays zero as long as the data is built from default constructed structs
+	if (hasUploaded && std::memcmp(&uploaded, &data, sizeof(LightBlockData)) == 0)
+		return false;
+
+	GLStateCache::Default().BindBuffer(GL_UNIFORM_BUFFER, buffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightBlockData), &data);
+	GLStateCache::Default().BindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	uploaded = data;
+	hasUploaded = true;
+	return true;
+}
+
+unsigned int LightBlock::GetBuffer() const
+{
+	return buffer;
+}
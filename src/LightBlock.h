@@ -0,0 +1,114 @@
+#pragma once
+#ifndef LIGHT_BLOCK_H
+#define LIGHT_BLOCK_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+// C++ mirrors of the structs in light.frag, laid out by the std140 rules.
+// glm::vec3 takes 12 bytes, the explicit padding brings every member to its std140 offset.
+struct BaseLightData
+{
+	glm::vec3 ambient{ 0.0f };
+	float pad0 = 0.0f;
+	glm::vec3 diffuse{ 0.0f };
+	float pad1 = 0.0f;
+	glm::vec3 specular{ 0.0f };
+	float pad2 = 0.0f;
+};
+
+struct AttenuationData
+{
+	float constant = 1.0f;
+	float linear = 0.0f;
+	float quadratic = 0.0f;
+	float pad0 = 0.0f;
+};
+
+struct DirLightData
+{
+	// GLSL bools are 4 bytes wide
+	int isActive = 0;
+	float pad0[3] = {};
+	glm::vec3 direction{ 0.0f };
+	float pad1 = 0.0f;
+	BaseLightData colors;
+};
+
+struct PointLightData
+{
+	int isActive = 0;
+	float pad0[3] = {};
+	glm::vec3 position{ 0.0f };
+	float pad1 = 0.0f;
+	AttenuationData att;
+	BaseLightData colors;
+};
+
+struct SpotLightData
+{
+	int isActive = 0;
+	float pad0[3] = {};
+	glm::vec3 position{ 0.0f };
+	float pad1 = 0.0f;
+	// cutOff packs into the last component of direction's vec4 slot
+	glm::vec3 direction{ 0.0f };
+	float cutOff = 0.0f;
+	float outerCutOff = 0.0f;
+	float pad2[3] = {};
+	AttenuationData att;
+	BaseLightData colors;
+};
+
+// must match NR_POINT_LIGHTS and NR_SPOT_LIGHTS in light.frag
+constexpr std::size_t NrPointLights = 1;
+constexpr std::size_t NrSpotLights = 2;
+
+struct LightBlockData
+{
+	DirLightData dirLight;
+	PointLightData pointLights[NrPointLights];
+	SpotLightData spotLights[NrSpotLights];
+};
+
+static_assert(sizeof(BaseLightData) == 48, "BaseLightData does not match std140");
+static_assert(offsetof(BaseLightData, diffuse) == 16 && offsetof(BaseLightData, specular) == 32, "BaseLightData does not match std140");
+static_assert(sizeof(AttenuationData) == 16, "AttenuationData does not match std140");
+static_assert(sizeof(DirLightData) == 80, "DirLightData does not match std140");
+static_assert(offsetof(DirLightData, direction) == 16 && offsetof(DirLightData, colors) == 32, "DirLightData does not match std140");
+static_assert(sizeof(PointLightData) == 96, "PointLightData does not match std140");
+static_assert(offsetof(PointLightData, position) == 16 && offsetof(PointLightData, att) == 32 && offsetof(PointLightData, colors) == 48, "PointLightData does not match std140");
+static_assert(sizeof(SpotLightData) == 128, "SpotLightData does not match std140");
+static_assert(offsetof(SpotLightData, position) == 16 && offsetof(SpotLightData, direction) == 32 && offsetof(SpotLightData, cutOff) == 44, "SpotLightData does not match std140");
+static_assert(offsetof(SpotLightData, outerCutOff) == 48 && offsetof(SpotLightData, att) == 64 && offsetof(SpotLightData, colors) == 80, "SpotLightData does not match std140");
+static_assert(offsetof(LightBlockData, pointLights) == 80 && offsetof(LightBlockData, spotLights) == 176, "LightBlockData does not match std140");
+
+// Uniform buffer holding the LightBlock of light.frag.
+// It is bound once at BindingPoint, so every program declaring the block reads the same lights
+// and a frame needs at most one upload for all of them.
+class LightBlock
+{
+public:
+	// matches layout(binding = 0) of LightBlock in light.frag
+	static constexpr unsigned int BindingPoint = 0;
+
+	LightBlock();
+	~LightBlock();
+
+	LightBlock(const LightBlock&) = delete;
+	LightBlock& operator=(const LightBlock&) = delete;
+
+	// sends the lights to the GPU unless they equal the data uploaded last, returns whether an upload happened
+	bool Upload(const LightBlockData& data);
+
+	unsigned int GetBuffer() const;
+
+private:
+	unsigned int buffer = 0;
+	LightBlockData uploaded;
+	bool hasUploaded = false;
+};
+
+#endif
@@ -0,0 +1,399 @@
+#include "LightClusters.h"
+
+#include "GLStateCache.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+namespace
+{
+	// lights are cheap to transform, smaller batches are not worth waking the workers for
+	constexpr std::size_t LightChunkSize = 1024;
+
+	bool SphereIntersectsBox(const glm::vec3& center, float radius, const glm::vec3& boxMin, const glm::vec3& boxMax)
+	{
+		const glm::vec3 closest = glm::clamp(center, boxMin, boxMax);
+		const glm::vec3 offset = center - closest;
+		return glm::dot(offset, offset) <= radius * radius;
+	}
+
+	// relative slack on the radius for lights that only graze a froxel, where floats may round either way
+	constexpr float ValidationTolerance = 1e-3f;
+
+	// distance from the point to the intersection of the half spaces dot(plane.xyz, p) <= plane.w,
+	// found by Dykstra's alternating projections
+	float DistanceToConvex(const glm::vec3& point, const glm::vec4 (&planes)[6])
+	{
+		glm::vec3 closest = point;
+		glm::vec3 corrections[6] = {};
+		for (int iteration = 0; iteration < 200; iteration++)
+		{
+			for (int i = 0; i < 6; i++)
+			{
+				const glm::vec3 corrected = closest + corrections[i];
+				const glm::vec3 normal(planes[i]);
+				const float excess = glm::dot(normal, corrected) - planes[i].w;
+				const glm::vec3 projected = excess > 0.0f ? corrected - normal * (excess / glm::dot(normal, normal)) : corrected;
+				corrections[i] = corrected - projected;
+				closest = projected;
+			}
+		}
+		return glm::length(point - closest);
+	}
+
+	unsigned short ToTile(float ndc, unsigned int tileCount)
+	{
+		const int tile = static_cast<int>(std::floor((ndc + 1.0f) * 0.5f * static_cast<float>(tileCount)));
+		return static_cast<unsigned short>(std::clamp(tile, 0, static_cast<int>(tileCount) - 1));
+	}
+}
+
+LightClusters::LightClusters()
+{
+	clusterCells.resize(ClusterCount);
+	sliceLights.resize(GridZ);
+
+	glGenBuffers(1, &paramsBuffer);
+	GLStateCache::Default().BindBuffer(GL_UNIFORM_BUFFER, paramsBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(ClusterParamsData), &params, GL_DYNAMIC_DRAW);
+	GLStateCache::Default().BindBuffer(GL_UNIFORM_BUFFER, 0);
+	GLStateCache::Default().BindBufferBase(GL_UNIFORM_BUFFER, ParamsBinding, paramsBuffer);
+
+	// shader storage bindings must never point at empty buffers, so every buffer starts with one zeroed element
+	const glm::uvec4 zero(0u);
+
+	glGenBuffers(1, &lightsBuffer);
+	glGenBuffers(1, &gridBuffer);
+	glGenBuffers(1, &indicesBuffer);
+
+	GLStateCache::Default().BindBuffer(GL_SHADER_STORAGE_BUFFER, lightsBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(ClusterPointLight), nullptr, GL_STATIC_DRAW);
+	GLStateCache::Default().BindBuffer(GL_SHADER_STORAGE_BUFFER, gridBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, ClusterCount * sizeof(glm::uvec2), clusterCells.data(), GL_STREAM_DRAW);
+	GLStateCache::Default().BindBuffer(GL_SHADER_STORAGE_BUFFER, indicesBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(unsigned int), &zero, GL_STREAM_DRAW);
+	GLStateCache::Default().BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	GLStateCache::Default().BindBufferBase(GL_SHADER_STORAGE_BUFFER, LightsBinding, lightsBuffer);
+	GLStateCache::Default().BindBufferBase(GL_SHADER_STORAGE_BUFFER, GridBinding, gridBuffer);
+	GLStateCache::Default().BindBufferBase(GL_SHADER_STORAGE_BUFFER, IndicesBinding, indicesBuffer);
+}
+
+LightClusters::~LightClusters()
+{
+	GLStateCache::Default().DeleteBuffers(1, &paramsBuffer);
+	GLStateCache::Default().DeleteBuffers(1, &lightsBuffer);
+	GLStateCache::Default().DeleteBuffers(1, &gridBuffer);
+	GLStateCache::Default().DeleteBuffers(1, &indicesBuffer);
+}
+
+void LightClusters::SetLights(const std::vector<ClusterPointLight>& newLights)
+{
+	lights = newLights;
+
+	GLStateCache::Default().BindBuffer(GL_SHADER_STORAGE_BUFFER, lightsBuffer);
+	if (lights.empty())
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(ClusterPointLight), nullptr, GL_STATIC_DRAW);
+	else
+		glBufferData(GL_SHADER_STORAGE_BUFFER, lights.size() * sizeof(ClusterPointLight), lights.data(), GL_STATIC_DRAW);
+	GLStateCache::Default().BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void LightClusters::Build(const glm::mat4& view, float fovY, float aspect, float nearPlane, float farPlane, const glm::vec2& viewportSize)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	if (fovY != boundsFovY || aspect != boundsAspect || nearPlane != boundsNear || farPlane != boundsFar)
+		UpdateClusterBounds(fovY, aspect, nearPlane, farPlane);
+
+	const float logDepthRange = std::log(farPlane / nearPlane);
+	params.view = view;
+	params.gridSize = glm::uvec4(GridX, GridY, GridZ, lights.empty() ? 0u : 1u);
+	params.depthSlicing = glm::vec4(GridZ / logDepthRange, -static_cast<float>(GridZ) * std::log(nearPlane) / logDepthRange, 0.0f, 0.0f);
+	params.viewportSize = glm::vec4(viewportSize, 0.0f, 0.0f);
+
+	// 1. find the range of clusters every light may touch
+	viewCenters.resize(lights.size());
+	lightRanges.resize(lights.size());
+	ParallelFor(lights.size(), LightChunkSize, [&](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t i = begin; i < end; i++)
+		{
+			viewCenters[i] = glm::vec3(view * glm::vec4(glm::vec3(lights[i].positionRadius), 1.0f));
+			lightRanges[i] = ComputeLightRange(viewCenters[i], lights[i].positionRadius.w);
+		}
+	});
+
+	// 2. bucket the lights by depth slice, in light order so the lists come out the same on any thread count
+	for (auto& slice : sliceLights)
+		slice.clear();
+	for (std::size_t i = 0; i < lights.size(); i++)
+	{
+		for (unsigned int z = lightRanges[i].minZ; z <= lightRanges[i].maxZ && lightRanges[i].minZ <= lightRanges[i].maxZ; z++)
+			sliceLights[z].emplace_back(static_cast<unsigned int>(i));
+	}
+
+	// 3. count the lights of every cluster, every slice is owned by one task
+	ParallelFor(GridZ, 1, [&](std::size_t begin, std::size_t end)
+	{
+		for (std::size_t z = begin; z < end; z++)
+		{
+			glm::uvec2* cells = &clusterCells[z * GridX * GridY];
+			std::fill(cells, cells + GridX * GridY, glm::uvec2(0u));
+
+			for (const auto light : sliceLights[z])
+			{
+				const LightRange& range = lightRanges[light];
+				for (unsigned int y = range.minY; y <= range.maxY; y++)
+				{
+					for (unsigned int x = range.minX; x <= range.maxX; x++)
+					{
+						const std::size_t cluster = (z * GridY + y) * GridX + x;
+						if (SphereIntersectsBox(viewCenters[light], lights[light].positionRadius.w, clusterMin[cluster], clusterMax[cluster]))
+							cells[y * GridX + x].y++;
+					}
+				}
+			}
+		}
+	});
+
+	// 4. lay the lists out one after another
+	unsigned int indexCount = 0;
+	for (auto& cell : clusterCells)
+	{
+		cell.x = indexCount;
+		indexCount += cell.y;
+	}
+	lightIndices.resize(indexCount);
+
+	// 5. fill the lists, repeating the tests of step 3
+	ParallelFor(GridZ, 1, [&](std::size_t begin, std::size_t end)
+	{
+		std::vector<unsigned int> cursors(GridX * GridY);
+
+		for (std::size_t z = begin; z < end; z++)
+		{
+			const glm::uvec2* cells = &clusterCells[z * GridX * GridY];
+			for (unsigned int i = 0; i < GridX * GridY; i++)
+				cursors[i] = cells[i].x;
+
+			for (const auto light : sliceLights[z])
+			{
+				const LightRange& range = lightRanges[light];
+				for (unsigned int y = range.minY; y <= range.maxY; y++)
+				{
+					for (unsigned int x = range.minX; x <= range.maxX; x++)
+					{
+						const std::size_t cluster = (z * GridY + y) * GridX + x;
+						if (SphereIntersectsBox(viewCenters[light], lights[light].positionRadius.w, clusterMin[cluster], clusterMax[cluster]))
+							lightIndices[cursors[y * GridX + x]++] = light;
+					}
+				}
+			}
+		}
+	});
+
+	UploadLists();
+
+	lastBuildMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void LightClusters::SetWorkerCount(unsigned int count)
+{
+	if (count == GetWorkerCount())
+		return;
+
+	if (count > 1)
+		threadPool = std::make_unique<ThreadPool>(count);
+	else
+		threadPool.reset();
+}
+
+unsigned int LightClusters::GetWorkerCount() const
+{
+	return threadPool ? threadPool->GetThreadCount() : 1;
+}
+
+std::size_t LightClusters::GetLightCount() const
+{
+	return lights.size();
+}
+
+std::size_t LightClusters::GetIndexCount() const
+{
+	return lightIndices.size();
+}
+
+double LightClusters::GetLastBuildMilliseconds() const
+{
+	return lastBuildMilliseconds;
+}
+
+std::size_t LightClusters::Validate() const
+{
+	if (clusterMin.size() != ClusterCount || viewCenters.size() != lights.size())
+		return 0;
+
+	std::size_t mismatches = 0;
+	std::vector<unsigned int> candidates;
+	for (unsigned int z = 0; z < GridZ; z++)
+	{
+		for (unsigned int y = 0; y < GridY; y++)
+		{
+			for (unsigned int x = 0; x < GridX; x++)
+			{
+				const std::size_t cluster = (z * GridY + y) * GridX + x;
+
+				// every light passing the box test, in light order like the lists
+				candidates.clear();
+				for (std::size_t light = 0; light < lights.size(); light++)
+				{
+					if (SphereIntersectsBox(viewCenters[light], lights[light].positionRadius.w, clusterMin[cluster], clusterMax[cluster]))
+						candidates.emplace_back(static_cast<unsigned int>(light));
+				}
+
+				// the froxel itself is tighter than its box, a candidate may only be left out when it misses the froxel
+				const glm::vec4 planes[6] = {
+					glm::vec4(0.0f, 0.0f, 1.0f, -sliceDepths[z]),
+					glm::vec4(0.0f, 0.0f, -1.0f, sliceDepths[z + 1]),
+					glm::vec4(-projectionX, 0.0f, -(-1.0f + 2.0f * static_cast<float>(x) / GridX), 0.0f),
+					glm::vec4(projectionX, 0.0f, -1.0f + 2.0f * static_cast<float>(x + 1) / GridX, 0.0f),
+					glm::vec4(0.0f, -projectionY, -(-1.0f + 2.0f * static_cast<float>(y) / GridY), 0.0f),
+					glm::vec4(0.0f, projectionY, -1.0f + 2.0f * static_cast<float>(y + 1) / GridY, 0.0f)
+				};
+
+				const glm::uvec2& cell = clusterCells[cluster];
+				const unsigned int* list = lightIndices.data() + cell.x;
+				std::size_t listed = 0;
+				bool matches = true;
+				for (const unsigned int light : candidates)
+				{
+					if (listed < cell.y && list[listed] == light)
+					{
+						listed++;
+						continue;
+					}
+
+					const float radius = lights[light].positionRadius.w;
+					if (DistanceToConvex(viewCenters[light], planes) <= radius * (1.0f + ValidationTolerance))
+						matches = false;
+				}
+
+				// whatever is left in the list failed the box test
+				if (!matches || listed != cell.y)
+					mismatches++;
+			}
+		}
+	}
+	return mismatches;
+}
+
+void LightClusters::UpdateClusterBounds(float fovY, float aspect, float nearPlane, float farPlane)
+{
+	boundsFovY = fovY;
+	boundsAspect = aspect;
+	boundsNear = nearPlane;
+	boundsFar = farPlane;
+
+	const float tanHalfFov = std::tan(fovY * 0.5f);
+	projectionY = 1.0f / tanHalfFov;
+	projectionX = 1.0f / (tanHalfFov * aspect);
+
+	// exponential slicing keeps the clusters roughly cube shaped at every depth
+	sliceDepths.resize(GridZ + 1);
+	for (unsigned int z = 0; z <= GridZ; z++)
+		sliceDepths[z] = nearPlane * std::pow(farPlane / nearPlane, static_cast<float>(z) / GridZ);
+
+	clusterMin.resize(ClusterCount);
+	clusterMax.resize(ClusterCount);
+
+	for (unsigned int z = 0; z < GridZ; z++)
+	{
+		const float nearDepth = sliceDepths[z];
+		const float farDepth = sliceDepths[z + 1];
+
+		for (unsigned int y = 0; y < GridY; y++)
+		{
+			const float ndcY0 = -1.0f + 2.0f * static_cast<float>(y) / GridY;
+			const float ndcY1 = -1.0f + 2.0f * static_cast<float>(y + 1) / GridY;
+
+			for (unsigned int x = 0; x < GridX; x++)
+			{
+				const float ndcX0 = -1.0f + 2.0f * static_cast<float>(x) / GridX;
+				const float ndcX1 = -1.0f + 2.0f * static_cast<float>(x + 1) / GridX;
+
+				// the froxel widens with depth, its box spans the near and far faces
+				const std::size_t cluster = (z * GridY + y) * GridX + x;
+				clusterMin[cluster] = glm::vec3(std::min(ndcX0 * nearDepth, ndcX0 * farDepth) / projectionX,
+					std::min(ndcY0 * nearDepth, ndcY0 * farDepth) / projectionY, -farDepth);
+				clusterMax[cluster] = glm::vec3(std::max(ndcX1 * nearDepth, ndcX1 * farDepth) / projectionX,
+					std::max(ndcY1 * nearDepth, ndcY1 * farDepth) / projectionY, -nearDepth);
+			}
+		}
+	}
+}
+
+LightClusters::LightRange LightClusters::ComputeLightRange(const glm::vec3& center, float radius) const
+{
+	LightRange range = { 0, 0, 0, 0, 1, 0 };
+
+	// the camera looks down -z
+	const float depth = -center.z;
+	if (depth + radius < boundsNear || depth - radius > boundsFar)
+		return range;
+
+	const float minDepth = std::max(depth - radius, boundsNear);
+	const float maxDepth = std::min(depth + radius, boundsFar);
+
+	// the box around the sphere projects furthest out at one of its two depths
+	const float ndcMinX = std::min((center.x - radius) / minDepth, (center.x - radius) / maxDepth) * projectionX;
+	const float ndcMaxX = std::max((center.x + radius) / minDepth, (center.x + radius) / maxDepth) * projectionX;
+	const float ndcMinY = std::min((center.y - radius) / minDepth, (center.y - radius) / maxDepth) * projectionY;
+	const float ndcMaxY = std::max((center.y + radius) / minDepth, (center.y + radius) / maxDepth) * projectionY;
+	if (ndcMaxX < -1.0f || ndcMinX > 1.0f || ndcMaxY < -1.0f || ndcMinY > 1.0f)
+		return range;
+
+	const auto lastSlice = static_cast<int>(GridZ) - 1;
+	const auto slice = [&](float sliceDepth)
+	{
+		const float position = std::log(sliceDepth / boundsNear) / std::log(boundsFar / boundsNear) * GridZ;
+		return static_cast<unsigned short>(std::clamp(static_cast<int>(std::floor(position)), 0, lastSlice));
+	};
+
+	range.minX = ToTile(ndcMinX, GridX);
+	range.maxX = ToTile(ndcMaxX, GridX);
+	range.minY = ToTile(ndcMinY, GridY);
+	range.maxY = ToTile(ndcMaxY, GridY);
+	range.minZ = slice(minDepth);
+	range.maxZ = slice(maxDepth);
+	return range;
+}
+
+void LightClusters::UploadLists()
+{
+	GLStateCache::Default().BindBuffer(GL_UNIFORM_BUFFER, paramsBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(ClusterParamsData), &params);
+	GLStateCache::Default().BindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	GLStateCache::Default().BindBuffer(GL_SHADER_STORAGE_BUFFER, gridBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, ClusterCount * sizeof(glm::uvec2), clusterCells.data());
+
+	// the lists change size every frame, so the storage is orphaned instead of patched
+	const unsigned int zero = 0;
+	GLStateCache::Default().BindBuffer(GL_SHADER_STORAGE_BUFFER, indicesBuffer);
+	if (lightIndices.empty())
+		glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(unsigned int), &zero, GL_STREAM_DRAW);
+	else
+		glBufferData(GL_SHADER_STORAGE_BUFFER, lightIndices.size() * sizeof(unsigned int), lightIndices.data(), GL_STREAM_DRAW);
+	GLStateCache::Default().BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
+void LightClusters::ParallelFor(std::size_t count, std::size_t minChunk, const std::function<void(std::size_t, std::size_t)>& task)
+{
+	if (threadPool)
+		threadPool->ParallelFor(count, minChunk, task);
+	else if (count > 0)
+		task(0, count);
+}
@@ -0,0 +1,131 @@
+#pragma once
+#ifndef LIGHT_CLUSTERS_H
+#define LIGHT_CLUSTERS_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class ThreadPool;
+
+// point light as stored in the light SSBO, std430
+struct ClusterPointLight
+{
+	// xyz - world position, w - radius past which the light contributes nothing
+	glm::vec4 positionRadius{ 0.0f };
+	// rgb - color, a - unused
+	glm::vec4 color{ 0.0f };
+};
+
+// cluster grid parameters as stored in the ClusterBlock uniform block of light.frag, std140
+struct ClusterParamsData
+{
+	glm::mat4 view{ 1.0f };
+	// xyz - grid size, w - 1 when any lights are clustered
+	glm::uvec4 gridSize{ 0u };
+	// x - slice scale, y - slice bias, the slice of a view depth d is log(d) * x + y
+	glm::vec4 depthSlicing{ 0.0f };
+	// xy - viewport size in pixels
+	glm::vec4 viewportSize{ 1.0f };
+};
+
+static_assert(sizeof(ClusterPointLight) == 32, "ClusterPointLight does not match std430");
+static_assert(sizeof(ClusterParamsData) == 112, "ClusterParamsData does not match std140");
+
+// Clustered forward lighting.
+// The view frustum is split into a GridX x GridY x GridZ grid of froxels, with exponentially growing depth slices.
+// Every frame each cluster gets the list of point lights touching it, so fragments only evaluate the lights
+// of their own cluster instead of every light in the scene. The lists are built on the CPU, spread over a thread pool.
+class LightClusters
+{
+public:
+	static constexpr unsigned int GridX = 16;
+	static constexpr unsigned int GridY = 9;
+	static constexpr unsigned int GridZ = 24;
+	static constexpr unsigned int ClusterCount = GridX * GridY * GridZ;
+
+	// must match the bindings in light.frag
+	static constexpr unsigned int ParamsBinding = 1;
+	static constexpr unsigned int LightsBinding = 3;
+	static constexpr unsigned int GridBinding = 4;
+	static constexpr unsigned int IndicesBinding = 5;
+
+	LightClusters();
+	~LightClusters();
+
+	LightClusters(const LightClusters&) = delete;
+	LightClusters& operator=(const LightClusters&) = delete;
+
+	// replaces the clustered lights and uploads them, they stay on the GPU until the next call
+	void SetLights(const std::vector<ClusterPointLight>& newLights);
+
+	// assigns the lights to the clusters of the given camera and uploads the lists
+	void Build(const glm::mat4& view, float fovY, float aspect, float nearPlane, float farPlane, const glm::vec2& viewportSize);
+
+	// number of threads used by Build, 1 keeps everything on the calling thread
+	void SetWorkerCount(unsigned int count);
+	unsigned int GetWorkerCount() const;
+
+	std::size_t GetLightCount() const;
+	// total length of all cluster lists of the last Build
+	std::size_t GetIndexCount() const;
+	// CPU time of the last Build
+	double GetLastBuildMilliseconds() const;
+
+	// tests every light against every cluster of the last Build and returns the clusters whose list holds a light
+	// missing the cluster's box, or leaves out one that reaches into the froxel. slow, meant for checks on any worker count
+	std::size_t Validate() const;
+
+private:
+	// inclusive cluster coordinates touched by a light, empty when maxZ < minZ
+	struct LightRange
+	{
+		unsigned short minX, maxX;
+		unsigned short minY, maxY;
+		unsigned short minZ, maxZ;
+	};
+
+	void UpdateClusterBounds(float fovY, float aspect, float nearPlane, float farPlane);
+	LightRange ComputeLightRange(const glm::vec3& center, float radius) const;
+	void UploadLists();
+	// runs task(begin, end) over [0, count) on the thread pool, or inline without one
+	void ParallelFor(std::size_t count, std::size_t minChunk, const std::function<void(std::size_t, std::size_t)>& task);
+
+	std::vector<ClusterPointLight> lights;
+
+	// view space bounds of every cluster, rebuilt when the projection changes
+	std::vector<glm::vec3> clusterMin;
+	std::vector<glm::vec3> clusterMax;
+	float boundsFovY = 0.0f;
+	float boundsAspect = 0.0f;
+	float boundsNear = 0.0f;
+	float boundsFar = 0.0f;
+	// view depth of the near side of every slice, GridZ + 1 entries
+	std::vector<float> sliceDepths;
+	float projectionX = 1.0f;
+	float projectionY = 1.0f;
+
+	// per frame data
+	std::vector<glm::vec3> viewCenters;
+	std::vector<LightRange> lightRanges;
+	std::vector<std::vector<unsigned int>> sliceLights;
+	// offset and count of every cluster's list in lightIndices
+	std::vector<glm::uvec2> clusterCells;
+	std::vector<unsigned int> lightIndices;
+
+	std::unique_ptr<ThreadPool> threadPool;
+
+	ClusterParamsData params;
+	double lastBuildMilliseconds = 0.0;
+
+	unsigned int paramsBuffer = 0;
+	unsigned int lightsBuffer = 0;
+	unsigned int gridBuffer = 0;
+	unsigned int indicesBuffer = 0;
+};
+
+#endif
@@ -0,0 +1,125 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+
+	HANDLE fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(fileHandle, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	HANDLE mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mappingHandle)
+	{
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	const void* view = MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	if (!view)
+	{
+		CloseHandle(mappingHandle);
+		CloseHandle(fileHandle);
+		return false;
+	}
+
+	file = fileHandle;
+	mapping = mappingHandle;
+	data = static_cast<const unsigned char*>(view);
+	size = static_cast<std::size_t>(fileSize.QuadPart);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data)
+		UnmapViewOfFile(data);
+	if (mapping)
+		CloseHandle(mapping);
+	if (file)
+		CloseHandle(file);
+
+	data = nullptr;
+	size = 0;
+	mapping = nullptr;
+	file = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+
+	const int descriptor = open(path.c_str(), O_RDONLY);
+	if (descriptor < 0)
+		return false;
+
+	struct stat status;
+	if (fstat(descriptor, &status) != 0 || status.st_size == 0)
+	{
+		close(descriptor);
+		return false;
+	}
+
+	void* view = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_PRIVATE, descriptor, 0);
+	// the mapping stays valid after the descriptor is closed
+	close(descriptor);
+	if (view == MAP_FAILED)
+		return false;
+
+	data = static_cast<const unsigned char*>(view);
+	size = static_cast<std::size_t>(status.st_size);
+	return true;
+}
+
+void MappedFile::Close()
+{
+	if (data)
+		munmap(const_cast<unsigned char*>(data), size);
+
+	data = nullptr;
+	size = 0;
+}
+
+#endif
+
+bool MappedFile::IsOpen() const
+{
+	return data != nullptr;
+}
+
+const unsigned char* MappedFile::GetData() const
+{
+	return data;
+}
+
+std::size_t MappedFile::GetSize() const
+{
+	return size;
+}
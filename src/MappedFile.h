@@ -0,0 +1,36 @@
+#pragma once
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file, pages are only read from disk when touched.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	// false when the file is missing, empty or can't be mapped
+	bool Open(const std::string& path);
+	void Close();
+
+	bool IsOpen() const;
+	const unsigned char* GetData() const;
+	std::size_t GetSize() const;
+
+private:
+	const unsigned char* data = nullptr;
+	std::size_t size = 0;
+
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#endif
+};
+
+#endif
@@ -0,0 +1,143 @@
+#include "Material.h"
+
+#include "GLStateCache.h"
+#include "Mesh.h"
+#include "TextureCache.h"
+
+#include <algorithm>
+
+Material::Material(const std::vector<Texture>& meshTextures)
+{
+	textureCount = static_cast<unsigned int>(std::min<std::size_t>(meshTextures.size(), MaxTextures));
+
+	for (unsigned int i = 0; i < textureCount; i++)
+	{
+		textures[i] = meshTextures[i].id;
+		slots[i] = -1;
+		unresolvedLayers |= 1u << i;
+
+		// the N in texture_diffuseN counts the textures of the same type before this one
+		const std::string& type = meshTextures[i].type;
+		if (type != "texture_diffuse" && type != "texture_specular" && type != "texture_normal" && type != "texture_height")
+		{
+			samplerNames[i] = type;
+			continue;
+		}
+
+		const auto number = std::count_if(meshTextures.begin(), meshTextures.begin() + i,
+			[&type](const Texture& texture) { return texture.type == type; }) + 1;
+		samplerNames[i] = type + std::to_string(number);
+
+		slots[i] = static_cast<std::int8_t>(BindlessTextures::GetSlot(samplerNames[i].c_str()));
+		if (slots[i] >= 0)
+			bindlessSlots[slots[i]] = textures[i];
+	}
+}
+
+TextureBindCounts Material::Bind(const Shader& shader) const
+{
+	TextureBindCounts counts;
+	if (textureCount == 0)
+		return counts;
+
+	const ShaderUnits& units = GetUnits(shader);
+
+	BindlessTextures& bindless = BindlessTextures::Default();
+	if (units.materialIndex.IsValid() && bindless.IsEnabled())
+	{
+		bindlessRow = bindless.GetRow(bindlessSlots, bindlessRow);
+		shader.setInt(units.materialIndex, bindlessRow);
+		return counts;
+	}
+
+	GLStateCache& glState = GLStateCache::Default();
+	ResolveLayers();
+
+	glm::ivec4 slotLayers(-1);
+	for (unsigned int i = 0; i < textureCount; i++)
+	{
+		bool bound = false;
+		if (layers[i].IsValid() && units.layerUnits[i] >= 0 && slots[i] >= 0)
+		{
+			bound = glState.BindTextureUnit(static_cast<unsigned int>(units.layerUnits[i]), GL_TEXTURE_2D_ARRAY, layers[i].array);
+			slotLayers[slots[i]] = layers[i].layer;
+		}
+		else if (units.units[i] >= 0)
+		{
+			// binding a name only reserved for an asynchronous load would give it a target before it can become a view,
+			// no texture samples black just like the empty one did
+			const unsigned int texture = (unresolvedLayers & (1u << i)) == 0 ? textures[i] : 0;
+			bound = glState.BindTextureUnit(static_cast<unsigned int>(units.units[i]), GL_TEXTURE_2D, texture);
+		}
+		else
+			continue;
+
+		if (bound)
+			counts.made++;
+		else
+			counts.skipped++;
+	}
+
+	if (units.materialLayers.IsValid())
+		shader.setIVec4(units.materialLayers, slotLayers);
+	return counts;
+}
+
+unsigned int Material::GetTextureCount() const
+{
+	return textureCount;
+}
+
+unsigned int Material::GetTexture(unsigned int index) const
+{
+	return textures[index];
+}
+
+TextureLayer Material::GetLayer(unsigned int index) const
+{
+	ResolveLayers();
+	return layers[index];
+}
+
+const std::string& Material::GetSamplerName(unsigned int index) const
+{
+	return samplerNames[index];
+}
+
+const Material::ShaderUnits& Material::GetUnits(const Shader& shader) const
+{
+	const unsigned int known = std::min(shaderCount, MaxShaders);
+	for (unsigned int i = 0; i < known; i++)
+	{
+		if (shaderUnits[i].program == shader.ID)
+			return shaderUnits[i];
+	}
+
+	ShaderUnits& units = shaderUnits[shaderCount++ % MaxShaders];
+	units.program = shader.ID;
+	units.materialLayers = shader.GetUniformId("materialLayers");
+	units.materialIndex = shader.GetUniformId("materialIndex");
+	for (unsigned int i = 0; i < textureCount; i++)
+	{
+		units.units[i] = static_cast<std::int8_t>(shader.GetSamplerUnit(samplerNames[i]));
+		units.layerUnits[i] = static_cast<std::int8_t>(shader.GetSamplerUnit(samplerNames[i] + "_layers"));
+	}
+	return units;
+}
+
+void Material::ResolveLayers() const
+{
+	if (unresolvedLayers == 0)
+		return;
+
+	// asynchronous loads upload their textures a few frames after the mesh was made
+	const TextureCache& textureCache = TextureCache::Default();
+	for (unsigned int i = 0; i < textureCount; i++)
+	{
+		if ((unresolvedLayers & (1u << i)) == 0 || !textureCache.IsUploaded(textures[i]))
+			continue;
+
+		layers[i] = textureCache.GetLayer(textures[i]);
+		unresolvedLayers &= ~(1u << i);
+	}
+}
@@ -0,0 +1,83 @@
+#pragma once
+#ifndef MATERIAL_H
+#define MATERIAL_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "BindlessTextures.h"
+#include "Shader.h"
+#include "TextureArrays.h"
+
+struct Texture;
+
+// binds the material made and found already bound
+struct TextureBindCounts
+{
+	unsigned int made = 0;
+	unsigned int skipped = 0;
+};
+
+// The textures of a mesh with the sampler each one is read through ("texture_diffuse1", ...), named once when the mesh is created.
+// Every shader assigns its samplers fixed units after linking, the units a material binds to are looked up once per shader,
+// so binding a material is a walk over a fixed array with no string building, lookups or allocation.
+// Textures packed into TextureArrays are bound as their array to the "<sampler>_layers" sampler where the shader has one,
+// with their layers in the materialLayers uniform, so materials sharing arrays share the binds.
+// While BindlessTextures are enabled a shader with a materialIndex uniform gets the material's row of handles instead.
+class Material
+{
+public:
+	static constexpr unsigned int MaxTextures = 8;
+	// shaders whose units are remembered, a further one replaces the oldest
+	static constexpr unsigned int MaxShaders = 4;
+
+	Material() = default;
+	// textures past MaxTextures are ignored
+	explicit Material(const std::vector<Texture>& textures);
+
+	// binds every texture the shader samples to the unit of its sampler, through the GLStateCache,
+	// or with bindless textures sets materialIndex, which binds nothing
+	TextureBindCounts Bind(const Shader& shader) const;
+
+	unsigned int GetTextureCount() const;
+	unsigned int GetTexture(unsigned int index) const;
+	// the array holding the texture, invalid until it is uploaded and for textures that were not packed
+	TextureLayer GetLayer(unsigned int index) const;
+	const std::string& GetSamplerName(unsigned int index) const;
+
+private:
+	struct ShaderUnits
+	{
+		unsigned int program = 0;
+		// -1 for textures the shader doesn't sample
+		std::int8_t units[MaxTextures] = {};
+		// units of the "_layers" array samplers, -1 where the shader has none
+		std::int8_t layerUnits[MaxTextures] = {};
+		UniformId materialLayers;
+		UniformId materialIndex;
+	};
+
+	const ShaderUnits& GetUnits(const Shader& shader) const;
+	// asks the TextureCache where the textures uploaded since the last call ended up
+	void ResolveLayers() const;
+
+	unsigned int textureCount = 0;
+	unsigned int textures[MaxTextures] = {};
+	std::string samplerNames[MaxTextures];
+
+	// BindlessTextures slot of each texture, -1 for none. materialLayers uses the same slots
+	std::int8_t slots[MaxTextures] = {};
+	mutable TextureLayer layers[MaxTextures];
+	// textures whose layer isn't known yet, one bit each
+	mutable unsigned int unresolvedLayers = 0;
+
+	// the textures by BindlessTextures slot and the row they were given
+	BindlessTextures::Slots bindlessSlots{};
+	mutable int bindlessRow = -1;
+
+	mutable ShaderUnits shaderUnits[MaxShaders];
+	mutable unsigned int shaderCount = 0;
+};
+
+#endif
@@ -1,172 +1,140 @@
 #include "Mesh.h"
 
+#include "GLStateCache.h"
+
 #include <glad/glad.h>
 #include <glm/gtc/matrix_transform.hpp>
+
+#include <utility>
 using namespace std;
 
 // constructor
-Mesh::Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, const glm::mat4* instanceMatrices, 
-	const unsigned amount)
+Mesh::Mesh(vector<Vertex> vertices, vector<unsigned int> indices, vector<Texture> textures, VertexCompression compression,
+	const glm::mat4* instanceMatrices, const unsigned amount)
 {
-	this->vertices = vertices;
-	this->indices = indices;
-	this->textures = textures;
+	this->vertices = std::move(vertices);
+	this->indices = std::move(indices);
+	this->textures = std::move(textures);
+	material = Material(this->textures);
+
+	if (!this->vertices.empty())
+	{
+		boundsMin = boundsMax = this->vertices.front().Position;
+		for (const auto& vertex : this->vertices)
+		{
+			boundsMin = glm::min(boundsMin, vertex.Position);
+			boundsMax = glm::max(boundsMax, vertex.Position);
+		}
+	}
 
 	// now that we have all the required data, set the vertex buffers and its attribute pointers.
-	setupMesh(instanceMatrices, amount);
+	setupMesh(compression, instanceMatrices, amount);
 }
 // render the mesh
 void Mesh::Draw( Shader& shader) const
 {
-	// bind appropriate textures
-	unsigned int diffuseNr = 1;
-	unsigned int specularNr = 1;
-	unsigned int normalNr = 1;
-	unsigned int heightNr = 1;
-
 	shader.use();
-	int i =0;
-	for (const auto& texture : textures)
-	{
-		glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-		// retrieve texture number (the N in diffuse_textureN)
-		string number;
-		string name = texture.type;
-		if (name == "texture_diffuse")
-			number = std::to_string(diffuseNr++);
-		else if (name == "texture_specular")
-			number = std::to_string(specularNr++); // transfer unsigned int to string
-		else if (name == "texture_normal")
-			number = std::to_string(normalNr++); // transfer unsigned int to string
-	
-		// now set the sampler to the correct texture unit
-		glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-		// and finally bind the texture
-		glBindTexture(GL_TEXTURE_2D, texture.id);
-		i++;
-	}
+	material.Bind(shader);
+	SetPositionTransform(shader);
 
-	// draw mesh
-	glBindVertexArray(VAO);
+	// draw mesh, the vertex array stays bound since every bind goes through the state cache
+	GLStateCache::Default().BindVertexArray(VAO);
 	glDrawElements(GL_TRIANGLES, static_cast<unsigned int>(indices.size()), GL_UNSIGNED_INT, 0);
-	glBindVertexArray(0);
-
-	// always good practice to set everything back to defaults once configured.
-	glActiveTexture(GL_TEXTURE0);
 }
 
-void Mesh::DrawInstanced(Shader& shader, const unsigned int amount) const
+void Mesh::DrawInstanced(Shader& shader, const unsigned int amount, const unsigned int baseInstance) const
 {
-	// bind appropriate textures
-	unsigned int diffuseNr = 1;
-	unsigned int specularNr = 1;
-	unsigned int normalNr = 1;
-	unsigned int heightNr = 1;
+	material.Bind(shader);
+	SetPositionTransform(shader);
 
-	for (unsigned int i = 0; i < textures.size(); i++)
-	{
-		glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
-		// retrieve texture number (the N in diffuse_textureN)
-		string number;
-		string name = textures[i].type;
-		if (name == "texture_diffuse")
-			number = std::to_string(diffuseNr++);
-		else if (name == "texture_specular")
-			number = std::to_string(specularNr++); // transfer unsigned int to string
-		else if (name == "texture_normal")
-			number = std::to_string(normalNr++); // transfer unsigned int to string
-		else if (name == "texture_height")
-			number = std::to_string(heightNr++); // transfer unsigned int to string
-
-		// now set the sampler to the correct texture unit
-		glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-		// and finally bind the texture
-		glBindTexture(GL_TEXTURE_2D, textures[i].id);
-	}
+	// draw mesh
+	GLStateCache::Default().BindVertexArray(VAO);
+	glDrawElementsInstancedBaseInstance(GL_TRIANGLES, static_cast<int>(indices.size()), GL_UNSIGNED_INT, nullptr, amount, baseInstance);
+}
 
+void Mesh::DrawIndirect(Shader& shader, const unsigned int indirectBuffer, const std::size_t commandOffset) const
+{
+	material.Bind(shader);
+	SetPositionTransform(shader);
 
-	// draw mesh
-	glBindVertexArray(VAO);
-	glDrawElementsInstanced(GL_TRIANGLES, static_cast<int>(indices.size()), GL_UNSIGNED_INT, nullptr, amount);
-	glBindVertexArray(0);
+	// draw mesh, the instance count comes from the command written on the GPU
+	GLStateCache::Default().BindVertexArray(VAO);
+	GLStateCache::Default().BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+	glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const void*>(commandOffset));
+}
 
-	// always good practice to set everything back to defaults once configured.
-	glActiveTexture(GL_TEXTURE0);
+DrawElementsIndirectCommand Mesh::GetIndirectCommand() const
+{
+	return { static_cast<unsigned int>(indices.size()), 0, 0, 0, 0 };
+}
 
+std::size_t Mesh::GetGpuBytes() const
+{
+	return gpuBytes;
 }
 
+void Mesh::DeleteBuffers()
+{
+	GLStateCache::Default().DeleteVertexArrays(1, &VAO);
+	GLStateCache::Default().DeleteBuffers(1, &VBO);
+	GLStateCache::Default().DeleteBuffers(1, &EBO);
+	if (instanceMatricesBuffer != 0)
+		GLStateCache::Default().DeleteBuffers(1, &instanceMatricesBuffer);
+
+	VAO = VBO = EBO = instanceMatricesBuffer = 0;
+	gpuBytes = 0;
+}
+
+void Mesh::SetPositionTransform(Shader& shader) const
+{
+	shader.setPositionTransform(layout.positionOffset, layout.positionScale);
+}
 
 // initializes all the buffer objects/arrays
-void Mesh::setupMesh(const glm::mat4* instanceMatrices, const unsigned amount)
+void Mesh::setupMesh(VertexCompression compression, const glm::mat4* instanceMatrices, const unsigned amount)
 {
+	layout = ChooseVertexLayout(vertices, boundsMin, boundsMax, compression);
+	gpuBytes = vertices.size() * layout.stride + indices.size() * sizeof(unsigned int);
+
 	if (amount > 1 && instanceMatrices != nullptr)
 	{
 		setupInstancedMesh(instanceMatrices, amount);
 	}
 	else 
 	{
-		// create buffers/arrays
-		glGenVertexArrays(1, &VAO);
-		glGenBuffers(1, &VBO);
-		glGenBuffers(1, &EBO);
-
-		glBindVertexArray(VAO);
-		// load data into vertex buffers
-		glBindBuffer(GL_ARRAY_BUFFER, VBO);
-		// A great thing about structs is that their memory layout is sequential for all its items.
-		// The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-		// again translates to 3/2 floats which translates to a byte array.
-		glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
-
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-		// set the vertex attribute pointers
-		// vertex Positions
-		glEnableVertexAttribArray(0);
-		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-		// vertex normals
-		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-		// vertex texture coords
-		glEnableVertexAttribArray(2);
-		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-
-		glBindVertexArray(0);
+		createBuffers();
+		GLStateCache::Default().BindVertexArray(0);
 	}
 }
 
-void Mesh::setupInstancedMesh(const glm::mat4* instanceMatrices, const unsigned int amount)
+void Mesh::createBuffers()
 {
+	// create buffers/arrays
 	glGenVertexArrays(1, &VAO);
 	glGenBuffers(1, &VBO);
 	glGenBuffers(1, &EBO);
 
-	glBindVertexArray(VAO);
-	// load data into vertex buffers
-	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	// A great thing about structs is that their memory layout is sequential for all its items.
-	// The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-	// again translates to 3/2 floats which translates to a byte array.
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+	GLStateCache::Default().BindVertexArray(VAO);
+	// load data into vertex buffers, encoded as the layout chosen for this mesh
+	const std::vector<unsigned char> packedVertices = PackVertices(vertices, layout);
+	GLStateCache::Default().BindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferData(GL_ARRAY_BUFFER, packedVertices.size(), packedVertices.data(), GL_STATIC_DRAW);
 
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+	GLStateCache::Default().BindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
 
 	// set the vertex attribute pointers
-	// vertex Positions
-	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-	// vertex normals
-	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-	// vertex texture coords
-	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+	ApplyVertexLayout(layout);
+}
+
+void Mesh::setupInstancedMesh(const glm::mat4* instanceMatrices, const unsigned int amount)
+{
+	createBuffers();
 
 	glGenBuffers(1, &instanceMatricesBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, instanceMatricesBuffer);
+	GLStateCache::Default().BindBuffer(GL_ARRAY_BUFFER, instanceMatricesBuffer);
 	glBufferData(GL_ARRAY_BUFFER, amount * sizeof(glm::mat4), instanceMatrices, GL_DYNAMIC_DRAW);
+	gpuBytes += amount * sizeof(glm::mat4);
 
 	// vertex attributes
 	const std::size_t vec4Size = sizeof(glm::vec4);
@@ -184,6 +152,6 @@ void Mesh::setupInstancedMesh(const glm::mat4* instanceMatrices, const unsigned
 	glVertexAttribDivisor(5, 1);
 	glVertexAttribDivisor(6, 1);
 
-	glBindVertexArray(0);
+	GLStateCache::Default().BindVertexArray(0);
 }
 
@@ -6,10 +6,13 @@
 
 #include <glm/glm.hpp>
 
+#include <cstddef>
 #include <string>
 #include <vector>
 
+#include "Material.h"
 #include "Shader.h"
+#include "VertexLayout.h"
 
 #define MAX_BONE_INFLUENCE 4
 
@@ -24,6 +27,15 @@ struct Vertex {
     // tangent
 };
 
+// layout expected by glDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+    unsigned int count;
+    unsigned int instanceCount;
+    unsigned int firstIndex;
+    unsigned int baseVertex;
+    unsigned int baseInstance;
+};
+
 struct Texture {
     unsigned int id;
     std::string type;
@@ -36,23 +48,51 @@ public:
     std::vector<Vertex>       vertices;
     std::vector<unsigned int> indices;
     std::vector<Texture>      textures;
+    // the textures with their samplers resolved, what drawing binds
+    Material material;
     unsigned int VAO;
 	unsigned int instanceMatricesBuffer = 0;
+    // axis aligned bounds of the vertex positions
+    glm::vec3 boundsMin = glm::vec3(0.0f);
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    // how the vertex buffer stores the vertices, see VertexLayout.h
+    VertexLayout layout;
 
-    // constructor
-    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures, const glm::mat4* instanceMatrices = nullptr,
-        const unsigned instanceCount = 1);
+    // constructor, compression picks the vertex buffer layout
+    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures,
+        VertexCompression compression = VertexCompression::None, const glm::mat4* instanceMatrices = nullptr, const unsigned instanceCount = 1);
     // render the mesh
     void Draw(Shader &shader) const;
 
-    void DrawInstanced(Shader& shader, const unsigned int amount) const;
+    // baseInstance offsets the instanced attributes, which lets several frames of instance data share one buffer
+    void DrawInstanced(Shader& shader, const unsigned int amount, const unsigned int baseInstance = 0) const;
+
+    // draws using the DrawElementsIndirectCommand found at commandOffset in indirectBuffer
+    void DrawIndirect(Shader& shader, const unsigned int indirectBuffer, const std::size_t commandOffset) const;
+
+    // command drawing the whole mesh, with no instances yet
+    DrawElementsIndirectCommand GetIndirectCommand() const;
+
+    // size of the vertex, index and instance buffers
+    std::size_t GetGpuBytes() const;
+
+    // points the shader at the layout's position dequantization
+    void SetPositionTransform(Shader& shader) const;
+
+    // deletes the GL objects, copies of the mesh share them so only the owner may call it
+    void DeleteBuffers();
 
 private:
     // render data 
     unsigned int VBO, EBO;
+    std::size_t gpuBytes = 0;
+
+    // creates the VAO with the vertex and index buffers
+    void createBuffers();
+
 
     // initializes all the buffer objects/arrays
-    void setupMesh(const glm::mat4* instanceMatrices = nullptr, const unsigned int amount = 1);
+    void setupMesh(VertexCompression compression, const glm::mat4* instanceMatrices = nullptr, const unsigned int amount = 1);
 
     void setupInstancedMesh(const glm::mat4* instanceMatrices, const unsigned int amount);
    
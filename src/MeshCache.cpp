@@ -0,0 +1,279 @@
+#include "MeshCache.h"
+
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	const char Magic[4] = { 'O', 'G', 'M', 'C' };
+
+	struct MeshCacheHeader
+	{
+		char magic[4];
+		std::uint32_t version;
+		std::uint64_t sourceHash;
+		std::uint32_t importFlags;
+		std::uint32_t vertexSize;
+		std::uint32_t meshCount;
+		std::uint32_t reserved;
+	};
+
+	// sequential reads out of the mapped file, every read fails once the data runs out
+	class CacheReader
+	{
+	public:
+		CacheReader(const unsigned char* data, std::size_t size) : data(data), size(size)
+		{
+		}
+
+		bool Read(void* destination, std::size_t bytes)
+		{
+			if (bytes > size - offset)
+				return false;
+
+			std::memcpy(destination, data + offset, bytes);
+			offset += bytes;
+			return true;
+		}
+
+		bool ReadString(std::string& text, std::uint32_t length)
+		{
+			if (length > size - offset)
+				return false;
+
+			text.assign(reinterpret_cast<const char*>(data + offset), length);
+			offset += length;
+			return true;
+		}
+
+		// whether count items of itemSize bytes fit in the rest of the data, checked before allocating room for them
+		bool HasRoomFor(std::size_t count, std::size_t itemSize) const
+		{
+			return itemSize == 0 || count <= (size - offset) / itemSize;
+		}
+
+		bool IsAtEnd() const
+		{
+			return offset == size;
+		}
+
+	private:
+		const unsigned char* data;
+		std::size_t size;
+		std::size_t offset = 0;
+	};
+
+	void Write(std::ofstream& out, const void* data, std::size_t bytes)
+	{
+		out.write(static_cast<const char*>(data), static_cast<std::streamsize>(bytes));
+	}
+
+	void WriteUint(std::ofstream& out, std::size_t value)
+	{
+		const auto narrowed = static_cast<std::uint32_t>(value);
+		Write(out, &narrowed, sizeof(narrowed));
+	}
+
+	// smallest mesh and texture records, counts are checked against them before anything is allocated
+	constexpr std::size_t MinMeshBytes = 3 * sizeof(std::uint32_t) + sizeof(MeshOptimizationStats);
+	constexpr std::size_t MinTextureBytes = 2 * sizeof(std::uint32_t);
+
+	bool IsObjFile(const std::string& path)
+	{
+		if (path.size() < 4)
+			return false;
+
+		std::string extension = path.substr(path.size() - 4);
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return extension == ".obj";
+	}
+
+	// the rest of every mtllib line, trimmed, the way Assimp reads a single library name
+	std::vector<std::string> FindMaterialLibraries(const unsigned char* data, std::size_t size)
+	{
+		static const char Keyword[] = "mtllib";
+		const auto isBlank = [](char c) { return c == ' ' || c == '\t' || c == '\r'; };
+
+		std::vector<std::string> libraries;
+		const char* text = reinterpret_cast<const char*>(data);
+		std::size_t lineStart = 0;
+		while (lineStart < size)
+		{
+			const char* lineEnd = static_cast<const char*>(std::memchr(text + lineStart, '\n', size - lineStart));
+			const std::size_t end = lineEnd != nullptr ? static_cast<std::size_t>(lineEnd - text) : size;
+
+			std::size_t begin = lineStart;
+			while (begin < end && isBlank(text[begin]))
+				begin++;
+
+			const std::size_t keywordLength = sizeof(Keyword) - 1;
+			if (end - begin > keywordLength && std::memcmp(text + begin, Keyword, keywordLength) == 0 && isBlank(text[begin + keywordLength]))
+			{
+				std::size_t nameBegin = begin + keywordLength;
+				std::size_t nameEnd = end;
+				while (nameBegin < nameEnd && isBlank(text[nameBegin]))
+					nameBegin++;
+				while (nameEnd > nameBegin && isBlank(text[nameEnd - 1]))
+					nameEnd--;
+				if (nameBegin < nameEnd)
+					libraries.emplace_back(text + nameBegin, nameEnd - nameBegin);
+			}
+
+			lineStart = end + 1;
+		}
+		return libraries;
+	}
+}
+
+std::uint64_t HashFnv1a(const void* data, std::size_t size, std::uint64_t seed)
+{
+	const auto* bytes = static_cast<const unsigned char*>(data);
+	std::uint64_t hash = seed;
+	for (std::size_t i = 0; i < size; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+bool HashFile(const std::string& path, std::uint64_t& hash)
+{
+	MappedFile file;
+	if (!file.Open(path))
+		return false;
+
+	hash = HashFnv1a(file.GetData(), file.GetSize());
+	return true;
+}
+
+bool HashModelSources(const std::string& path, std::uint64_t& hash)
+{
+	MappedFile file;
+	if (!file.Open(path))
+		return false;
+
+	hash = HashFnv1a(file.GetData(), file.GetSize());
+	if (!IsObjFile(path))
+		return true;
+
+	const std::size_t separator = path.find_last_of("/\\");
+	const std::string directory = separator == std::string::npos ? std::string() : path.substr(0, separator + 1);
+
+	// the name goes in as well, so a library that appears or goes away changes the hash
+	for (const std::string& library : FindMaterialLibraries(file.GetData(), file.GetSize()))
+	{
+		hash = HashFnv1a(library.data(), library.size(), hash);
+
+		MappedFile material;
+		if (material.Open(directory + library))
+			hash = HashFnv1a(material.GetData(), material.GetSize(), hash);
+	}
+	return true;
+}
+
+std::string GetMeshCachePath(const std::string& sourcePath)
+{
+	return sourcePath + ".meshcache";
+}
+
+bool ReadMeshCache(const std::string& cachePath, std::uint64_t sourceHash, unsigned int importFlags, std::vector<MeshCacheEntry>& meshes)
+{
+	MappedFile file;
+	if (!file.Open(cachePath))
+		return false;
+
+	CacheReader reader(file.GetData(), file.GetSize());
+
+	MeshCacheHeader header;
+	if (!reader.Read(&header, sizeof(header)) || std::memcmp(header.magic, Magic, sizeof(Magic)) != 0 ||
+		header.version != MeshCacheVersion || header.sourceHash != sourceHash || header.importFlags != importFlags ||
+		header.vertexSize != sizeof(Vertex) || !reader.HasRoomFor(header.meshCount, MinMeshBytes))
+		return false;
+
+	std::vector<MeshCacheEntry> entries(header.meshCount);
+	for (auto& entry : entries)
+	{
+		std::uint32_t counts[3];
+		if (!reader.Read(counts, sizeof(counts)) || !reader.Read(&entry.optimization, sizeof(entry.optimization)))
+			return false;
+
+		if (!reader.HasRoomFor(counts[2], MinTextureBytes))
+			return false;
+
+		entry.textures.resize(counts[2]);
+		for (auto& texture : entry.textures)
+		{
+			std::uint32_t lengths[2];
+			if (!reader.Read(lengths, sizeof(lengths)) || !reader.ReadString(texture.type, lengths[0]) || !reader.ReadString(texture.path, lengths[1]))
+				return false;
+			texture.id = 0;
+		}
+
+		// a single copy per blob straight out of the mapping, a damaged count must not size the vectors past the file
+		if (!reader.HasRoomFor(counts[0], sizeof(Vertex)))
+			return false;
+		entry.vertices.resize(counts[0]);
+		if (!reader.Read(entry.vertices.data(), entry.vertices.size() * sizeof(Vertex)) || !reader.HasRoomFor(counts[1], sizeof(unsigned int)))
+			return false;
+		entry.indices.resize(counts[1]);
+		if (!reader.Read(entry.indices.data(), entry.indices.size() * sizeof(unsigned int)))
+			return false;
+	}
+
+	if (!reader.IsAtEnd())
+		return false;
+
+	meshes = std::move(entries);
+	return true;
+}
+
+bool WriteMeshCache(const std::string& cachePath, std::uint64_t sourceHash, unsigned int importFlags, const std::vector<MeshCacheEntry>& meshes)
+{
+	// written under a temporary name first, so an interrupted write never leaves a truncated cache behind
+	const std::string temporaryPath = cachePath + ".tmp";
+	{
+		std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+		if (!out)
+			return false;
+
+		MeshCacheHeader header{};
+		std::memcpy(header.magic, Magic, sizeof(Magic));
+		header.version = MeshCacheVersion;
+		header.sourceHash = sourceHash;
+		header.importFlags = importFlags;
+		header.vertexSize = sizeof(Vertex);
+		header.meshCount = static_cast<std::uint32_t>(meshes.size());
+		Write(out, &header, sizeof(header));
+
+		for (const auto& mesh : meshes)
+		{
+			WriteUint(out, mesh.vertices.size());
+			WriteUint(out, mesh.indices.size());
+			WriteUint(out, mesh.textures.size());
+			Write(out, &mesh.optimization, sizeof(mesh.optimization));
+
+			for (const auto& texture : mesh.textures)
+			{
+				WriteUint(out, texture.type.size());
+				WriteUint(out, texture.path.size());
+				Write(out, texture.type.data(), texture.type.size());
+				Write(out, texture.path.data(), texture.path.size());
+			}
+
+			Write(out, mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+			Write(out, mesh.indices.data(), mesh.indices.size() * sizeof(unsigned int));
+		}
+
+		if (!out)
+			return false;
+	}
+
+	std::remove(cachePath.c_str());
+	return std::rename(temporaryPath.c_str(), cachePath.c_str()) == 0;
+}
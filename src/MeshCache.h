@@ -0,0 +1,48 @@
+#pragma once
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+
+// Binary cache of imported models, so Assimp only runs when the source file or the import flags change.
+// Layout, native endianness:
+//   header: magic "OGMC", version, FNV-1a hash of the source files, import flags, sizeof(Vertex), mesh count
+//   per mesh: vertex count, index count, texture count, optimization stats,
+//             per texture: type length, path length, type and path characters,
+//             vertex blob, index blob
+constexpr std::uint32_t MeshCacheVersion = 2;
+
+// mesh data read from the cache, textures only carry their type and path, their ids are left to the model
+struct MeshCacheEntry
+{
+	std::vector<Vertex> vertices;
+	std::vector<unsigned int> indices;
+	std::vector<Texture> textures;
+	MeshOptimizationStats optimization;
+};
+
+// 64 bit FNV-1a, pass the previous hash as seed to continue hashing
+std::uint64_t HashFnv1a(const void* data, std::size_t size, std::uint64_t seed = 14695981039346656037ull);
+
+// hashes the whole file through a memory mapping, false when it can't be read
+bool HashFile(const std::string& path, std::uint64_t& hash);
+
+// HashFile of the model, continued with the material libraries named by the mtllib lines of a Wavefront .obj,
+// which Assimp reads as well. false when the model can't be read, a missing library only changes the hash
+bool HashModelSources(const std::string& path, std::uint64_t& hash);
+
+std::string GetMeshCachePath(const std::string& sourcePath);
+
+// false on a missing, stale or damaged cache: other source hash, import flags, version or vertex layout,
+// or counts the file is too short to hold
+bool ReadMeshCache(const std::string& cachePath, std::uint64_t sourceHash, unsigned int importFlags, std::vector<MeshCacheEntry>& meshes);
+
+bool WriteMeshCache(const std::string& cachePath, std::uint64_t sourceHash, unsigned int importFlags, const std::vector<MeshCacheEntry>& meshes);
+
+#endif
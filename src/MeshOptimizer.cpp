@@ -0,0 +1,350 @@
+#include "MeshOptimizer.h"
+
+#include "CpuProfiler.h"
+#include "MeshCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <utility>
+
+namespace
+{
+	constexpr unsigned int InvalidIndex = ~0u;
+
+	// LRU cache Forsyth's scores model, larger than the measured FIFO on purpose as the paper suggests
+	constexpr int ForsythCacheSize = 32;
+	constexpr float LastTriangleScore = 0.75f;
+	constexpr float CacheDecayPower = 1.5f;
+	constexpr float ValenceBoostScale = 2.0f;
+	constexpr float ValenceBoostPower = 0.5f;
+
+	// the three most recent vertices score the same, so the next triangle does not simply reuse the last edge
+	float VertexScore(int cachePosition, unsigned int remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+				score = LastTriangleScore;
+			else
+			{
+				const float scale = 1.0f / (ForsythCacheSize - 3);
+				score = std::pow(1.0f - (cachePosition - 3) * scale, CacheDecayPower);
+			}
+		}
+
+		// vertices with few triangles left are finished first, so they don't linger as lone triangles
+		return score + ValenceBoostScale * std::pow(static_cast<float>(remainingTriangles), -ValenceBoostPower);
+	}
+
+	glm::vec3 Cross(const glm::vec3& a, const glm::vec3& b)
+	{
+		return glm::vec3(a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x);
+	}
+
+	float Dot(const glm::vec3& a, const glm::vec3& b)
+	{
+		return a.x * b.x + a.y * b.y + a.z * b.z;
+	}
+}
+
+VertexCacheMetrics MeasureVertexCache(const std::vector<unsigned int>& indices, std::size_t vertexCount, std::size_t cacheSize)
+{
+	VertexCacheMetrics metrics;
+	if (indices.size() < 3 || vertexCount == 0)
+		return metrics;
+
+	// a vertex is still cached while fewer than cacheSize misses happened since its own
+	std::vector<std::size_t> missTimes(vertexCount, 0);
+	std::size_t time = cacheSize + 1;
+	std::size_t misses = 0;
+	for (unsigned int index : indices)
+	{
+		if (time - missTimes[index] > cacheSize)
+		{
+			missTimes[index] = time++;
+			misses++;
+		}
+	}
+
+	metrics.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+	metrics.atvr = static_cast<float>(misses) / static_cast<float>(vertexCount);
+	return metrics;
+}
+
+void DeduplicateVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	if (vertices.empty())
+		return;
+
+	// open addressing over the vertex bytes, the table stays at most half full
+	std::size_t tableSize = 1;
+	while (tableSize < vertices.size() * 2)
+		tableSize *= 2;
+	std::vector<unsigned int> table(tableSize, InvalidIndex);
+
+	std::vector<unsigned int> remap(vertices.size());
+	std::vector<Vertex> unique;
+	unique.reserve(vertices.size());
+
+	for (std::size_t i = 0; i < vertices.size(); i++)
+	{
+		std::size_t slot = HashFnv1a(&vertices[i], sizeof(Vertex)) & (tableSize - 1);
+		while (table[slot] != InvalidIndex && std::memcmp(&unique[table[slot]], &vertices[i], sizeof(Vertex)) != 0)
+			slot = (slot + 1) & (tableSize - 1);
+
+		if (table[slot] == InvalidIndex)
+		{
+			table[slot] = static_cast<unsigned int>(unique.size());
+			unique.push_back(vertices[i]);
+		}
+		remap[i] = table[slot];
+	}
+
+	for (unsigned int& index : indices)
+		index = remap[index];
+	vertices = std::move(unique);
+}
+
+void OptimizeVertexCache(std::vector<unsigned int>& indices, std::size_t vertexCount)
+{
+	const std::size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+		return;
+
+	// triangles of every vertex, the live ones kept at the front of each vertex's range
+	std::vector<unsigned int> remaining(vertexCount, 0);
+	for (unsigned int index : indices)
+		remaining[index]++;
+
+	std::vector<unsigned int> adjacencyOffsets(vertexCount + 1, 0);
+	for (std::size_t v = 0; v < vertexCount; v++)
+		adjacencyOffsets[v + 1] = adjacencyOffsets[v] + remaining[v];
+
+	std::vector<unsigned int> adjacency(indices.size());
+	std::vector<unsigned int> filled(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for (std::size_t t = 0; t < triangleCount; t++)
+	{
+		for (int corner = 0; corner < 3; corner++)
+			adjacency[filled[indices[t * 3 + corner]]++] = static_cast<unsigned int>(t);
+	}
+
+	std::vector<int> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for (std::size_t v = 0; v < vertexCount; v++)
+		vertexScores[v] = VertexScore(-1, remaining[v]);
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<bool> emitted(triangleCount, false);
+	for (std::size_t t = 0; t < triangleCount; t++)
+		triangleScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+
+	std::vector<unsigned int> cache;
+	std::vector<unsigned int> nextCache;
+	cache.reserve(ForsythCacheSize + 3);
+	nextCache.reserve(ForsythCacheSize + 3);
+
+	std::vector<unsigned int> optimized;
+	optimized.reserve(indices.size());
+
+	unsigned int best = static_cast<unsigned int>(std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin());
+	// when no cached vertex has triangles left the next one is taken in input order, which keeps this linear
+	std::size_t cursor = 0;
+
+	for (std::size_t count = 0; count < triangleCount; count++)
+	{
+		if (best == InvalidIndex)
+		{
+			while (emitted[cursor])
+				cursor++;
+			best = static_cast<unsigned int>(cursor);
+		}
+
+		emitted[best] = true;
+		const unsigned int* triangle = &indices[best * 3];
+		optimized.insert(optimized.end(), triangle, triangle + 3);
+
+		for (int corner = 0; corner < 3; corner++)
+		{
+			const unsigned int vertex = triangle[corner];
+			unsigned int* begin = &adjacency[adjacencyOffsets[vertex]];
+			unsigned int* end = begin + remaining[vertex];
+			std::iter_swap(std::find(begin, end, best), end - 1);
+			remaining[vertex]--;
+		}
+
+		// the triangle's vertices move to the front of the LRU cache
+		nextCache.assign(triangle, triangle + 3);
+		for (unsigned int vertex : cache)
+		{
+			if (vertex != triangle[0] && vertex != triangle[1] && vertex != triangle[2])
+				nextCache.push_back(vertex);
+		}
+
+		for (std::size_t i = 0; i < nextCache.size(); i++)
+		{
+			const unsigned int vertex = nextCache[i];
+			cachePositions[vertex] = i < static_cast<std::size_t>(ForsythCacheSize) ? static_cast<int>(i) : -1;
+			vertexScores[vertex] = VertexScore(cachePositions[vertex], remaining[vertex]);
+		}
+
+		// only triangles touching a changed vertex changed their score
+		best = InvalidIndex;
+		float bestScore = -1.0f;
+		for (unsigned int vertex : nextCache)
+		{
+			const unsigned int* begin = &adjacency[adjacencyOffsets[vertex]];
+			for (const unsigned int* t = begin; t != begin + remaining[vertex]; t++)
+			{
+				const unsigned int* corners = &indices[*t * 3];
+				triangleScores[*t] = vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+				if (triangleScores[*t] > bestScore)
+				{
+					bestScore = triangleScores[*t];
+					best = *t;
+				}
+			}
+		}
+
+		nextCache.resize(std::min(nextCache.size(), static_cast<std::size_t>(ForsythCacheSize)));
+		std::swap(cache, nextCache);
+	}
+
+	indices = std::move(optimized);
+}
+
+void OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, float threshold)
+{
+	const std::size_t triangleCount = indices.size() / 3;
+	if (triangleCount < 2)
+		return;
+
+	const float inputAcmr = MeasureVertexCache(indices, vertices.size()).acmr;
+
+	// a cluster ends once its own ACMR, counted from an empty cache, is down to threshold times the mesh's.
+	// every cluster then pays for warming up the cache itself, so the clusters can be drawn in any order for about the same cost
+	std::vector<std::size_t> clusterStarts = { 0 };
+	std::vector<std::size_t> missTimes(vertices.size(), 0);
+	std::size_t time = MeasuredCacheSize + 1;
+	std::size_t clusterMisses = 0;
+	for (std::size_t t = 0; t < triangleCount; t++)
+	{
+		for (int corner = 0; corner < 3; corner++)
+		{
+			const unsigned int vertex = indices[t * 3 + corner];
+			if (time - missTimes[vertex] > MeasuredCacheSize)
+			{
+				missTimes[vertex] = time++;
+				clusterMisses++;
+			}
+		}
+
+		const float clusterAcmr = static_cast<float>(clusterMisses) / static_cast<float>(t + 1 - clusterStarts.back());
+		if (clusterAcmr <= inputAcmr * threshold && t + 1 < triangleCount)
+		{
+			clusterStarts.push_back(t + 1);
+			clusterMisses = 0;
+			// ages every cached vertex out
+			time += MeasuredCacheSize + 1;
+		}
+	}
+	if (clusterStarts.size() < 2)
+		return;
+	clusterStarts.push_back(triangleCount);
+
+	// area weighted centroid and normal of every cluster, and the centroid of the whole mesh
+	const std::size_t clusterCount = clusterStarts.size() - 1;
+	std::vector<glm::vec3> clusterCentroids(clusterCount, glm::vec3(0.0f));
+	std::vector<glm::vec3> clusterNormals(clusterCount, glm::vec3(0.0f));
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+
+	for (std::size_t c = 0; c < clusterCount; c++)
+	{
+		float clusterArea = 0.0f;
+		for (std::size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+		{
+			const glm::vec3& a = vertices[indices[t * 3]].Position;
+			const glm::vec3& b = vertices[indices[t * 3 + 1]].Position;
+			const glm::vec3& d = vertices[indices[t * 3 + 2]].Position;
+
+			const glm::vec3 normal = Cross(b - a, d - a);
+			const float area = std::sqrt(Dot(normal, normal));
+			const glm::vec3 centroid = (a + b + d) * (1.0f / 3.0f);
+
+			clusterCentroids[c] += centroid * area;
+			clusterNormals[c] += normal;
+			clusterArea += area;
+		}
+
+		meshCentroid += clusterCentroids[c];
+		meshArea += clusterArea;
+		if (clusterArea > 0.0f)
+			clusterCentroids[c] = clusterCentroids[c] * (1.0f / clusterArea);
+	}
+	if (meshArea > 0.0f)
+		meshCentroid = meshCentroid * (1.0f / meshArea);
+
+	// clusters far out on the side they face are likely to occlude the others
+	std::vector<float> sortKeys(clusterCount);
+	for (std::size_t c = 0; c < clusterCount; c++)
+	{
+		const float length = std::sqrt(Dot(clusterNormals[c], clusterNormals[c]));
+		sortKeys[c] = length > 0.0f ? Dot(clusterCentroids[c] - meshCentroid, clusterNormals[c]) / length : 0.0f;
+	}
+
+	std::vector<std::size_t> order(clusterCount);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&sortKeys](std::size_t a, std::size_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<unsigned int> sorted;
+	sorted.reserve(indices.size());
+	for (std::size_t c : order)
+		sorted.insert(sorted.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+
+	if (MeasureVertexCache(sorted, vertices.size()).acmr <= inputAcmr * threshold)
+		indices = std::move(sorted);
+}
+
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	std::vector<unsigned int> remap(vertices.size(), InvalidIndex);
+	std::vector<Vertex> ordered;
+	ordered.reserve(vertices.size());
+
+	// vertices no index refers to are dropped
+	for (unsigned int& index : indices)
+	{
+		if (remap[index] == InvalidIndex)
+		{
+			remap[index] = static_cast<unsigned int>(ordered.size());
+			ordered.push_back(vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	vertices = std::move(ordered);
+}
+
+MeshOptimizationStats OptimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices)
+{
+	CPU_PROFILE_SCOPE("OptimizeMesh");
+
+	MeshOptimizationStats stats;
+	stats.verticesBefore = static_cast<unsigned int>(vertices.size());
+	stats.before = MeasureVertexCache(indices, vertices.size());
+
+	DeduplicateVertices(vertices, indices);
+	OptimizeVertexCache(indices, vertices.size());
+	OptimizeOverdraw(indices, vertices);
+	OptimizeVertexFetch(vertices, indices);
+
+	stats.verticesAfter = static_cast<unsigned int>(vertices.size());
+	stats.after = MeasureVertexCache(indices, vertices.size());
+	return stats;
+}
@@ -0,0 +1,49 @@
+#pragma once
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <cstddef>
+#include <vector>
+
+#include "Mesh.h"
+
+// FIFO post-transform cache the metrics are measured with, about what current GPUs behave like
+constexpr std::size_t MeasuredCacheSize = 16;
+
+// cache misses per triangle (ACMR, 0.5 at best) and per vertex (ATVR, 1.0 at best) of an index buffer
+struct VertexCacheMetrics
+{
+	float acmr = 0.0f;
+	float atvr = 0.0f;
+};
+
+// what OptimizeMesh did to one mesh, kept in the mesh cache so cached loads can report it too
+struct MeshOptimizationStats
+{
+	unsigned int verticesBefore = 0;
+	unsigned int verticesAfter = 0;
+	VertexCacheMetrics before;
+	VertexCacheMetrics after;
+};
+
+VertexCacheMetrics MeasureVertexCache(const std::vector<unsigned int>& indices, std::size_t vertexCount,
+	std::size_t cacheSize = MeasuredCacheSize);
+
+// merges bitwise identical vertices and rewrites the indices to the survivors
+void DeduplicateVertices(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+// reorders the triangles for the post-transform cache with Forsyth's linear speed algorithm
+void OptimizeVertexCache(std::vector<unsigned int>& indices, std::size_t vertexCount);
+
+// splits the cache optimized triangles into clusters that each reach about the input's ACMR from a cold cache,
+// then draws the outward facing clusters first, so they hide more of the rest.
+// kept only while the ACMR stays within threshold of the input's
+void OptimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices, float threshold = 1.05f);
+
+// renumbers the vertices in the order the indices first use them, so vertex fetch reads memory linearly
+void OptimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+// every step above in order, measuring the index buffer before and after
+MeshOptimizationStats OptimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
+
+#endif
@@ -1,13 +1,19 @@
 #include "Model.h"
 
+#include "AsyncLoader.h"
+#include "CpuProfiler.h"
+#include "MeshCache.h"
+#include "TextureCache.h"
+#include "TextureLoader.h"
+
 #include <glad/glad.h> 
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <stb_image.h>
 
 #include <assimp/postprocess.h>
 
+#include <chrono>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -16,14 +22,123 @@
 #include <vector>
 using namespace std;
 
+namespace
+{
+	// part of the mesh cache key, a cache written with other flags is never used
+	constexpr unsigned int ImportFlags = aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace;
+}
+
+struct ModelLoadState
+{
+	// only read and written on the GL thread, cleared when the model is destroyed
+	Model* owner = nullptr;
+	string path;
+	chrono::steady_clock::time_point start;
+};
 
 
 // constructor, expects a filepath to a 3D model.
-Model::Model(string const& path, bool gamma, const glm::mat4* instanceMatrices, const unsigned amount) : gammaCorrection(gamma)
+Model::Model(string const& path, bool gamma, VertexCompression compression, const glm::mat4* instanceMatrices, const unsigned amount) :
+	gammaCorrection(gamma), vertexCompression(compression)
 {
 	LoadModel(path);
 }
 
+Model::Model(string const& path, AsyncLoader& loader, bool gamma, VertexCompression compression) :
+	gammaCorrection(gamma), vertexCompression(compression), state(ModelState::Pending)
+{
+	directory = path.substr(0, path.find_last_of('/'));
+
+	loadState = make_shared<ModelLoadState>();
+	loadState->owner = this;
+	loadState->path = path;
+	loadState->start = chrono::steady_clock::now();
+
+	// the tasks only hold the shared state, never the model itself
+	const shared_ptr<ModelLoadState> shared = loadState;
+	const string modelDirectory = directory;
+	loader.Enqueue([shared, path, modelDirectory, &loader]()
+	{
+		auto entries = make_shared<vector<MeshCacheEntry>>();
+		bool fromCache = false;
+		if (!ImportMeshData(path, *entries, fromCache))
+		{
+			loader.EnqueueUpload([shared]()
+			{
+				if (shared->owner)
+					shared->owner->state = ModelState::Failed;
+			});
+			return;
+		}
+
+		loader.EnqueueUpload([shared, entries, fromCache, modelDirectory, &loader]()
+		{
+			Model* model = shared->owner;
+			if (!model)
+				return;
+
+			// the meshes get the GL names of their textures right away, only the ones new to the cache are decoded
+			vector<PendingTexture> texturesToDecode;
+			model->loadedFromCache = fromCache;
+			model->CreateMeshes(*entries, &texturesToDecode);
+			model->pendingTextures = texturesToDecode.size();
+			model->UpdateLoadState();
+
+			const bool gamma = model->gammaCorrection;
+			for (const auto& pending : texturesToDecode)
+			{
+				loader.Enqueue([shared, pending, modelDirectory, gamma, &loader]()
+				{
+					auto texture = make_shared<DecodedTexture>();
+					const bool decoded = LoadTextureFile(modelDirectory + '/' + pending.path, *texture, true, gamma);
+
+					loader.EnqueueUpload([shared, pending, texture, decoded]()
+					{
+						// other models may already share the texture, so it is filled even when this one is gone
+						if (decoded)
+							TextureCache::Default().Upload(pending.id, *texture);
+						else
+							cout << "Texture failed to load at path: " << pending.path << endl;
+
+						if (shared->owner)
+							shared->owner->FinishTexture();
+					});
+				});
+			}
+		});
+	});
+}
+
+Model::~Model()
+{
+	if (loadState)
+		loadState->owner = nullptr;
+
+	for (const auto& texture : textures_loaded)
+		TextureCache::Default().Release(texture.id);
+
+	for (auto& mesh : meshes)
+		mesh.DeleteBuffers();
+}
+
+ModelState Model::GetState() const
+{
+	return state;
+}
+
+std::size_t Model::GetGpuBytes() const
+{
+	std::size_t bytes = 0;
+	for (const auto& mesh : meshes)
+		bytes += mesh.GetGpuBytes();
+	return bytes;
+}
+
+bool Model::IsReady() const
+{
+	return state == ModelState::Ready;
+}
+
 // draws the model, and thus all its meshes
 void Model::Draw(Shader& shader)
 {
@@ -31,35 +146,154 @@ void Model::Draw(Shader& shader)
 		meshes[i].Draw(shader);
 }
 
-void Model::DrawInstanced(Shader& shader, const unsigned int amount)
+void Model::DrawInstanced(Shader& shader, const unsigned int amount, const unsigned int baseInstance)
 {
 	for(const auto& mesh: meshes)
 	{
-		mesh.DrawInstanced(shader, amount);
+		mesh.DrawInstanced(shader, amount, baseInstance);
 	}
 }
 
+void Model::DrawIndirect(Shader& shader, const unsigned int indirectBuffer)
+{
+	for (std::size_t i = 0; i < meshes.size(); i++)
+		meshes[i].DrawIndirect(shader, indirectBuffer, i * sizeof(DrawElementsIndirectCommand));
+}
+
 // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
 void Model::LoadModel(string const& path)
 {
+	CPU_PROFILE_SCOPE("Model::LoadModel");
+
+	const auto start = chrono::steady_clock::now();
+
+	// retrieve the directory path of the filepath
+	directory = path.substr(0, path.find_last_of('/'));
+
+	vector<MeshCacheEntry> entries;
+	if (!ImportMeshData(path, entries, loadedFromCache))
+	{
+		state = ModelState::Failed;
+		return;
+	}
+
+	CreateMeshes(entries, nullptr);
+
+	loadMilliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+	cout << "Model " << path << (loadedFromCache ? " loaded from the mesh cache" : " imported") << " in " << loadMilliseconds << " ms" << endl;
+}
+
+bool Model::ImportMeshData(const string& path, vector<MeshCacheEntry>& entries, bool& fromCache)
+{
+	// the cache is keyed by the source contents, so an edited model is imported again
+	const string cachePath = GetMeshCachePath(path);
+	std::uint64_t sourceHash = 0;
+	const bool hashed = HashModelSources(path, sourceHash);
+
+	fromCache = hashed && ReadMeshCache(cachePath, sourceHash, ImportFlags, entries);
+	if (fromCache)
+	{
+		ReportOptimization(path, entries);
+		return true;
+	}
+
 	// read file via ASSIMP
 	Assimp::Importer importer;
-	const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_GenSmoothNormals | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+	const aiScene* scene = importer.ReadFile(path, ImportFlags);
 	// check for errors
 	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
 	{
 		cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << endl;
-		return;
+		return false;
 	}
-	// retrieve the directory path of the filepath
-	directory = path.substr(0, path.find_last_of('/'));
 
 	// process ASSIMP's root node recursively
-	ProcessNode(scene->mRootNode, scene);
+	ProcessNode(scene->mRootNode, scene, entries);
+
+	// Assimp's own JoinIdenticalVertices and ImproveCacheLocality are left out, this pass covers both
+	for (auto& entry : entries)
+		entry.optimization = OptimizeMesh(entry.vertices, entry.indices);
+	ReportOptimization(path, entries);
+
+	if (hashed && !WriteMeshCache(cachePath, sourceHash, ImportFlags, entries))
+		cout << "ERROR::MODEL::MESH_CACHE_NOT_WRITTEN " << cachePath << endl;
+
+	return true;
+}
+
+void Model::ReportOptimization(const string& path, const vector<MeshCacheEntry>& entries)
+{
+	for (size_t i = 0; i < entries.size(); i++)
+	{
+		const MeshOptimizationStats& stats = entries[i].optimization;
+		cout << "Model " << path << " mesh " << i << ": " << stats.verticesBefore << " -> " << stats.verticesAfter << " vertices, ACMR "
+			<< stats.before.acmr << " -> " << stats.after.acmr << ", ATVR " << stats.before.atvr << " -> " << stats.after.atvr << endl;
+	}
+}
+
+void Model::CreateMeshes(vector<MeshCacheEntry>& entries, vector<PendingTexture>* texturesToDecode)
+{
+	meshes.reserve(entries.size());
+	for (auto& entry : entries)
+	{
+		vector<Texture> textures;
+		textures.reserve(entry.textures.size());
+		for (const auto& reference : entry.textures)
+		{
+			if (texturesToDecode)
+				textures.push_back(ReserveTexture(reference.path.c_str(), reference.type, *texturesToDecode));
+			else
+				textures.push_back(LoadTexture(reference.path.c_str(), reference.type));
+		}
+
+		meshes.emplace_back(std::move(entry.vertices), std::move(entry.indices), std::move(textures), vertexCompression);
+	}
+
+	ComputeBounds();
+}
+
+void Model::FinishTexture()
+{
+	pendingTextures--;
+	UpdateLoadState();
+}
+
+void Model::UpdateLoadState()
+{
+	if (pendingTextures > 0)
+		return;
+
+	state = ModelState::Ready;
+	loadMilliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - loadState->start).count();
+	cout << "Model " << loadState->path << (loadedFromCache ? " loaded from the mesh cache" : " imported")
+		<< " in the background in " << loadMilliseconds << " ms" << endl;
+}
+
+void Model::ComputeBounds()
+{
+	if (meshes.empty())
+		return;
+
+	glm::vec3 boundsMin = meshes.front().boundsMin;
+	glm::vec3 boundsMax = meshes.front().boundsMax;
+	for (const auto& mesh : meshes)
+	{
+		boundsMin = glm::min(boundsMin, mesh.boundsMin);
+		boundsMax = glm::max(boundsMax, mesh.boundsMax);
+	}
+
+	// centered on the box, but the radius only has to reach the farthest vertex, not the box corner
+	boundingCenter = (boundsMin + boundsMax) * 0.5f;
+	boundingRadius = 0.0f;
+	for (const auto& mesh : meshes)
+	{
+		for (const auto& vertex : mesh.vertices)
+			boundingRadius = glm::max(boundingRadius, glm::length(vertex.Position - boundingCenter));
+	}
 }
 
 // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-void Model::ProcessNode(aiNode* node, const aiScene* scene)
+void Model::ProcessNode(aiNode* node, const aiScene* scene, vector<MeshCacheEntry>& entries)
 {
 	// process each mesh located at the current node
 	for (unsigned int i = 0; i < node->mNumMeshes; i++)
@@ -67,23 +301,26 @@ void Model::ProcessNode(aiNode* node, const aiScene* scene)
 		// the node object only contains indices to index the actual objects in the scene. 
 		// the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
 		aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-		meshes.push_back(ProcessMesh(mesh, scene));
+		entries.push_back(ProcessMesh(mesh, scene));
 	}
 	// after we've processed all of the meshes (if any) we then recursively process each of the children nodes
 	for (unsigned int i = 0; i < node->mNumChildren; i++)
 	{
-		ProcessNode(node->mChildren[i], scene);
+		ProcessNode(node->mChildren[i], scene, entries);
 	}
 
 }
 
-Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
+MeshCacheEntry Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
 {
 	// data to fill
 	vector<Vertex> vertices;
 	vector<unsigned int> indices;
 	vector<Texture> textures;
 
+	vertices.reserve(mesh->mNumVertices);
+	indices.reserve(static_cast<std::size_t>(mesh->mNumFaces) * 3);
+
 	// walk through each of the mesh's vertices
 	for (unsigned int i = 0; i < mesh->mNumVertices; i++)
 	{
@@ -149,10 +386,10 @@ Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
 	textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
 
 	// return a mesh object created from the extracted mesh data
-	return{vertices, indices, textures};
+	return{std::move(vertices), std::move(indices), std::move(textures)};
 }
 
-// checks all material textures of a given type and loads the textures if they're not loaded yet.
+// collects all material textures of a given type, they are loaded once the meshes are created.
 // the required info is returned as a Texture struct.
 vector<Texture> Model::LoadMaterialTextures(aiMaterial* mat, aiTextureType type, string typeName)
 {
@@ -161,67 +398,39 @@ vector<Texture> Model::LoadMaterialTextures(aiMaterial* mat, aiTextureType type,
 	{
 		aiString str;
 		mat->GetTexture(type, i, &str);
-		// check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-		bool skip = false;
-		for (unsigned int j = 0; j < textures_loaded.size(); j++)
-		{
-			if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0)
-			{
-				textures.push_back(textures_loaded[j]);
-				skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-				break;
-			}
-		}
-		if (!skip)
-		{   // if texture hasn't been loaded already, load it
-			Texture texture;
-			texture.id = TextureFromFile(str.C_Str(), this->directory);
-			texture.type = typeName;
-			texture.path = str.C_Str();
-			textures.push_back(texture);
-			textures_loaded.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-		}
+
+		Texture texture;
+		texture.id = 0;
+		texture.type = typeName;
+		texture.path = str.C_Str();
+		textures.push_back(texture);
 	}
 	return textures;
 }
 
-
-unsigned int TextureFromFile(const char* path, const string& directory, bool gamma)
+Texture Model::LoadTexture(const char* path, const string& typeName)
 {
-	string filename = string(path);
-	filename = directory + '/' + filename;
+	// the cache decodes every image only once, whichever model asks for it
+	Texture texture;
+	texture.id = TextureCache::Default().Acquire(directory + '/' + path, gammaCorrection);
+	texture.type = typeName;
+	texture.path = path;
+	textures_loaded.push_back(texture);  // every reference the model holds, given back when it is destroyed
+	return texture;
+}
 
-	unsigned int textureID;
-	glGenTextures(1, &textureID);
+Texture Model::ReserveTexture(const char* path, const string& typeName, vector<PendingTexture>& texturesToDecode)
+{
+	bool isNew = false;
 
-	int width, height, nrComponents;
-	unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-	if (data)
-	{
-		GLenum format;
-		if (nrComponents == 1)
-			format = GL_RED;
-		else if (nrComponents == 3)
-			format = GL_RGB;
-		else if (nrComponents == 4)
-			format = GL_RGBA;
-
-		glBindTexture(GL_TEXTURE_2D, textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		stbi_image_free(data);
-	}
-	else
-	{
-		std::cout << "Texture failed to load at path: " << path << std::endl;
-		stbi_image_free(data);
-	}
+	// sampling the name before the decoded image arrives reads black
+	Texture texture;
+	texture.id = TextureCache::Default().Reserve(directory + '/' + path, gammaCorrection, isNew);
+	texture.type = typeName;
+	texture.path = path;
+	textures_loaded.push_back(texture);
 
-	return textureID;
-}
\ No newline at end of file
+	if (isNew)
+		texturesToDecode.push_back({ texture.id, texture.path });
+	return texture;
+}
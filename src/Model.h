@@ -6,44 +6,120 @@
 #include <assimp/scene.h>
 
 #include "Mesh.h"
+#include "MeshCache.h"
 #include "Shader.h"
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <fstream>
 #include <vector>
 
+class AsyncLoader;
+struct ModelLoadState;
 
-unsigned int TextureFromFile(const char *path, const std::string &directory, bool gamma = false);
+enum class ModelState
+{
+    // still loading in the background, meshes appear once parsed and their textures fill in as they are decoded
+    Pending,
+    Ready,
+    // the file could not be imported, the model has no meshes
+    Failed
+};
 
 class Model 
 {
 public:
     // model data 
-    std::vector<Texture> textures_loaded;	// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+    std::vector<Texture> textures_loaded;	// every texture reference the model holds in the TextureCache, released with the model
     std::vector<Mesh>    meshes;
     std::string directory;
     bool gammaCorrection;
+    // vertex buffer layout of the meshes, see VertexLayout.h
+    VertexCompression vertexCompression = VertexCompression::None;
+    // sphere enclosing all meshes, in model space
+    glm::vec3 boundingCenter = glm::vec3(0.0f);
+    float boundingRadius = 0.0f;
+    // whether the meshes came from the binary mesh cache instead of Assimp, and how long loading took
+    bool loadedFromCache = false;
+    double loadMilliseconds = 0.0;
 
     // constructor, expects a filepath to a 3D model.
-    Model(std::string const &path, bool gamma = false, const glm::mat4* instanceMatrices = nullptr, const unsigned amount = 1);
+    Model(std::string const &path, bool gamma = false, VertexCompression compression = VertexCompression::None,
+        const glm::mat4* instanceMatrices = nullptr, const unsigned amount = 1);
+
+    // returns right away and loads on the loader's threads, the GL objects are created by its uploads.
+    // instanced objects bind their attributes to the meshes' VAOs, so they need a model that is ready
+    Model(std::string const &path, AsyncLoader& loader, bool gamma = false, VertexCompression compression = VertexCompression::None);
+
+    ~Model();
+
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
+
+    ModelState GetState() const;
+    bool IsReady() const;
+
+    // vertex, index and instance buffers of all meshes, freed together with the model
+    std::size_t GetGpuBytes() const;
 
     // draws the model, and thus all its meshes
     void Draw(Shader &shader);
 
-    void DrawInstanced(Shader& shader, const unsigned int amount);
+    void DrawInstanced(Shader& shader, const unsigned int amount, const unsigned int baseInstance = 0);
+
+    // draws mesh i with the i-th DrawElementsIndirectCommand stored in indirectBuffer
+    void DrawIndirect(Shader& shader, const unsigned int indirectBuffer);
 
 private:
+    ModelState state = ModelState::Ready;
+    // shared with the background tasks of an asynchronous load, which outlive the model when it is destroyed early
+    std::shared_ptr<ModelLoadState> loadState;
+    std::size_t pendingTextures = 0;
+
+    // a texture reserved in the cache that still waits for its image
+    struct PendingTexture
+    {
+        unsigned int id;
+        std::string path;
+    };
+
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void LoadModel(std::string const &path);
 
+    // reads the mesh data from the mesh cache, or imports it with Assimp and writes the cache.
+    // touches no GL state, so asynchronous loads run it on a worker thread
+    static bool ImportMeshData(const std::string& path, std::vector<MeshCacheEntry>& entries, bool& fromCache);
+
+    // prints what the post-import optimization did to every mesh
+    static void ReportOptimization(const std::string& path, const std::vector<MeshCacheEntry>& entries);
+
+    // creates the meshes and loads their textures, or with texturesToDecode only reserves them,
+    // listing the ones nobody decoded yet
+    void CreateMeshes(std::vector<MeshCacheEntry>& entries, std::vector<PendingTexture>* texturesToDecode);
+
+    // called once the image of one of the pending textures was uploaded or failed to decode
+    void FinishTexture();
+
+    // switches to Ready once nothing is pending
+    void UpdateLoadState();
+
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-    void ProcessNode(aiNode *node, const aiScene *scene);
+    static void ProcessNode(aiNode *node, const aiScene *scene, std::vector<MeshCacheEntry>& entries);
+
+    static MeshCacheEntry ProcessMesh(aiMesh *mesh, const aiScene *scene);
+
+    // computes the bounding sphere from the meshes' bounds and vertices
+    void ComputeBounds();
+
+    // collects the material textures of a given type, only their type and path are filled in
+    static std::vector<Texture> LoadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName);
 
-    Mesh ProcessMesh(aiMesh *mesh, const aiScene *scene);
+    // the texture at path relative to the model's directory, taken from the TextureCache
+    Texture LoadTexture(const char* path, const std::string& typeName);
 
-    // checks all material textures of a given type and loads the textures if they're not loaded yet.
-    // the required info is returned as a Texture struct.
-    std::vector<Texture> LoadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName);
+    // like LoadTexture, but a texture new to the cache only gets its name and is added to texturesToDecode
+    Texture ReserveTexture(const char* path, const std::string& typeName, std::vector<PendingTexture>& texturesToDecode);
 };
 
 #endif
\ No newline at end of file
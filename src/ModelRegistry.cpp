@@ -0,0 +1,108 @@
+#include "ModelRegistry.h"
+
+#include "Model.h"
+#include "PathUtils.h"
+
+#include <functional>
+
+ModelRegistry& ModelRegistry::Default()
+{
+	static ModelRegistry registry;
+	return registry;
+}
+
+bool ModelRegistry::Key::operator==(const Key& other) const
+{
+	return gamma == other.gamma && compression == other.compression && path == other.path;
+}
+
+std::size_t ModelRegistry::KeyHash::operator()(const Key& key) const
+{
+	return std::hash<std::string>()(key.path) ^ static_cast<std::size_t>(key.gamma) ^ (static_cast<std::size_t>(key.compression) << 1);
+}
+
+std::shared_ptr<Model> ModelRegistry::Get(const std::string& path, bool gamma, VertexCompression compression)
+{
+	Key key{ CanonicalPath(path), gamma, compression };
+	if (auto model = Find(key))
+		return model;
+
+	auto model = std::make_shared<Model>(path, gamma, compression);
+	models[std::move(key)] = model;
+	return model;
+}
+
+std::shared_ptr<Model> ModelRegistry::GetAsync(const std::string& path, AsyncLoader& loader, bool gamma, VertexCompression compression)
+{
+	Key key{ CanonicalPath(path), gamma, compression };
+	if (auto model = Find(key))
+		return model;
+
+	auto model = std::make_shared<Model>(path, loader, gamma, compression);
+	models[std::move(key)] = model;
+	return model;
+}
+
+std::vector<ModelRegistryEntry> ModelRegistry::GetEntries()
+{
+	Prune();
+
+	std::vector<ModelRegistryEntry> entries;
+	entries.reserve(models.size());
+	for (const auto& [key, handle] : models)
+	{
+		const auto model = handle.lock();
+		if (!model)
+			continue;
+
+		ModelRegistryEntry& entry = entries.emplace_back();
+		entry.path = key.path;
+		entry.gamma = key.gamma;
+		entry.compression = key.compression;
+		// without the handle locked above
+		entry.references = model.use_count() - 1;
+		entry.gpuBytes = model->GetGpuBytes();
+		entry.ready = model->IsReady();
+	}
+	return entries;
+}
+
+std::size_t ModelRegistry::GetModelCount()
+{
+	Prune();
+	return models.size();
+}
+
+std::size_t ModelRegistry::GetGpuBytes()
+{
+	std::size_t bytes = 0;
+	for (const auto& [key, handle] : models)
+	{
+		if (const auto model = handle.lock())
+			bytes += model->GetGpuBytes();
+	}
+	return bytes;
+}
+
+std::shared_ptr<Model> ModelRegistry::Find(const Key& key)
+{
+	const auto found = models.find(key);
+	if (found == models.end())
+		return nullptr;
+
+	auto model = found->second.lock();
+	if (!model)
+		models.erase(found);
+	return model;
+}
+
+void ModelRegistry::Prune()
+{
+	for (auto it = models.begin(); it != models.end();)
+	{
+		if (it->second.expired())
+			it = models.erase(it);
+		else
+			++it;
+	}
+}
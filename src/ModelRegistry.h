@@ -0,0 +1,83 @@
+#pragma once
+#ifndef MODEL_REGISTRY_H
+#define MODEL_REGISTRY_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "VertexLayout.h"
+
+class AsyncLoader;
+class Model;
+
+// a model the registry currently hands out
+struct ModelRegistryEntry
+{
+	std::string path;
+	bool gamma = false;
+	VertexCompression compression = VertexCompression::None;
+	long references = 0;
+	std::size_t gpuBytes = 0;
+	bool ready = false;
+};
+
+// Process-wide table of loaded models, keyed by the canonical path of the file and the import options.
+// Models are shared: the registry only keeps weak references, so a model and its buffers are freed
+// as soon as the last handle to it is dropped, and a later Get loads it again.
+// Instanced objects bind their instance attributes to the meshes' VAOs, so each of them needs a model of its own
+// instead of a shared one.
+// Only used from the GL thread.
+class ModelRegistry
+{
+public:
+	// registry shared by all objects
+	static ModelRegistry& Default();
+
+	ModelRegistry() = default;
+
+	ModelRegistry(const ModelRegistry&) = delete;
+	ModelRegistry& operator=(const ModelRegistry&) = delete;
+
+	// the model at path, loaded synchronously when nobody holds it yet
+	std::shared_ptr<Model> Get(const std::string& path, bool gamma = false, VertexCompression compression = VertexCompression::None);
+
+	// like Get, but a model nobody holds yet loads on the loader's threads
+	std::shared_ptr<Model> GetAsync(const std::string& path, AsyncLoader& loader, bool gamma = false,
+		VertexCompression compression = VertexCompression::None);
+
+	// models that are still alive, with the number of handles and their buffer sizes
+	std::vector<ModelRegistryEntry> GetEntries();
+
+	std::size_t GetModelCount();
+	// vertex, index and instance buffers of all live models, textures are counted by the TextureCache
+	std::size_t GetGpuBytes();
+
+private:
+	struct Key
+	{
+		std::string path;
+		bool gamma;
+		// the same file with another vertex layout is another set of buffers
+		VertexCompression compression;
+
+		bool operator==(const Key& other) const;
+	};
+
+	struct KeyHash
+	{
+		std::size_t operator()(const Key& key) const;
+	};
+
+	// the live model for key, or an empty handle
+	std::shared_ptr<Model> Find(const Key& key);
+
+	// forgets models whose last handle was dropped
+	void Prune();
+
+	std::unordered_map<Key, std::weak_ptr<Model>, KeyHash> models;
+};
+
+#endif
@@ -1,8 +1,33 @@
 #include "Object.h"
 
+#include "CpuProfiler.h"
+#include "GLStateCache.h"
+#include "ModelRegistry.h"
+
 #include "glm/gtc/type_ptr.hpp"
 
-Object::Object(const std::string& modelPath, Shader* objShader) : model(new Model(modelPath)), shader(objShader)
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+namespace
+{
+	// unchanged instances between two dirty ranges closer than this are re-uploaded instead of splitting the upload
+	constexpr std::size_t MaxUploadGap = 8;
+
+	// must match local_size_x of cull.comp
+	constexpr unsigned int CullGroupSize = 64;
+}
+
+InstanceUploadStats InstancedObject::frameUploadStats;
+
+Object::Object(const std::string& modelPath, Shader* objShader) : Object(ModelRegistry::Default().Get(modelPath), objShader)
+{
+
+}
+
+Object::Object(std::shared_ptr<Model> loadedModel, Shader* objShader) : model(loadedModel.get()), sharedModel(std::move(loadedModel)), shader(objShader)
 {
 
 }
@@ -17,6 +42,7 @@ Object::Object(){};
 void Object::SetModel(Model* newModel)
 {
 	model = newModel;
+	sharedModel.reset();
 }
 
 void Object::SetShader(Shader* newShader)
@@ -24,6 +50,12 @@ void Object::SetShader(Shader* newShader)
 	shader = newShader;
 }
 
+void Object::SetColor(const glm::vec3& newColor)
+{
+	hasColor = true;
+	color = newColor;
+}
+
 
 void Object::Update()
 {
@@ -36,11 +68,33 @@ void Object::Draw()
 	{
 		shader->use();
 		shader->setMat4("model", transform.GetModelMatrix());
+		if (hasColor)
+			shader->setVec3("diffuse", color);
 		model->Draw(*shader);
 	}
 
 }
 
+void Object::Submit(RenderQueue& queue)
+{
+	if (model == nullptr)
+		return;
+
+	const glm::mat4& modelMatrix = transform.GetModelMatrix();
+	const UniformId matrixId = shader->GetUniformId("model");
+	const UniformId colorId = hasColor ? shader->GetUniformId("diffuse") : UniformId();
+
+	for (const auto& mesh : model->meshes)
+	{
+		DrawPacket& packet = queue.Add(*shader, mesh, glm::vec3(modelMatrix[3]));
+		packet.kind = DrawKind::Elements;
+		packet.matrixId = matrixId;
+		packet.matrix = modelMatrix;
+		packet.colorId = colorId;
+		packet.color = color;
+	}
+}
+
 InstancedObject::InstancedObject() : Object()
 {
 	PrepareInstanceMatricesBuffer();
@@ -54,6 +108,15 @@ InstancedObject::InstancedObject(Model* objModel, Shader* objShader, std::vector
 
 }
 
+InstancedObject::~InstancedObject()
+{
+	GLStateCache::Default().DeleteBuffers(1, &instanceMatBuffer);
+	if (visibleMatBuffer != 0)
+		GLStateCache::Default().DeleteBuffers(1, &visibleMatBuffer);
+	if (indirectBuffer != 0)
+		GLStateCache::Default().DeleteBuffers(1, &indirectBuffer);
+}
+
 void InstancedObject::Update()
 {
 	Object::Update();
@@ -61,13 +124,165 @@ void InstancedObject::Update()
 
 void InstancedObject::Draw()
 {
-	UpdateInstanceMatricesBuffer();
+	PrepareDraw();
 
 	if(model != nullptr)
 	{
 		shader->use();
-		model->DrawInstanced(*shader, instanceTransforms.size());
+		shader->setMat4("mainObjectModel", transform.GetModelMatrix());
+
+		if (cullingMode == CullingMode::Gpu)
+		{
+			model->DrawIndirect(*shader, indirectBuffer);
+		}
+		else
+		{
+			const std::size_t drawCount = cullingMode == CullingMode::Cpu ? visibleInstances.size() : instanceTransforms.size();
+			model->DrawInstanced(*shader, drawCount, drawBaseInstance);
+		}
+	}
+
+	if (ringBuffer)
+		ringBuffer->FenceCurrentRegion();
+}
+
+void InstancedObject::Submit(RenderQueue& queue)
+{
+	PrepareDraw();
+
+	if (model != nullptr)
+	{
+		const glm::mat4& modelMatrix = transform.GetModelMatrix();
+		const UniformId matrixId = shader->GetUniformId("mainObjectModel");
+		const std::size_t drawCount = cullingMode == CullingMode::Cpu ? visibleInstances.size() : instanceTransforms.size();
+
+		for (std::size_t i = 0; i < model->meshes.size(); i++)
+		{
+			DrawPacket& packet = queue.Add(*shader, model->meshes[i], glm::vec3(modelMatrix[3]));
+			packet.matrixId = matrixId;
+			packet.matrix = modelMatrix;
+
+			if (cullingMode == CullingMode::Gpu)
+			{
+				packet.kind = DrawKind::Indirect;
+				packet.indirectBuffer = indirectBuffer;
+				packet.commandOffset = i * sizeof(DrawElementsIndirectCommand);
+			}
+			else
+			{
+				packet.kind = DrawKind::Instanced;
+				packet.instanceCount = static_cast<unsigned int>(drawCount);
+				packet.baseInstance = drawBaseInstance;
+			}
+		}
 	}
+
+	if (ringBuffer)
+		queue.FenceAfterFlush(*ringBuffer);
+}
+
+void InstancedObject::PrepareDraw()
+{
+	UpdateInstanceMatricesBuffer();
+
+	if (cullingMode == CullingMode::Gpu)
+		DispatchGpuCulling();
+}
+
+void InstancedObject::SetUploadMode(InstanceUploadMode mode)
+{
+	if (mode == uploadMode)
+		return;
+
+	uploadMode = mode;
+	ringBuffer.reset();
+	ringFallingBack = false;
+	drawBaseInstance = 0;
+
+	// force a full upload into the new storage
+	uploadedVersions.clear();
+
+	if (mode == InstanceUploadMode::BufferSubData)
+		BindInstanceAttributes(GetAttributeBuffer());
+}
+
+InstanceUploadMode InstancedObject::GetUploadMode() const
+{
+	return uploadMode;
+}
+
+bool InstancedObject::IsRingPersistent() const
+{
+	return ringBuffer && ringBuffer->IsPersistent();
+}
+
+void InstancedObject::SetCullingMode(CullingMode mode)
+{
+	if (mode == cullingMode)
+		return;
+
+	cullingMode = mode;
+	visibleInstances.clear();
+
+	// the storage layout changes between compacted and full, so start over with a full upload
+	uploadedVersions.clear();
+}
+
+CullingMode InstancedObject::GetCullingMode() const
+{
+	return cullingMode;
+}
+
+void InstancedObject::SetCullShader(Shader* newCullShader)
+{
+	cullShader = newCullShader;
+	if (cullShader == nullptr)
+		return;
+
+	cullInstanceCountId = cullShader->GetUniformId("instanceCount");
+	cullObjectModelId = cullShader->GetUniformId("mainObjectModel");
+	cullFrustumPlanesId = cullShader->GetUniformId("frustumPlanes");
+	cullBoundingSphereId = cullShader->GetUniformId("boundingSphere");
+}
+
+void InstancedObject::Cull(const Frustum& frustum)
+{
+	if (cullingMode == CullingMode::Gpu)
+		cullFrustum = frustum;
+
+	if (cullingMode != CullingMode::Cpu)
+		return;
+
+	UpdateBoundingSpheres();
+
+	visibleInstances.clear();
+	frustum.CullSpheres(sphereCentersX.data(), sphereCentersY.data(), sphereCentersZ.data(), sphereRadii.data(),
+		sphereRadii.size(), visibleInstances);
+}
+
+std::size_t InstancedObject::GetVisibleInstanceCount() const
+{
+	return cullingMode == CullingMode::Cpu ? visibleInstances.size() : instanceTransforms.size();
+}
+
+std::size_t InstancedObject::GetInstanceCount() const
+{
+	return instanceTransforms.size();
+}
+
+const InstanceUploadStats& InstancedObject::GetLastUploadStats() const
+{
+	return lastUploadStats;
+}
+
+const InstanceUploadStats& InstancedObject::GetFrameUploadStats()
+{
+	return frameUploadStats;
+}
+
+void InstancedObject::ResetFrameUploadStats()
+{
+	frameUploadStats = {};
 }
 
 void InstancedObject::PrepareInstanceMatricesBuffer()
@@ -75,19 +290,31 @@ void InstancedObject::PrepareInstanceMatricesBuffer()
 	glGenBuffers(1, &instanceMatBuffer);
 
 	std::vector<glm::mat4> instanceMatrices;
+	uploadedVersions.clear();
 	for (const auto& transform : instanceTransforms)
+	{
 		instanceMatrices.emplace_back(transform->GetModelMatrix());
+		uploadedVersions.emplace_back(transform->GetModelVersion());
+	}
+	RememberScannedStore();
 
-	glBindBuffer(GL_ARRAY_BUFFER, instanceMatBuffer);
+	GLStateCache::Default().BindBuffer(GL_ARRAY_BUFFER, instanceMatBuffer);
 	glBufferData(GL_ARRAY_BUFFER, static_cast<int>(instanceMatrices.size()) * sizeof(glm::mat4), instanceMatrices.data(), GL_DYNAMIC_DRAW);
 
+	BindInstanceAttributes(instanceMatBuffer);
+}
+
+void InstancedObject::BindInstanceAttributes(unsigned int buffer) const
+{
+	if (model == nullptr)
+		return;
 
 	for (const auto& mesh : model->meshes)
 	{
 		constexpr std::size_t vec4Size = sizeof(glm::vec4);
 
-		glBindVertexArray(mesh.VAO);
-		glBindBuffer(GL_ARRAY_BUFFER, instanceMatBuffer);
+		GLStateCache::Default().BindVertexArray(mesh.VAO);
+		GLStateCache::Default().BindBuffer(GL_ARRAY_BUFFER, buffer);
 
 		// vertex attributes
 		glEnableVertexAttribArray(3);
@@ -104,21 +331,396 @@ void InstancedObject::PrepareInstanceMatricesBuffer()
 		glVertexAttribDivisor(5, 1);
 		glVertexAttribDivisor(6, 1);
 
-		glBindVertexArray(0);
+		GLStateCache::Default().BindVertexArray(0);
 
 	}
+
+	GLStateCache::Default().BindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
-void InstancedObject::UpdateInstanceMatricesBuffer()
+unsigned int InstancedObject::GetAttributeBuffer() const
 {
-	shader->setMat4("mainObjectModel", transform.GetModelMatrix());
+	if (cullingMode == CullingMode::Gpu)
+		return visibleMatBuffer;
 
-	std::vector<glm::mat4> instanceMatrices;
+	if (ringBuffer)
+		return ringBuffer->GetBuffer();
+
+	return instanceMatBuffer;
+}
+
+void InstancedObject::ResizeInstanceStorage()
+{
+	uploadedVersions.clear();
 	for (const auto& transform : instanceTransforms)
-		instanceMatrices.emplace_back(transform->GetModelMatrix());
+		uploadedVersions.emplace_back(transform->GetModelVersion());
+	RememberScannedStore();
+
+	if (uploadMode == InstanceUploadMode::PersistentRing)
+	{
+		ringBuffer.reset();
+		ringFallingBack = false;
+		drawBaseInstance = 0;
+		if (instanceTransforms.empty())
+			return;
+
+		ringBuffer = std::make_unique<InstanceRingBuffer>(instanceTransforms.size() * sizeof(glm::mat4));
+	}
+	else
+	{
+		GLStateCache::Default().BindBuffer(GL_ARRAY_BUFFER, instanceMatBuffer);
+		glBufferData(GL_ARRAY_BUFFER, static_cast<int>(instanceTransforms.size()) * sizeof(glm::mat4), nullptr, GL_DYNAMIC_DRAW);
+		GLStateCache::Default().BindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+
+	if (cullingMode == CullingMode::Gpu)
+		ResizeGpuCullingStorage();
+
+	BindInstanceAttributes(GetAttributeBuffer());
+}
+
+void InstancedObject::ResizeGpuCullingStorage()
+{
+	if (visibleMatBuffer == 0)
+		glGenBuffers(1, &visibleMatBuffer);
+	if (indirectBuffer == 0)
+		glGenBuffers(1, &indirectBuffer);
+
+	// only written by the compute shader
+	GLStateCache::Default().BindBuffer(GL_SHADER_STORAGE_BUFFER, visibleMatBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, static_cast<int>(instanceTransforms.size()) * sizeof(glm::mat4), nullptr, GL_DYNAMIC_COPY);
+	GLStateCache::Default().BindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	// one command per mesh, the instance counts are filled in every frame
+	std::vector<DrawElementsIndirectCommand> commands;
+	if (model != nullptr)
+	{
+		for (const auto& mesh : model->meshes)
+			commands.emplace_back(mesh.GetIndirectCommand());
+	}
+
+	GLStateCache::Default().BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, static_cast<int>(commands.size()) * sizeof(DrawElementsIndirectCommand), commands.data(), GL_DYNAMIC_DRAW);
+	GLStateCache::Default().BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void InstancedObject::UpdateInstanceMatricesBuffer()
+{
+	CPU_PROFILE_SCOPE("InstancedObject::UpdateInstanceMatricesBuffer");
+
+	lastUploadStats = {};
+
+	if (cullingMode == CullingMode::Cpu)
+	{
+		UploadVisibleInstances();
+	}
+	else
+	{
+		CollectDirtyInstances();
+
+		if (uploadMode == InstanceUploadMode::PersistentRing)
+			UploadRingRegion();
+		else
+			UploadDirtyRanges();
+	}
+
+	frameUploadStats.bytes += lastUploadStats.bytes;
+	frameUploadStats.ranges += lastUploadStats.ranges;
+	frameUploadStats.instances += lastUploadStats.instances;
+	frameUploadStats.scannedInstances += lastUploadStats.scannedInstances;
+}
+
+void InstancedObject::CollectDirtyInstances()
+{
+	if (instanceTransforms.size() != uploadedVersions.size())
+	{
+		// instances were added or removed, everything has to be written again
+		ResizeInstanceStorage();
+
+		dirtyInstances.Clear();
+		dirtyInstances.Add(0, instanceTransforms.size());
+
+		for (auto& regionInstances : dirtyRegionInstances)
+		{
+			regionInstances.Clear();
+			regionInstances.Add(0, instanceTransforms.size());
+		}
+
+		return;
+	}
+
+	if (instanceStore != nullptr && instanceStore->GetGroupChangeCount(instanceChangeGroup) == scannedChangeCount)
+		return;
+
+	lastUploadStats.scannedInstances = instanceTransforms.size();
+	for (std::size_t i = 0; i < instanceTransforms.size(); i++)
+	{
+		const unsigned int version = instanceTransforms[i]->GetModelVersion();
+		if (version != uploadedVersions[i])
+		{
+			uploadedVersions[i] = version;
+			dirtyInstances.Add(i);
+
+			if (ringBuffer)
+			{
+				for (unsigned int region = 0; region < ringBuffer->GetRegionCount(); region++)
+					dirtyRegionInstances[region].Add(i);
+			}
+		}
+	}
+
+	if (instanceStore != nullptr)
+		scannedChangeCount = instanceStore->GetGroupChangeCount(instanceChangeGroup);
+}
+
+void InstancedObject::RememberScannedStore()
+{
+	instanceStore = instanceTransforms.empty() ? nullptr : &instanceTransforms.front()->GetStore();
+	for (const auto& instance : instanceTransforms)
+	{
+		if (&instance->GetStore() != instanceStore)
+		{
+			instanceStore = nullptr;
+			break;
+		}
+	}
+
+	if (instanceStore == nullptr)
+		return;
+
+	// groups are never released, the one created for a store is kept for every later resize
+	if (groupStore != instanceStore)
+	{
+		groupStore = instanceStore;
+		instanceChangeGroup = instanceStore->CreateChangeGroup();
+	}
+
+	for (const auto& instance : instanceTransforms)
+	{
+		if (!instanceStore->SetChangeGroup(instance->GetHandle(), instanceChangeGroup))
+		{
+			// tracked by another object, its count would miss changes of this node
+			instanceStore = nullptr;
+			return;
+		}
+	}
+
+	scannedChangeCount = instanceStore->GetGroupChangeCount(instanceChangeGroup);
+}
+
+void InstancedObject::UploadDirtyRanges()
+{
+	if (dirtyInstances.Empty())
+		return;
+
+	GLStateCache::Default().BindBuffer(GL_ARRAY_BUFFER, instanceMatBuffer);
+
+	for (const auto& range : dirtyInstances.Coalesce(MaxUploadGap))
+	{
+		uploadScratch.clear();
+		for (std::size_t i = range.begin; i < range.end; i++)
+			uploadScratch.emplace_back(instanceTransforms[i]->GetModelMatrix());
+
+		const std::size_t size = uploadScratch.size() * sizeof(glm::mat4);
+		glBufferSubData(GL_ARRAY_BUFFER, range.begin * sizeof(glm::mat4), size, uploadScratch.data());
+
+		lastUploadStats.bytes += size;
+		lastUploadStats.ranges++;
+		lastUploadStats.instances += uploadScratch.size();
+	}
+
+	GLStateCache::Default().BindBuffer(GL_ARRAY_BUFFER, 0);
+	dirtyInstances.Clear();
+}
+
+void InstancedObject::UploadRingRegion()
+{
+	// nothing changed, keep drawing from the region written last
+	if (!ringBuffer || dirtyInstances.Empty())
+		return;
+
+	dirtyInstances.Clear();
+
+	auto destination = static_cast<glm::mat4*>(ringBuffer->BeginWrite());
+
+	if (ringBuffer->IsFallingBack())
+	{
+		// the fallback memory holds nothing, and the region keeps its dirty instances until it is written
+		for (std::size_t i = 0; i < instanceTransforms.size(); i++)
+			destination[i] = instanceTransforms[i]->GetModelMatrix();
+	}
+	else
+	{
+		DirtyRangeSet& regionInstances = dirtyRegionInstances[ringBuffer->GetRegionIndex()];
+		for (const auto& range : regionInstances.Coalesce(MaxUploadGap))
+		{
+			for (std::size_t i = range.begin; i < range.end; i++)
+				destination[i] = instanceTransforms[i]->GetModelMatrix();
+
+			lastUploadStats.bytes += (range.end - range.begin) * sizeof(glm::mat4);
+			lastUploadStats.ranges++;
+			lastUploadStats.instances += range.end - range.begin;
+		}
+
+		regionInstances.Clear();
+	}
+
+	ringBuffer->EndWrite();
+
+	// the orphaning fallback patches a CPU copy but always sends all of it
+	if (!ringBuffer->IsPersistent() || ringBuffer->IsFallingBack())
+	{
+		lastUploadStats.bytes = ringBuffer->GetRegionSize();
+		lastUploadStats.ranges = 1;
+		lastUploadStats.instances = instanceTransforms.size();
+	}
+
+	FinishRingWrite();
+}
+
+void InstancedObject::FinishRingWrite()
+{
+	drawBaseInstance = static_cast<unsigned int>(ringBuffer->GetRegionOffset() / sizeof(glm::mat4));
+
+	// the instanced attributes follow the ring in and out of its fallback buffer, GPU culling binds it per dispatch
+	if (ringBuffer->IsFallingBack() != ringFallingBack)
+	{
+		ringFallingBack = ringBuffer->IsFallingBack();
+		if (cullingMode != CullingMode::Gpu)
+			BindInstanceAttributes(GetAttributeBuffer());
+	}
+}
+
+void InstancedObject::UploadVisibleInstances()
+{
+	if (instanceTransforms.size() != uploadedVersions.size())
+		ResizeInstanceStorage();
+
+	// the visible set moves with the camera, so it is written from scratch every frame
+	dirtyInstances.Clear();
+	for (auto& regionInstances : dirtyRegionInstances)
+		regionInstances.Clear();
+
+	uploadScratch.clear();
+	for (const auto index : visibleInstances)
+		uploadScratch.emplace_back(instanceTransforms[index]->GetModelMatrix());
+
+	if (uploadScratch.empty())
+		return;
+
+	const std::size_t size = uploadScratch.size() * sizeof(glm::mat4);
+
+	if (uploadMode == InstanceUploadMode::PersistentRing)
+	{
+		if (!ringBuffer)
+			return;
+
+		std::memcpy(ringBuffer->BeginWrite(), uploadScratch.data(), size);
+		ringBuffer->EndWrite();
+		FinishRingWrite();
+
+		lastUploadStats.bytes = ringBuffer->IsPersistent() && !ringBuffer->IsFallingBack() ? size : ringBuffer->GetRegionSize();
+	}
+	else
+	{
+		GLStateCache::Default().BindBuffer(GL_ARRAY_BUFFER, instanceMatBuffer);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, uploadScratch.data());
+		GLStateCache::Default().BindBuffer(GL_ARRAY_BUFFER, 0);
+
+		lastUploadStats.bytes = size;
+	}
 
-	glBindBuffer(GL_ARRAY_BUFFER, instanceMatBuffer);
-	glBufferSubData(GL_ARRAY_BUFFER, 0, static_cast<int>(instanceMatrices.size()) * sizeof(glm::mat4), instanceMatrices.data());
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	lastUploadStats.ranges = 1;
+	lastUploadStats.instances = uploadScratch.size();
 }
 
+void InstancedObject::UpdateBoundingSpheres()
+{
+	const std::size_t count = instanceTransforms.size();
+	if (sphereVersions.size() != count)
+	{
+		sphereCentersX.resize(count);
+		sphereCentersY.resize(count);
+		sphereCentersZ.resize(count);
+		sphereRadii.resize(count);
+		sphereVersions.assign(count, ~0u);
+	}
+
+	// moving the whole object moves every sphere
+	if (transform.GetModelVersion() != sphereObjectVersion)
+	{
+		sphereObjectVersion = transform.GetModelVersion();
+		std::fill(sphereVersions.begin(), sphereVersions.end(), ~0u);
+	}
+
+	const glm::vec3 localCenter = model != nullptr ? model->boundingCenter : glm::vec3(0.0f);
+	const float localRadius = model != nullptr ? model->boundingRadius : 0.0f;
+	const glm::mat4& objectModel = transform.GetModelMatrix();
+
+	for (std::size_t i = 0; i < count; i++)
+	{
+		const unsigned int version = instanceTransforms[i]->GetModelVersion();
+		if (version == sphereVersions[i])
+			continue;
+
+		sphereVersions[i] = version;
+
+		const glm::mat4 world = objectModel * instanceTransforms[i]->GetModelMatrix();
+		const glm::vec4 center = world * glm::vec4(localCenter, 1.0f);
+		const float scale = glm::max(glm::length(glm::vec3(world[0])), glm::max(glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2]))));
+
+		sphereCentersX[i] = center.x;
+		sphereCentersY[i] = center.y;
+		sphereCentersZ[i] = center.z;
+		sphereRadii[i] = localRadius * scale;
+	}
+}
+
+void InstancedObject::DispatchGpuCulling()
+{
+	if (model == nullptr || indirectBuffer == 0 || model->meshes.empty())
+		return;
+
+	// the first command's instance count is the counter the shader increments
+	const unsigned int zero = 0;
+	constexpr std::size_t instanceCountOffset = offsetof(DrawElementsIndirectCommand, instanceCount);
+	GLStateCache::Default().BindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+	glBufferSubData(GL_DRAW_INDIRECT_BUFFER, instanceCountOffset, sizeof(unsigned int), &zero);
+	GLStateCache::Default().BindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+
+	if (cullShader == nullptr || instanceTransforms.empty())
+		return;
+
+	cullShader->use();
+	cullShader->setInt(cullInstanceCountId, static_cast<int>(instanceTransforms.size()));
+	cullShader->setMat4(cullObjectModelId, transform.GetModelMatrix());
+	cullShader->setVec4Array(cullFrustumPlanesId, cullFrustum.planes, Frustum::PlaneCount);
+	cullShader->setVec4(cullBoundingSphereId, glm::vec4(model->boundingCenter, model->boundingRadius));
+
+	// the full set of instances is read from wherever the last upload put it
+	const std::size_t sourceSize = instanceTransforms.size() * sizeof(glm::mat4);
+	if (ringBuffer)
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, ringBuffer->GetBuffer(), ringBuffer->GetRegionOffset(), sourceSize);
+	else
+		glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, instanceMatBuffer, 0, sourceSize);
+	GLStateCache::Default().BindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visibleMatBuffer);
+	GLStateCache::Default().BindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, indirectBuffer);
+
+	const unsigned int groupCount = (static_cast<unsigned int>(instanceTransforms.size()) + CullGroupSize - 1) / CullGroupSize;
+	glDispatchCompute(groupCount, 1, 1);
+
+	// the remaining meshes draw the same instances, copy the final count into their commands.
+	// the copy reads what the atomic counter wrote, which is a buffer update and not a shader storage access
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+	GLStateCache::Default().BindBuffer(GL_COPY_READ_BUFFER, indirectBuffer);
+	GLStateCache::Default().BindBuffer(GL_COPY_WRITE_BUFFER, indirectBuffer);
+	for (std::size_t i = 1; i < model->meshes.size(); i++)
+	{
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, instanceCountOffset,
+			i * sizeof(DrawElementsIndirectCommand) + instanceCountOffset, sizeof(unsigned int));
+	}
+	GLStateCache::Default().BindBuffer(GL_COPY_READ_BUFFER, 0);
+	GLStateCache::Default().BindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+}
@@ -3,7 +3,13 @@
 #ifndef OBJECT_H
 #define OBJECT_H
 
+#include <memory>
+
+#include "DirtyRangeSet.h"
+#include "Frustum.h"
+#include "InstanceRingBuffer.h"
 #include "Model.h"
+#include "RenderQueue.h"
 #include "Transform.h"
 
 class Object
@@ -11,15 +17,23 @@ class Object
 protected:
 
 	Model* model = nullptr;
+	// keeps a model taken from the ModelRegistry alive, empty for models owned by someone else
+	std::shared_ptr<Model> sharedModel;
 
 	Shader* shader = nullptr;
 
+	bool hasColor = false;
+	glm::vec3 color{ 0.0f };
+
 public:
 
 	Transform transform;
 
+	// shares the model with every other object loaded from the same path
 	Object(const std::string& modelPath, Shader* objShader);
 
+	Object(std::shared_ptr<Model> loadedModel, Shader* objShader);
+
 	Object(Model* loadedModel, Shader* objShader);
 
 	Object();
@@ -30,24 +44,128 @@ public:
 
 	void SetShader(Shader* newShader);
 
+	// sent as the shader's diffuse uniform with every draw, for untextured shaders shared by differently colored objects
+	void SetColor(const glm::vec3& newColor);
+
 	virtual void Update();
 
 	virtual void Draw();
+
+	// adds a packet per mesh to the queue, which draws them when flushed
+	virtual void Submit(RenderQueue& queue);
+};
+
+enum class InstanceUploadMode
+{
+	// one buffer updated in place with glBufferSubData
+	BufferSubData,
+	// persistently mapped ring of regions, orphaning when buffer storage is unavailable
+	PersistentRing
+};
+
+enum class CullingMode
+{
+	// every instance is drawn
+	None,
+	// instances are tested against the frustum on the CPU and only the visible ones are uploaded
+	Cpu,
+	// all instances are uploaded, a compute shader compacts the visible ones and fills an indirect draw
+	Gpu
+};
+
+struct InstanceUploadStats
+{
+	std::size_t bytes = 0;
+	std::size_t ranges = 0;
+	std::size_t instances = 0;
+	// instances whose model versions had to be compared to find the changed ones
+	std::size_t scannedInstances = 0;
 };
 
 class InstancedObject : public Object
 {
 	unsigned int instanceMatBuffer = 0;
 
+	InstanceUploadMode uploadMode = InstanceUploadMode::BufferSubData;
+	std::unique_ptr<InstanceRingBuffer> ringBuffer;
+	// whether the instanced attributes point at the ring's fallback buffer
+	bool ringFallingBack = false;
+	unsigned int drawBaseInstance = 0;
+
+	// model matrix version of every instance as it was last uploaded
+	std::vector<unsigned int> uploadedVersions;
+	// store all instances live in (nullptr when they are spread over several or shared with another group),
+	// the change group tagging them and its count at the last scan, the versions only have to be compared
+	// again once the count moved
+	TransformStore* instanceStore = nullptr;
+	TransformStore* groupStore = nullptr;
+	unsigned int instanceChangeGroup = TransformStore::NoChangeGroup;
+	std::size_t scannedChangeCount = 0;
+	DirtyRangeSet dirtyInstances;
+	// every ring region misses the changes made since it was written last
+	DirtyRangeSet dirtyRegionInstances[InstanceRingBuffer::RegionCount];
+	std::vector<glm::mat4> uploadScratch;
+
+	InstanceUploadStats lastUploadStats;
+	static InstanceUploadStats frameUploadStats;
+
+	// with CPU culling the instance storage holds only the visible instances
+	CullingMode cullingMode = CullingMode::None;
+	std::vector<unsigned int> visibleInstances;
+	// world space bounding spheres of the instances, one array per component for batched tests
+	std::vector<float> sphereCentersX;
+	std::vector<float> sphereCentersY;
+	std::vector<float> sphereCentersZ;
+	std::vector<float> sphereRadii;
+	std::vector<unsigned int> sphereVersions;
+	unsigned int sphereObjectVersion = ~0u;
+
+	// GPU culling writes the surviving matrices into visibleMatBuffer and the instance count into indirectBuffer
+	Shader* cullShader = nullptr;
+	UniformId cullInstanceCountId;
+	UniformId cullObjectModelId;
+	UniformId cullFrustumPlanesId;
+	UniformId cullBoundingSphereId;
+	Frustum cullFrustum{};
+	unsigned int visibleMatBuffer = 0;
+	unsigned int indirectBuffer = 0;
 
 	void PrepareInstanceMatricesBuffer();
 
+	void BindInstanceAttributes(unsigned int buffer) const;
+
+	// buffer the instanced attributes are read from in the current modes
+	unsigned int GetAttributeBuffer() const;
+
+	void ResizeInstanceStorage();
+
+	void ResizeGpuCullingStorage();
+
 	void UpdateInstanceMatricesBuffer();
 
+	void CollectDirtyInstances();
+	// called whenever uploadedVersions was filled from every instance
+	void RememberScannedStore();
+
+	void UploadDirtyRanges();
+
+	void UploadRingRegion();
+	// picks up where the ring put the data just written
+	void FinishRingWrite();
+
+	void UploadVisibleInstances();
+
+	void UpdateBoundingSpheres();
+
+	void DispatchGpuCulling();
+
+	// uploads the instances and runs the GPU culling, everything a draw of the instances needs
+	void PrepareDraw();
+
 public:
 	InstancedObject();
 
-	~InstancedObject() override = default;
+	~InstancedObject() override;
 
 	InstancedObject(Model* objModel, Shader* objShader, std::vector<Transform*> objInstanceTransforms);
 
@@ -55,8 +173,34 @@ public:
 
 	void Draw() override;
 
+	// the ring region read by the packets is fenced when the queue is flushed
+	void Submit(RenderQueue& queue) override;
+
 	void AddInstanceTransform(const Transform& transform);
 
+	void SetUploadMode(InstanceUploadMode mode);
+	InstanceUploadMode GetUploadMode() const;
+	// false when the ring had to fall back to orphaning
+	bool IsRingPersistent() const;
+
+	void SetCullingMode(CullingMode mode);
+	CullingMode GetCullingMode() const;
+	// compute program used by CullingMode::Gpu, without it GPU culling draws nothing
+	void SetCullShader(Shader* newCullShader);
+	// selects the instances touching the frustum, the next Draw uploads and draws only those.
+	// in GPU mode the frustum is only remembered and the test runs during Draw
+	void Cull(const Frustum& frustum);
+	// unknown on the CPU in GPU mode, where the total count is returned
+	std::size_t GetVisibleInstanceCount() const;
+	std::size_t GetInstanceCount() const;
+
+	// what the last Draw had to send to the GPU
+	const InstanceUploadStats& GetLastUploadStats() const;
+
+	// sum over all instanced objects drawn since the last reset
+	static const InstanceUploadStats& GetFrameUploadStats();
+	static void ResetFrameUploadStats();
+
 	std::vector<Transform*> instanceTransforms;
 
 
@@ -0,0 +1,66 @@
+#include "OffscreenFramebuffer.h"
+
+#include <glad/glad.h>
+
+#include <cstring>
+
+OffscreenFramebuffer::OffscreenFramebuffer(int width, int height) : width(width), height(height)
+{
+	glGenFramebuffers(1, &framebuffer);
+	glGenRenderbuffers(1, &colorBuffer);
+	glGenRenderbuffers(1, &depthBuffer);
+
+	glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, depthBuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depthBuffer);
+	complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+OffscreenFramebuffer::~OffscreenFramebuffer()
+{
+	glDeleteFramebuffers(1, &framebuffer);
+	glDeleteRenderbuffers(1, &colorBuffer);
+	glDeleteRenderbuffers(1, &depthBuffer);
+}
+
+bool OffscreenFramebuffer::IsComplete() const
+{
+	return complete;
+}
+
+void OffscreenFramebuffer::Bind() const
+{
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+}
+
+void OffscreenFramebuffer::ReadPixels(std::vector<unsigned char>& rgba) const
+{
+	const std::size_t rowSize = static_cast<std::size_t>(width) * 4;
+	std::vector<unsigned char> rows(rowSize * height);
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, rows.data());
+
+	// GL rows start at the bottom
+	rgba.resize(rows.size());
+	for (int y = 0; y < height; y++)
+		std::memcpy(&rgba[y * rowSize], &rows[(height - 1 - y) * rowSize], rowSize);
+}
+
+int OffscreenFramebuffer::GetWidth() const
+{
+	return width;
+}
+
+int OffscreenFramebuffer::GetHeight() const
+{
+	return height;
+}
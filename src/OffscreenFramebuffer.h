@@ -0,0 +1,37 @@
+#pragma once
+#ifndef OFFSCREEN_FRAMEBUFFER_H
+#define OFFSCREEN_FRAMEBUFFER_H
+
+#include <vector>
+
+// RGBA8 color + depth/stencil framebuffer standing in for the window when there is none
+class OffscreenFramebuffer
+{
+public:
+	OffscreenFramebuffer(int width, int height);
+	~OffscreenFramebuffer();
+
+	OffscreenFramebuffer(const OffscreenFramebuffer&) = delete;
+	OffscreenFramebuffer& operator=(const OffscreenFramebuffer&) = delete;
+
+	bool IsComplete() const;
+
+	void Bind() const;
+
+	// reads the color buffer as RGBA, top row first like image files expect
+	void ReadPixels(std::vector<unsigned char>& rgba) const;
+
+	int GetWidth() const;
+	int GetHeight() const;
+
+private:
+	int width = 0;
+	int height = 0;
+	bool complete = false;
+
+	unsigned int framebuffer = 0;
+	unsigned int colorBuffer = 0;
+	unsigned int depthBuffer = 0;
+};
+
+#endif
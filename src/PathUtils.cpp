@@ -0,0 +1,13 @@
+#include "PathUtils.h"
+
+#include <filesystem>
+
+std::string CanonicalPath(const std::string& path)
+{
+	// "res/models/cube/../cube/stone.jpg" and "res/models/cube/stone.jpg" are the same file
+	std::error_code error;
+	const std::filesystem::path canonical = std::filesystem::weakly_canonical(path, error);
+	if (error)
+		return std::filesystem::path(path).lexically_normal().generic_string();
+	return canonical.generic_string();
+}
@@ -0,0 +1,11 @@
+#pragma once
+#ifndef PATH_UTILS_H
+#define PATH_UTILS_H
+
+#include <string>
+
+// absolute, normalized path with forward slashes, so different spellings of one file compare equal.
+// files that don't exist are only normalized
+std::string CanonicalPath(const std::string& path);
+
+#endif
@@ -0,0 +1,113 @@
+#include "PngWriter.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+	// deflate stored blocks hold at most this many bytes
+	constexpr std::size_t MaxStoredBlock = 65535;
+
+	std::uint32_t Crc32(const unsigned char* data, std::size_t size, std::uint32_t crc = 0)
+	{
+		static std::uint32_t table[256] = {};
+		if (table[1] == 0)
+		{
+			for (std::uint32_t i = 0; i < 256; i++)
+			{
+				std::uint32_t value = i;
+				for (int bit = 0; bit < 8; bit++)
+					value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+				table[i] = value;
+			}
+		}
+
+		crc = ~crc;
+		for (std::size_t i = 0; i < size; i++)
+			crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		return ~crc;
+	}
+
+	std::uint32_t Adler32(const unsigned char* data, std::size_t size)
+	{
+		std::uint32_t a = 1, b = 0;
+		for (std::size_t i = 0; i < size; i++)
+		{
+			a = (a + data[i]) % 65521;
+			b = (b + a) % 65521;
+		}
+		return (b << 16) | a;
+	}
+
+	void PutBigEndian(std::vector<unsigned char>& out, std::uint32_t value)
+	{
+		out.push_back(static_cast<unsigned char>(value >> 24));
+		out.push_back(static_cast<unsigned char>(value >> 16));
+		out.push_back(static_cast<unsigned char>(value >> 8));
+		out.push_back(static_cast<unsigned char>(value));
+	}
+
+	void PutChunk(std::vector<unsigned char>& out, const char* type, const std::vector<unsigned char>& data)
+	{
+		PutBigEndian(out, static_cast<std::uint32_t>(data.size()));
+
+		const std::size_t typeStart = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+
+		// the checksum covers the type and the data
+		PutBigEndian(out, Crc32(out.data() + typeStart, out.size() - typeStart));
+	}
+}
+
+bool WritePng(const std::string& path, int width, int height, const unsigned char* rgba)
+{
+	if (width <= 0 || height <= 0 || rgba == nullptr)
+		return false;
+
+	// every scanline starts with its filter type, 0 keeps the bytes as they are
+	const std::size_t rowSize = static_cast<std::size_t>(width) * 4;
+	std::vector<unsigned char> scanlines;
+	scanlines.reserve((rowSize + 1) * height);
+	for (int y = 0; y < height; y++)
+	{
+		scanlines.push_back(0);
+		scanlines.insert(scanlines.end(), rgba + y * rowSize, rgba + (y + 1) * rowSize);
+	}
+
+	// zlib stream made of stored deflate blocks, fast to write and trivially correct
+	std::vector<unsigned char> zlib = { 0x78, 0x01 };
+	for (std::size_t offset = 0; offset < scanlines.size(); offset += MaxStoredBlock)
+	{
+		const std::size_t size = std::min(MaxStoredBlock, scanlines.size() - offset);
+		const bool last = offset + size == scanlines.size();
+
+		zlib.push_back(last ? 1 : 0);
+		zlib.push_back(static_cast<unsigned char>(size));
+		zlib.push_back(static_cast<unsigned char>(size >> 8));
+		zlib.push_back(static_cast<unsigned char>(~size));
+		zlib.push_back(static_cast<unsigned char>(~size >> 8));
+		zlib.insert(zlib.end(), scanlines.begin() + offset, scanlines.begin() + offset + size);
+	}
+	PutBigEndian(zlib, Adler32(scanlines.data(), scanlines.size()));
+
+	std::vector<unsigned char> header;
+	PutBigEndian(header, static_cast<std::uint32_t>(width));
+	PutBigEndian(header, static_cast<std::uint32_t>(height));
+	// 8 bits per channel, RGBA, default compression, filtering and no interlacing
+	header.insert(header.end(), { 8, 6, 0, 0, 0 });
+
+	std::vector<unsigned char> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	PutChunk(png, "IHDR", header);
+	PutChunk(png, "IDAT", zlib);
+	PutChunk(png, "IEND", {});
+
+	std::ofstream file(path, std::ios::binary);
+	if (!file)
+		return false;
+
+	file.write(reinterpret_cast<const char*>(png.data()), static_cast<std::streamsize>(png.size()));
+	return static_cast<bool>(file);
+}
@@ -0,0 +1,10 @@
+#pragma once
+#ifndef PNG_WRITER_H
+#define PNG_WRITER_H
+
+#include <string>
+
+// writes 8 bit RGBA pixels, top row first, as an uncompressed PNG. returns false when the file can't be written
+bool WritePng(const std::string& path, int width, int height, const unsigned char* rgba);
+
+#endif
@@ -0,0 +1,205 @@
+#include "RenderQueue.h"
+
+#include "BindlessTextures.h"
+#include "GLStateCache.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+#include <optional>
+
+namespace
+{
+	constexpr unsigned int RadixBits = 8;
+	constexpr unsigned int RadixBuckets = 1u << RadixBits;
+
+	constexpr std::uint64_t DepthMask = (1ull << 24) - 1;
+
+	// textures in use fold into 16 bits, meshes sharing all of them get the same material bits
+	std::uint64_t MaterialBits(const Material& material)
+	{
+		// bindless materials switch with a uniform, which is not worth splitting vertex arrays for
+		if (BindlessTextures::Default().IsEnabled())
+			return 0;
+
+		// packed textures count as their array, materials differing only in layers bind the same
+		std::uint32_t hash = 0;
+		for (unsigned int i = 0; i < material.GetTextureCount(); i++)
+		{
+			const TextureLayer layer = material.GetLayer(i);
+			hash = hash * 31 + (layer.IsValid() ? layer.array : material.GetTexture(i));
+		}
+		return (hash ^ (hash >> 16)) & 0xFFFF;
+	}
+}
+
+void RenderQueue::SetView(const glm::mat4& newView, float newFarPlane)
+{
+	view = newView;
+	farPlane = newFarPlane;
+}
+
+void RenderQueue::SetPass(const char* name)
+{
+	pass = name;
+}
+
+DrawPacket& RenderQueue::Add(Shader& shader, const Mesh& mesh, const glm::vec3& worldPosition)
+{
+	const float depth = -(view * glm::vec4(worldPosition, 1.0f)).z;
+
+	DrawPacket& packet = packets.emplace_back();
+	packet.key = MakeSortKey(shader, mesh, depth, farPlane);
+	packet.pass = pass;
+	packet.shader = &shader;
+	packet.mesh = &mesh;
+	return packet;
+}
+
+void RenderQueue::FenceAfterFlush(InstanceRingBuffer& ringBuffer)
+{
+	fencedRings.push_back(&ringBuffer);
+}
+
+void RenderQueue::Flush(GpuProfiler* profiler)
+{
+	lastStats = {};
+	lastStats.packets = packets.size();
+
+	Sort();
+
+	boundProgram = 0;
+	boundVertexArray = 0;
+
+	// names come from the same literals, comparing pointers is enough
+	std::optional<GpuProfiler::Scope> passScope;
+	const char* scopedPass = nullptr;
+
+	for (const auto& entry : order)
+	{
+		const DrawPacket& packet = packets[entry.second];
+		if (profiler != nullptr && packet.pass != scopedPass)
+		{
+			passScope.reset();
+			scopedPass = packet.pass;
+			if (scopedPass != nullptr)
+				passScope.emplace(profiler, scopedPass);
+		}
+
+		Issue(packet);
+	}
+	passScope.reset();
+
+	for (InstanceRingBuffer* ringBuffer : fencedRings)
+		ringBuffer->FenceCurrentRegion();
+
+	packets.clear();
+	fencedRings.clear();
+}
+
+std::size_t RenderQueue::GetPacketCount() const
+{
+	return packets.size();
+}
+
+const RenderQueueStats& RenderQueue::GetLastStats() const
+{
+	return lastStats;
+}
+
+std::uint64_t RenderQueue::MakeSortKey(const Shader& shader, const Mesh& mesh, float depth, float farPlane)
+{
+	// front to back, so among equal state the nearest packets fill the depth buffer first
+	const float normalizedDepth = farPlane > 0.0f ? std::clamp(depth / farPlane, 0.0f, 1.0f) : 0.0f;
+	const std::uint64_t depthBits = static_cast<std::uint64_t>(normalizedDepth * static_cast<float>(DepthMask)) & DepthMask;
+
+	return (static_cast<std::uint64_t>(shader.ID & 0xFF) << 56) | (MaterialBits(mesh.material) << 40)
+		| (static_cast<std::uint64_t>(mesh.VAO & 0xFFFF) << 24) | depthBits;
+}
+
+void RenderQueue::Sort()
+{
+	order.resize(packets.size());
+	for (std::size_t i = 0; i < packets.size(); i++)
+		order[i] = { packets[i].key, static_cast<std::uint32_t>(i) };
+
+	if (order.size() < 2)
+		return;
+
+	// least significant digit first, every pass is stable so earlier digits keep their order
+	orderScratch.resize(order.size());
+	for (unsigned int shift = 0; shift < 64; shift += RadixBits)
+	{
+		std::size_t counts[RadixBuckets] = {};
+		for (const auto& entry : order)
+			counts[(entry.first >> shift) & (RadixBuckets - 1)]++;
+
+		// all keys share this digit, the pass would not move anything
+		if (counts[(order.front().first >> shift) & (RadixBuckets - 1)] == order.size())
+			continue;
+
+		std::size_t offset = 0;
+		for (auto& count : counts)
+		{
+			const std::size_t bucketSize = count;
+			count = offset;
+			offset += bucketSize;
+		}
+
+		for (const auto& entry : order)
+			orderScratch[counts[(entry.first >> shift) & (RadixBuckets - 1)]++] = entry;
+		order.swap(orderScratch);
+	}
+}
+
+void RenderQueue::Issue(const DrawPacket& packet)
+{
+	const Mesh& mesh = *packet.mesh;
+	Shader& shader = *packet.shader;
+
+	GLStateCache& glState = GLStateCache::Default();
+
+	if (glState.UseProgram(shader.ID))
+		lastStats.programChanges++;
+	else
+		lastStats.programChangesSkipped++;
+
+	if (glState.BindVertexArray(mesh.VAO))
+		lastStats.vertexArrayChanges++;
+	else
+		lastStats.vertexArrayChangesSkipped++;
+
+	// the previous packet may have used the same objects when the state was already bound before the flush
+	const bool programChanged = shader.ID != boundProgram;
+	const bool vertexArrayChanged = mesh.VAO != boundVertexArray;
+	boundProgram = shader.ID;
+	boundVertexArray = mesh.VAO;
+
+	// the dequantization belongs to the vertex buffer, it only changes with the program or the vertex array
+	if (programChanged || vertexArrayChanged)
+		mesh.SetPositionTransform(shader);
+
+	const TextureBindCounts textureBinds = mesh.material.Bind(shader);
+	lastStats.textureChanges += textureBinds.made;
+	lastStats.textureChangesSkipped += textureBinds.skipped;
+
+	if (packet.matrixId.IsValid())
+		shader.setMat4(packet.matrixId, packet.matrix);
+	if (packet.colorId.IsValid())
+		shader.setVec3(packet.colorId, packet.color);
+
+	const auto indexCount = static_cast<int>(mesh.indices.size());
+	switch (packet.kind)
+	{
+	case DrawKind::Elements:
+		glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr);
+		break;
+	case DrawKind::Instanced:
+		glDrawElementsInstancedBaseInstance(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, nullptr, packet.instanceCount, packet.baseInstance);
+		break;
+	case DrawKind::Indirect:
+		glState.BindBuffer(GL_DRAW_INDIRECT_BUFFER, packet.indirectBuffer);
+		glDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, reinterpret_cast<const void*>(packet.commandOffset));
+		break;
+	}
+}
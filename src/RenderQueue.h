@@ -0,0 +1,113 @@
+#pragma once
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "GpuProfiler.h"
+#include "InstanceRingBuffer.h"
+#include "Mesh.h"
+#include "Shader.h"
+
+enum class DrawKind
+{
+	// glDrawElements
+	Elements,
+	// glDrawElementsInstancedBaseInstance with instanceCount and baseInstance
+	Instanced,
+	// glDrawElementsIndirect with the command at commandOffset in indirectBuffer
+	Indirect
+};
+
+// one mesh draw with everything needed to issue it later, in any order
+struct DrawPacket
+{
+	std::uint64_t key = 0;
+	// GPU profiler scope the draw is timed in, see RenderQueue::SetPass
+	const char* pass = nullptr;
+	Shader* shader = nullptr;
+	const Mesh* mesh = nullptr;
+
+	DrawKind kind = DrawKind::Elements;
+	unsigned int instanceCount = 0;
+	unsigned int baseInstance = 0;
+	unsigned int indirectBuffer = 0;
+	std::size_t commandOffset = 0;
+
+	// per draw uniforms, skipped when their id is invalid
+	UniformId matrixId;
+	glm::mat4 matrix{ 1.0f };
+	UniformId colorId;
+	glm::vec3 color{ 0.0f };
+};
+
+// state changes of the last Flush, "skipped" counts the binds drawing every packet on its own would have made on top
+struct RenderQueueStats
+{
+	std::size_t packets = 0;
+	std::size_t programChanges = 0;
+	std::size_t programChangesSkipped = 0;
+	std::size_t vertexArrayChanges = 0;
+	std::size_t vertexArrayChangesSkipped = 0;
+	std::size_t textureChanges = 0;
+	std::size_t textureChangesSkipped = 0;
+};
+
+// Collects the draws of a frame and issues them sorted by a 64 bit key, so packets sharing
+// a program, textures and vertex array follow each other and their binds are made once.
+// Key layout, most significant first:
+//   program 8 bits | material 16 bits | vertex array 16 bits | view depth 24 bits
+// names wider than their field only lose ordering, never correctness.
+class RenderQueue
+{
+public:
+	// depth of the following packets is measured along the view, quantized over [0, farPlane]
+	void SetView(const glm::mat4& view, float farPlane);
+
+	// packets added from now on are timed under the name when Flush is given a profiler, nullptr stops tagging them.
+	// the sort does not keep passes together, a pass split by the packets of another one gets a scope for every run of it
+	void SetPass(const char* name);
+
+	// adds a packet with its key built from the shader, the mesh and the world position, fill in the draw before Flush
+	DrawPacket& Add(Shader& shader, const Mesh& mesh, const glm::vec3& worldPosition);
+
+	// the region is fenced once the packets reading it have been issued
+	void FenceAfterFlush(InstanceRingBuffer& ringBuffer);
+
+	// sorts and issues all packets and empties the queue, binds go through the GLStateCache.
+	// with a profiler every run of packets from one pass is timed in its own scope
+	void Flush(GpuProfiler* profiler = nullptr);
+
+	std::size_t GetPacketCount() const;
+	const RenderQueueStats& GetLastStats() const;
+
+	static std::uint64_t MakeSortKey(const Shader& shader, const Mesh& mesh, float depth, float farPlane);
+
+private:
+	void Sort();
+	void Issue(const DrawPacket& packet);
+
+	std::vector<DrawPacket> packets;
+	std::vector<InstanceRingBuffer*> fencedRings;
+
+	// key and packet index pairs, sorted through the scratch array
+	std::vector<std::pair<std::uint64_t, std::uint32_t>> order;
+	std::vector<std::pair<std::uint64_t, std::uint32_t>> orderScratch;
+
+	glm::mat4 view{ 1.0f };
+	float farPlane = 100.0f;
+	const char* pass = nullptr;
+
+	// program and vertex array of the previous packet during Flush
+	unsigned int boundProgram = 0;
+	unsigned int boundVertexArray = 0;
+
+	RenderQueueStats lastStats;
+};
+
+#endif
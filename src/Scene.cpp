@@ -0,0 +1,502 @@
+#include "Scene.h"
+
+#include "GLStateCache.h"
+#include "ModelRegistry.h"
+#include "TextureCache.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include <thread>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace
+{
+	// houses stand 3 units apart, starting from the corner of the plane
+	constexpr float HouseSpacing = 3.0f;
+	constexpr float GridOrigin = -400.0f;
+
+	const char* CullingModes[] = { "None", "CPU", "GPU" };
+
+	const char* StreetLampCounts[] = { "Off", "1k", "4k", "16k" };
+	const std::size_t StreetLampAmounts[] = { 0, 1000, 4000, 16000 };
+
+	// street lamps scattered over the neighbourhood, always the same ones for a given count and grid
+	std::vector<ClusterPointLight> MakeStreetLamps(std::size_t count, int rows, int columns)
+	{
+		std::mt19937 generator(1234);
+		std::uniform_real_distribution<float> positionX(GridOrigin, GridOrigin + HouseSpacing * static_cast<float>(rows));
+		std::uniform_real_distribution<float> positionZ(GridOrigin, GridOrigin + HouseSpacing * static_cast<float>(columns));
+		std::uniform_real_distribution<float> warmth(0.6f, 1.0f);
+
+		std::vector<ClusterPointLight> lamps(count);
+		for (auto& lamp : lamps)
+		{
+			lamp.positionRadius = glm::vec4(positionX(generator), 4.0f, positionZ(generator), 8.0f);
+			lamp.color = glm::vec4(1.0f, warmth(generator), 0.5f * warmth(generator), 0.0f);
+		}
+
+		return lamps;
+	}
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+Scene::Scene(const SceneParams& params) :
+	params(params),
+	loader(std::max(1u, std::thread::hardware_concurrency()) - 1),
+	basicShader("res/shaders/basic.vert", "res/shaders/basic.frag"),
+	lightShader("res/shaders/light.vert", "res/shaders/light.frag"),
+	texturedShader("res/shaders/textured.vert", "res/shaders/light.frag"),
+	cullShader("res/shaders/cull.comp")
+{
+	lightClusters.SetWorkerCount(std::max(1u, std::thread::hardware_concurrency()));
+
+	const int amount = params.rows * params.columns;
+
+	TransformStore::Default().Reserve(2 * amount + 16);
+	TransformStore::Default().SetWorkerCount(std::max(1u, std::thread::hardware_concurrency()));
+	TransformStore::Default().SetMinChunkSize(4096);
+
+	TextureCache::Default().SetArrayPacking(params.textureArrays);
+
+	houseNodes.reserve(amount);
+	roofNodes.reserve(amount);
+
+	std::vector<Transform*> houseTransforms;
+	std::vector<Transform*> roofTransforms;
+
+	cubeModel = std::make_unique<Model>(params.houseModel, false, params.vertexCompression);
+	pyramidModel = std::make_unique<Model>(params.roofModel, false, params.vertexCompression);
+	// the plane is only drawn as a plain object, so it can appear once it is loaded.
+	// the instanced models stay synchronous, their instance attributes are bound to the meshes right away
+	planeModel = ModelRegistry::Default().GetAsync("res/models/plane/plane.obj", loader, false, params.vertexCompression);
+
+	neighbourhood = std::make_unique<Object>(planeModel, &texturedShader);
+
+	auto neighTransform = &neighbourhood->transform;
+
+	glm::mat4 temp = glm::translate(glm::mat4(1.0f), { GridOrigin,0,GridOrigin });
+	for (auto i = 0; i < params.columns; i++)
+	{
+		glm::mat4 model(1.0f);
+		for (auto j = 0; j < params.rows; j++)
+		{
+			auto houseTransform = &houseNodes.emplace_back();
+			auto roofTransform = &roofNodes.emplace_back();
+
+			temp = glm::translate(temp, glm::vec3(HouseSpacing, 0.0f, 0.0f));
+			model = glm::translate(temp, { 0,1.5f,0 });
+
+			houseTransform->SetModelMatrix(model);
+			houseTransform->SetParent(neighTransform);
+
+			houseTransforms.emplace_back(houseTransform);
+
+			roofTransform->SetLocalPosition(glm::vec3(0.0f, 2.0f, 0.0f));
+			roofTransform->SetParent(houseTransforms.back());
+
+			roofTransforms.emplace_back(roofTransform);
+		}
+		temp = glm::translate(temp, glm::vec3(-1.0f * static_cast<float>(params.rows) * HouseSpacing, 0.0f, HouseSpacing));
+	}
+
+	house = std::make_unique<InstancedObject>(cubeModel.get(), &lightShader, houseTransforms);
+	roof = std::make_unique<InstancedObject>(pyramidModel.get(), &lightShader, roofTransforms);
+
+	ModelRegistry& registry = ModelRegistry::Default();
+	spotLightGizmo = std::make_unique<Object>(registry.Get("res/models/pyramid/pyramid.obj", false, params.vertexCompression), &basicShader);
+	spotLight1Gizmo = std::make_unique<Object>(registry.Get("res/models/pyramid/pyramid.obj", false, params.vertexCompression), &basicShader);
+	pointLight = std::make_unique<Object>(registry.Get("res/models/cube/cube.obj", false, params.vertexCompression), &basicShader);
+
+	const auto gizmoScale = glm::vec3(0.2f);
+	spotLightGizmo->transform.SetLocalScale(gizmoScale);
+	spotLight1Gizmo->transform.SetLocalScale(gizmoScale);
+	pointLight->transform.SetLocalScale(gizmoScale);
+
+	spotLightGizmo->transform.SetParent(neighTransform);
+	spotLight1Gizmo->transform.SetParent(neighTransform);
+	pointLight->transform.SetParent(neighTransform);
+
+	neighbourhood->Update();
+
+	house->SetCullShader(&cullShader);
+	roof->SetCullShader(&cullShader);
+	SetCullingMode(static_cast<CullingMode>(cullingMode));
+	SetTextureBinding(params.textureBinding);
+
+	if (params.streetLamps > 0)
+		SetStreetLampCount(params.streetLamps);
+}
+
+Scene::~Scene() = default;
+
+void Scene::DrawInspector()
+{
+	ImGui::Begin("Inspector");
+
+	ImGui::InputInt("Chosen building", &chosenBuilding);
+	ImGui::SliderFloat3("Building local pos", glm::value_ptr(buildingLocalPos), -10.0f, 10.0f);
+	ImGui::InputFloat3("Plane local pos", glm::value_ptr(housesLocalPos));
+
+	ImGui::InputFloat3("N loc", glm::value_ptr(neigbourhoodLocalPos));
+
+	ImGui::Text("MAERIAL");
+	ImGui::SliderFloat("Shininess", &shininess, 0.0f, 256.0f);
+
+	ImGui::Text("MISCELLANEOUS");
+	ImGui::ColorEdit3("clear color", glm::value_ptr(clearColor));
+	ImGui::Checkbox("Blinn-Phong lighting", &isBlinn);
+	ImGui::SliderFloat("Blinn-Phong exponent", &blinnExponent, 2.0f, 256.0f);
+
+	ImGui::Checkbox("Directional light", &isDirLight);
+	ImGui::SliderFloat3("Direction", glm::value_ptr(direction), -1.0f, 1.0f);
+	ImGui::ColorEdit3("Ambient", glm::value_ptr(ambient));
+	ImGui::ColorEdit3("Diffuse", glm::value_ptr(diffuse));
+	ImGui::ColorEdit3("Specular", glm::value_ptr(specular));
+
+	ImGui::Text("POINT LIGHT");
+	ImGui::Checkbox("Point light", &isPointLight);
+
+	ImGui::ColorEdit3("Point light ambient", glm::value_ptr(pointLightAmbient));
+	ImGui::ColorEdit3("Point light diffuse", glm::value_ptr(pointLightDiffuse));
+	ImGui::ColorEdit3("Point light specular", glm::value_ptr(pointLightSpecular));
+	ImGui::InputFloat("Point light constant", &pointLightConstant);
+	ImGui::InputFloat("Point light linear", &pointLightLinear);
+	ImGui::InputFloat("Point light quadratic", &pointLightQuadratic);
+
+	ImGui::Text("SPOT LIGHT");
+	ImGui::Checkbox("Spot light", &isSpotActive);
+	ImGui::DragFloat3("Spot light position", glm::value_ptr(spotLightPosition), .1f, -10.0f, 10.0f);
+	ImGui::SliderFloat3("Spot light direction", glm::value_ptr(spotLightDirection), -1.0f, 1.0f);
+
+	ImGui::ColorEdit3("Spot light ambient", glm::value_ptr(spotLightAmbient));
+	ImGui::ColorEdit3("Spot light diffuse", glm::value_ptr(spotLightDiffuse));
+	ImGui::ColorEdit3("Spot light specular", glm::value_ptr(spotLightSpecular));
+	ImGui::InputFloat("Spot light constant", &spotLightConstant);
+	ImGui::InputFloat("Spot light linear", &spotLightLinear);
+	ImGui::InputFloat("Spot light quadratic", &spotLightQuadratic);
+	ImGui::InputFloat("Spot light cut off", &spotLightCutOff);
+	ImGui::InputFloat("Spot light outer cut off", &spotLightOuterCutOff);
+
+	ImGui::Text("SPOT LIGHT 1");
+	ImGui::Checkbox("Spot light 1", &isSpot1Active);
+	ImGui::DragFloat3("Spot light 1 position", glm::value_ptr(spotLight1Position), .1f, -10.0f, 10.0f);
+	ImGui::SliderFloat3("Spot light 1 direction", glm::value_ptr(spotLight1Direction), -1.0f, 1.0f);
+
+	ImGui::ColorEdit3("Spot light 1 ambient", glm::value_ptr(spotLight1Ambient));
+	ImGui::ColorEdit3("Spot light 1 diffuse", glm::value_ptr(spotLight1Diffuse));
+	ImGui::ColorEdit3("Spot light 1 specular", glm::value_ptr(spotLight1Specular));
+	ImGui::InputFloat("Spot light 1 constant", &spotLight1Constant);
+	ImGui::InputFloat("Spot light 1 linear", &spotLight1Linear);
+	ImGui::InputFloat("Spot light 1 quadratic", &spotLight1Quadratic);
+	ImGui::InputFloat("Spot light 1 cut off", &spotLight1CutOff);
+	ImGui::InputFloat("Spot light 1 outer cut off", &spotLight1OuterCutOff);
+
+	if (ImGui::Checkbox("Persistent instance buffers", &persistentInstanceBuffers))
+		SetInstanceUploadMode(persistentInstanceBuffers ? InstanceUploadMode::PersistentRing : InstanceUploadMode::BufferSubData);
+	if (persistentInstanceBuffers)
+	{
+		ImGui::SameLine();
+		ImGui::Text(InstanceRingBuffer::IsPersistentMappingSupported() ? "(mapped)" : "(orphaning)");
+	}
+
+	if (ImGui::Checkbox("Bindless textures", &bindlessTextures))
+		SetTextureBinding(bindlessTextures ? TextureBinding::Bindless : TextureBinding::Bound);
+	ImGui::SameLine();
+	if (BindlessTextures::IsSupported())
+		ImGui::Text("(%zu resident, %zu materials)", BindlessTextures::Default().GetResidentCount(), BindlessTextures::Default().GetRowCount());
+	else
+		ImGui::Text("(unsupported, bound)");
+
+	if (ImGui::Combo("Frustum culling", &cullingMode, CullingModes, 3))
+		SetCullingMode(static_cast<CullingMode>(cullingMode));
+	if (static_cast<CullingMode>(cullingMode) == CullingMode::Gpu)
+	{
+		// the visible counts never leave the GPU
+		ImGui::Text("Houses and roofs culled on the GPU: %zu + %zu instances", house->GetInstanceCount(), roof->GetInstanceCount());
+	}
+	else
+	{
+		ImGui::Text("Visible houses: %zu / %zu", house->GetVisibleInstanceCount(), house->GetInstanceCount());
+		ImGui::Text("Visible roofs: %zu / %zu", roof->GetVisibleInstanceCount(), roof->GetInstanceCount());
+	}
+
+	if (ImGui::Combo("Street lamps", &streetLamps, StreetLampCounts, 4))
+		SetStreetLampCount(StreetLampAmounts[streetLamps]);
+	ImGui::Text("Clustered lights: %zu, %zu cluster entries, built in %.2f ms", lightClusters.GetLightCount(),
+		lightClusters.GetIndexCount(), lightClusters.GetLastBuildMilliseconds());
+
+	const TextureCache& textureCache = TextureCache::Default();
+	ImGui::Text("Textures: %zu (%zu baked), %.1f MB (%.1f MB unused), %zu hits, %zu misses", textureCache.GetTextureCount(),
+		textureCache.GetCompressedCount(), textureCache.GetResidentBytes() / (1024.0 * 1024.0),
+		textureCache.GetUnusedBytes() / (1024.0 * 1024.0), textureCache.GetHitCount(), textureCache.GetMissCount());
+	const TextureArrays& textureArrays = TextureArrays::Default();
+	ImGui::Text("Texture arrays: %zu, %zu / %zu layers used%s", textureArrays.GetArrayCount(), textureArrays.GetUsedLayerCount(),
+		textureArrays.GetLayerCount(), textureCache.IsArrayPacking() ? "" : " (packing off)");
+
+	const char* VertexCompressions[] = { "float", "packed", "quantized" };
+	ImGui::Text("Vertex format: %s", VertexCompressions[static_cast<int>(params.vertexCompression)]);
+
+	ModelRegistry& modelRegistry = ModelRegistry::Default();
+	if (ImGui::CollapsingHeader("Shared models"))
+	{
+		for (const auto& entry : modelRegistry.GetEntries())
+		{
+			ImGui::Text("%s%s (%s): %ld references, %.1f KB%s", entry.path.c_str(), entry.gamma ? " (sRGB)" : "",
+				VertexCompressions[static_cast<int>(entry.compression)], entry.references, entry.gpuBytes / 1024.0, entry.ready ? "" : ", loading");
+		}
+		ImGui::Text("%zu models, %.1f MB of buffers", modelRegistry.GetModelCount(), modelRegistry.GetGpuBytes() / (1024.0 * 1024.0));
+	}
+
+	if (!loader.IsIdle())
+		ImGui::Text("Loading: %zu uploads pending", loader.GetPendingUploadCount());
+
+	const InstanceUploadStats& uploadStats = InstancedObject::GetFrameUploadStats();
+	ImGui::Text("Instance upload: %zu bytes, %zu instances in %zu ranges", uploadStats.bytes, uploadStats.instances, uploadStats.ranges);
+
+	const RenderQueueStats& queueStats = renderQueue.GetLastStats();
+	ImGui::Text("Render queue: %zu packets, binds made / avoided: programs %zu / %zu, VAOs %zu / %zu, textures %zu / %zu",
+		queueStats.packets, queueStats.programChanges, queueStats.programChangesSkipped, queueStats.vertexArrayChanges,
+		queueStats.vertexArrayChangesSkipped, queueStats.textureChanges, queueStats.textureChangesSkipped);
+
+	const GLStateCacheStats& stateStats = GLStateCache::Default().GetStats();
+	ImGui::Text("GL state cache: %zu calls made, %zu skipped", stateStats.calls, stateStats.skipped);
+
+	if (gpuProfiler && ImGui::CollapsingHeader("GPU profiler"))
+		gpuProfiler->DrawFlameView();
+
+	ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
+	ImGui::End();
+}
+
+void Scene::Update(float time)
+{
+	const auto start = std::chrono::steady_clock::now();
+
+	auto neighTransform = &neighbourhood->transform;
+
+	spotLightGizmo->transform.SetLocalPosition(spotLightPosition);
+	spotLightGizmo->transform.SetLocalRotation(spotLightDirection);
+
+	spotLight1Gizmo->transform.SetLocalPosition(spotLight1Position);
+	spotLight1Gizmo->transform.SetLocalRotation(spotLight1Direction);
+
+	if (buildingLocalPos != prevBuildingLocalPos)
+	{
+		prevBuildingLocalPos = buildingLocalPos;
+		house->instanceTransforms[chosenBuilding]->SetLocalPosition(buildingLocalPos);
+	}
+
+	if (housesLocalPos != prevHousesLocalPos)
+	{
+		prevHousesLocalPos = housesLocalPos;
+		neighTransform->SetLocalPosition(housesLocalPos);
+	}
+
+	house->transform.SetLocalPosition(neigbourhoodLocalPos);
+	house->transform.Update();
+
+	pointLight->transform.SetLocalRotationX(15 * time);
+	pointLight->transform.SetLocalRotationY(15 * time);
+	pointLight->transform.SetLocalPosition({ 10 * glm::sin(time), 10 + 10 * glm::cos(time), 0 });
+
+	neighTransform->Update();
+
+	pointLightPosition = pointLight->transform.GetLocalPosition();
+
+	phaseTimes.update = MillisecondsSince(start);
+}
+
+void Scene::Render(Camera& camera, int width, int height)
+{
+	glViewport(0, 0, width, height);
+
+	GLStateCache& glState = GLStateCache::Default();
+	glState.ResetStats();
+	glState.SetCapability(GLCapability::DepthTest, true);
+	glState.SetCapability(GLCapability::CullFace, true);
+	glState.CullFace(GL_BACK);
+
+	glClearColor(clearColor.x, clearColor.y, clearColor.z, clearColor.w);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	const float aspect = height > 0 ? static_cast<float>(width) / static_cast<float>(height) : 1280.0f / 720.0f;
+	glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), aspect, 0.1f, 100.0f);
+	glm::mat4 VP = projection * camera.GetViewMatrix();
+
+	//...::SHADER UPDATES::...
+	auto phaseStart = std::chrono::steady_clock::now();
+
+	{
+		GpuProfiler::Scope scope(gpuProfiler, "Shader updates");
+
+		LightBlockData lights;
+
+		lights.dirLight.isActive = isDirLight;
+		lights.dirLight.direction = direction;
+		lights.dirLight.colors = { ambient, 0, diffuse, 0, specular };
+
+		//POINT LIGHT
+		lights.pointLights[0].isActive = isPointLight;
+		lights.pointLights[0].position = pointLightPosition;
+		lights.pointLights[0].att = { pointLightConstant, pointLightLinear, pointLightQuadratic };
+		lights.pointLights[0].colors = { pointLightAmbient, 0, pointLightDiffuse, 0, pointLightSpecular };
+
+		//SPOT LIGHT
+		lights.spotLights[0].isActive = isSpotActive;
+		lights.spotLights[0].position = spotLightPosition;
+		lights.spotLights[0].direction = spotLightDirection;
+		lights.spotLights[0].cutOff = glm::cos(glm::radians(spotLightCutOff));
+		lights.spotLights[0].outerCutOff = glm::cos(glm::radians(spotLightOuterCutOff));
+		lights.spotLights[0].att = { spotLightConstant, spotLightLinear, spotLightQuadratic };
+		lights.spotLights[0].colors = { spotLightAmbient, 0, spotLightDiffuse, 0, spotLightSpecular };
+
+		//SPOT LIGHT
+		lights.spotLights[1].isActive = isSpot1Active;
+		lights.spotLights[1].position = spotLight1Position;
+		lights.spotLights[1].direction = spotLight1Direction;
+		lights.spotLights[1].cutOff = glm::cos(glm::radians(spotLight1CutOff));
+		lights.spotLights[1].outerCutOff = glm::cos(glm::radians(spotLight1OuterCutOff));
+		lights.spotLights[1].att = { spotLight1Constant, spotLight1Linear, spotLight1Quadratic };
+		lights.spotLights[1].colors = { spotLight1Ambient, 0, spotLight1Diffuse, 0, spotLight1Specular };
+
+		// one upload serves lightShader and texturedShader
+		lightBlock.Upload(lights);
+
+		lightClusters.Build(camera.GetViewMatrix(), glm::radians(camera.Zoom), aspect, 0.1f, 100.0f,
+			glm::vec2(static_cast<float>(width), static_cast<float>(height)));
+
+		phaseTimes.lights = MillisecondsSince(phaseStart);
+		phaseStart = std::chrono::steady_clock::now();
+
+		lightShader.use();
+		lightShader.setMat4("VP", VP);
+		lightShader.setVec3("viewPos", camera.Position);
+
+		lightShader.setFloat("shininess", shininess);
+		lightShader.setVec3("offset", buildingLocalPos);
+		lightShader.setInt("chosenInstance", chosenBuilding);
+
+		lightShader.setBool("isBlinn", isBlinn);
+		lightShader.setFloat("blinnExponent", blinnExponent);
+		lightShader.setBool("bindlessTextures", BindlessTextures::Default().IsEnabled());
+
+		texturedShader.use();
+		texturedShader.setMat4("VP", VP);
+		texturedShader.setVec3("viewPos", camera.Position);
+
+		texturedShader.setFloat("shininess", shininess);
+
+		texturedShader.setBool("isBlinn", isBlinn);
+		texturedShader.setFloat("blinnExponent", blinnExponent);
+		texturedShader.setBool("bindlessTextures", BindlessTextures::Default().IsEnabled());
+
+		basicShader.use();
+		basicShader.setMat4("VP", VP);
+		basicShader.setVec3("diffuse", pointLightDiffuse * pointLightAmbient * pointLightSpecular);
+	}
+	//...::SHADER UPDATES END::...
+
+	phaseTimes.shaders = MillisecondsSince(phaseStart);
+	phaseStart = std::chrono::steady_clock::now();
+
+	const Frustum frustum = Frustum::FromMatrix(VP);
+	house->Cull(frustum);
+	roof->Cull(frustum);
+
+	phaseTimes.culling = MillisecondsSince(phaseStart);
+	phaseStart = std::chrono::steady_clock::now();
+
+	InstancedObject::ResetFrameUploadStats();
+
+	pointLight->SetColor(pointLightDiffuse * pointLightAmbient * pointLightSpecular);
+	spotLightGizmo->SetColor(spotLightDiffuse * spotLightAmbient * spotLightSpecular);
+	spotLight1Gizmo->SetColor(spotLight1Diffuse * spotLight1Ambient * spotLight1Specular);
+
+	// instance uploads and GPU culling run while submitting, the draws themselves are issued sorted by the flush
+	renderQueue.SetView(camera.GetViewMatrix(), 100.0f);
+	{
+		GpuProfiler::Scope scope(gpuProfiler, "Submit");
+		renderQueue.SetPass("Plane draw");
+		neighbourhood->Submit(renderQueue);
+		renderQueue.SetPass("House draw");
+		house->Submit(renderQueue);
+		renderQueue.SetPass("Roof draw");
+		roof->Submit(renderQueue);
+		renderQueue.SetPass("Gizmos");
+		pointLight->Submit(renderQueue);
+		spotLightGizmo->Submit(renderQueue);
+		spotLight1Gizmo->Submit(renderQueue);
+		renderQueue.SetPass(nullptr);
+	}
+	{
+		// the passes are timed inside the flush, nested in this scope
+		GpuProfiler::Scope scope(gpuProfiler, "Draw");
+		renderQueue.Flush(gpuProfiler);
+	}
+
+	phaseTimes.draw = MillisecondsSince(phaseStart);
+}
+
+void Scene::ProcessLoading(double budgetMilliseconds)
+{
+	loader.ProcessUploads(budgetMilliseconds);
+}
+
+void Scene::FinishLoading()
+{
+	loader.Finish();
+}
+
+void Scene::SetCullingMode(CullingMode mode)
+{
+	cullingMode = static_cast<int>(mode);
+	house->SetCullingMode(mode);
+	roof->SetCullingMode(mode);
+}
+
+void Scene::SetInstanceUploadMode(InstanceUploadMode mode)
+{
+	persistentInstanceBuffers = mode == InstanceUploadMode::PersistentRing;
+	house->SetUploadMode(mode);
+	roof->SetUploadMode(mode);
+}
+
+void Scene::SetStreetLampCount(std::size_t count)
+{
+	lightClusters.SetLights(MakeStreetLamps(count, params.rows, params.columns));
+}
+
+void Scene::SetTextureBinding(TextureBinding binding)
+{
+	bindlessTextures = binding == TextureBinding::Bindless;
+	BindlessTextures::Default().SetMode(binding);
+}
+
+void Scene::SetGpuProfiler(GpuProfiler* profiler)
+{
+	gpuProfiler = profiler;
+}
+
+const SceneParams& Scene::GetParams() const
+{
+	return params;
+}
+
+const ScenePhaseTimes& Scene::GetPhaseTimes() const
+{
+	return phaseTimes;
+}
+
+LightClusters& Scene::GetLightClusters()
+{
+	return lightClusters;
+}
@@ -0,0 +1,187 @@
+#pragma once
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "AsyncLoader.h"
+#include "BindlessTextures.h"
+#include "Camera.h"
+#include "GpuProfiler.h"
+#include "LightBlock.h"
+#include "LightClusters.h"
+#include "Object.h"
+#include "RenderQueue.h"
+#include "Shader.h"
+
+// what the neighbourhood is made of, the defaults are the scene the application opens with
+struct SceneParams
+{
+	// houses along x and along z
+	int rows = 200;
+	int columns = 200;
+	// street lamps fed to the clustered lighting
+	std::size_t streetLamps = 0;
+	std::string houseModel = "res/models/cube/cube.obj";
+	std::string roofModel = "res/models/pyramid/pyramid.obj";
+	// vertex buffer layout of the meshes the scene loads
+	VertexCompression vertexCompression = VertexCompression::None;
+	// bindless is opt-in and only takes effect where ARB_bindless_texture is supported
+	TextureBinding textureBinding = TextureBinding::Bound;
+	// textures of the same size and format are packed into texture arrays as they load
+	bool textureArrays = true;
+};
+
+// CPU milliseconds spent in each phase of the last Update and Render
+struct ScenePhaseTimes
+{
+	double update = 0.0;
+	double shaders = 0.0;
+	double lights = 0.0;
+	double culling = 0.0;
+	double draw = 0.0;
+};
+
+// The neighbourhood: its shaders, models, objects and lights.
+// It only needs a current GL context, so the same scene is drawn into the window and into the headless framebuffer.
+class Scene
+{
+public:
+	explicit Scene(const SceneParams& params = SceneParams());
+	~Scene();
+
+	Scene(const Scene&) = delete;
+	Scene& operator=(const Scene&) = delete;
+
+	// ImGui window with all the scene settings, needs an ImGui frame in progress
+	void DrawInspector();
+
+	// animates the scene to the given time in seconds and propagates the transforms
+	void Update(float time);
+
+	// draws the scene as seen by camera into the currently bound framebuffer
+	void Render(Camera& camera, int width, int height);
+
+	// runs background load uploads for at most the budget, call once per frame on the GL thread
+	void ProcessLoading(double budgetMilliseconds);
+	// blocks until every model finished loading, for runs that must look the same from the first frame
+	void FinishLoading();
+
+	void SetCullingMode(CullingMode mode);
+	// how the house and roof instance matrices reach the GPU
+	void SetInstanceUploadMode(InstanceUploadMode mode);
+	void SetStreetLampCount(std::size_t count);
+	// applies to every material, see BindlessTextures
+	void SetTextureBinding(TextureBinding binding);
+
+	// passes of Render are timed on the GPU and shown in the inspector while a profiler is set
+	void SetGpuProfiler(GpuProfiler* profiler);
+
+	const SceneParams& GetParams() const;
+	const ScenePhaseTimes& GetPhaseTimes() const;
+	LightClusters& GetLightClusters();
+
+private:
+	SceneParams params;
+	ScenePhaseTimes phaseTimes;
+	GpuProfiler* gpuProfiler = nullptr;
+
+	// declared before the models, so it is destroyed after them
+	AsyncLoader loader;
+
+	Shader basicShader;
+	Shader lightShader;
+	Shader texturedShader;
+	Shader cullShader;
+
+	LightBlock lightBlock;
+	LightClusters lightClusters;
+
+	// every object is drawn through it, sorted to share binds
+	RenderQueue renderQueue;
+
+	glm::vec4 clearColor{ .22f, .22f, .22f, 1.00f };
+
+	float shininess = 2.0f;
+	bool isBlinn = false;
+	float blinnExponent = 32.0f;
+
+	//DIR LIGHT PROPERTIES
+	bool isDirLight = true;
+	glm::vec3 direction{ 0.0f };
+	glm::vec3 ambient{ .19f };
+	glm::vec3 diffuse{ 0.0f };
+	glm::vec3 specular{ 0.0f };
+
+	//POINT LIGHT PROPERTIES
+	bool isPointLight = false;
+	glm::vec3 pointLightPosition{ 0.0f };
+	glm::vec3 pointLightAmbient{ 1.0f };
+	glm::vec3 pointLightDiffuse{ 1.0f };
+	glm::vec3 pointLightSpecular{ 1.0f };
+	float pointLightConstant = 1.0f;
+	float pointLightLinear = .7f;
+	float pointLightQuadratic = 1.8f;
+
+	//SPOTLIGHT PROPERTIES
+	bool isSpotActive = false;
+	glm::vec3 spotLightPosition{ 0.0f };
+	glm::vec3 spotLightDirection{ 0.0f };
+	glm::vec3 spotLightAmbient{ 1.0f };
+	glm::vec3 spotLightDiffuse{ 1.0f };
+	glm::vec3 spotLightSpecular{ 1.0f };
+	float spotLightConstant = 1.0f;
+	float spotLightLinear = .7f;
+	float spotLightQuadratic = 1.8f;
+	float spotLightCutOff = 12.5f;
+	float spotLightOuterCutOff = 17.5f;
+
+	bool isSpot1Active = false;
+	glm::vec3 spotLight1Position{ 0.0f };
+	glm::vec3 spotLight1Direction{ 0.0f };
+	glm::vec3 spotLight1Ambient{ 1.0f };
+	glm::vec3 spotLight1Diffuse{ 1.0f };
+	glm::vec3 spotLight1Specular{ 1.0f };
+	float spotLight1Constant = 1.0f;
+	float spotLight1Linear = .7f;
+	float spotLight1Quadratic = 1.8f;
+	float spotLight1CutOff = 12.5f;
+	float spotLight1OuterCutOff = 17.5f;
+
+	// the instanced models are their own, the others come from the ModelRegistry
+	std::unique_ptr<Model> cubeModel;
+	std::unique_ptr<Model> pyramidModel;
+	std::shared_ptr<Model> planeModel;
+
+	std::unique_ptr<Object> neighbourhood;
+
+	// all nodes of the grid live next to each other in the transform store
+	std::vector<Transform> houseNodes;
+	std::vector<Transform> roofNodes;
+
+	std::unique_ptr<InstancedObject> house;
+	std::unique_ptr<InstancedObject> roof;
+
+	std::unique_ptr<Object> spotLightGizmo;
+	std::unique_ptr<Object> spotLight1Gizmo;
+	std::unique_ptr<Object> pointLight;
+
+	int chosenBuilding = 0;
+	bool persistentInstanceBuffers = false;
+	bool bindlessTextures = false;
+	int cullingMode = static_cast<int>(CullingMode::Cpu);
+	int streetLamps = 0;
+
+	glm::vec3 buildingLocalPos{ 0.0f };
+	glm::vec3 prevBuildingLocalPos{ 0.0f };
+	glm::vec3 housesLocalPos{ 0.0f };
+	glm::vec3 prevHousesLocalPos{ 0.0f };
+	glm::vec3 neigbourhoodLocalPos{ 0.0f };
+};
+
+#endif
@@ -0,0 +1,17 @@
+#include "ScriptedCamera.h"
+
+#include <algorithm>
+
+namespace
+{
+	const glm::vec3 PathCenter(-100.0f, 0.0f, -100.0f);
+	constexpr float PathRadius = 40.0f;
+	constexpr float PathHeight = 20.0f;
+}
+
+void PlaceScriptedCamera(Camera& camera, int frame, int frameCount)
+{
+	const float angle = glm::radians(360.0f) * static_cast<float>(frame) / static_cast<float>(std::max(frameCount, 1));
+	const glm::vec3 position = PathCenter + glm::vec3(PathRadius * glm::cos(angle), PathHeight, PathRadius * glm::sin(angle));
+	camera.LookAt(position, PathCenter);
+}
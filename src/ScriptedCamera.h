@@ -0,0 +1,13 @@
+#pragma once
+#ifndef SCRIPTED_CAMERA_H
+#define SCRIPTED_CAMERA_H
+
+#include "Camera.h"
+
+// time step of scripted runs, the scene advances by it every frame whatever the frame took to render
+constexpr float ScriptedFrameTime = 1.0f / 60.0f;
+
+// places the camera on a circle over the middle of the neighbourhood, one full turn over frameCount frames
+void PlaceScriptedCamera(Camera& camera, int frame, int frameCount);
+
+#endif
@@ -1,8 +1,64 @@
 #include "Shader.h"
 
+#include "GLStateCache.h"
+
 #include <iostream>
 #include <fstream>
 
+namespace
+{
+	// every sampler type GL 4.3 reports through glGetActiveUniform, images use image units and are left out
+	bool IsSamplerType(GLenum type)
+	{
+		switch (type)
+		{
+		case GL_SAMPLER_1D:
+		case GL_SAMPLER_2D:
+		case GL_SAMPLER_3D:
+		case GL_SAMPLER_CUBE:
+		case GL_SAMPLER_1D_SHADOW:
+		case GL_SAMPLER_2D_SHADOW:
+		case GL_SAMPLER_1D_ARRAY:
+		case GL_SAMPLER_2D_ARRAY:
+		case GL_SAMPLER_CUBE_MAP_ARRAY:
+		case GL_SAMPLER_1D_ARRAY_SHADOW:
+		case GL_SAMPLER_2D_ARRAY_SHADOW:
+		case GL_SAMPLER_2D_MULTISAMPLE:
+		case GL_SAMPLER_2D_MULTISAMPLE_ARRAY:
+		case GL_SAMPLER_CUBE_SHADOW:
+		case GL_SAMPLER_CUBE_MAP_ARRAY_SHADOW:
+		case GL_SAMPLER_BUFFER:
+		case GL_SAMPLER_2D_RECT:
+		case GL_SAMPLER_2D_RECT_SHADOW:
+		case GL_INT_SAMPLER_1D:
+		case GL_INT_SAMPLER_2D:
+		case GL_INT_SAMPLER_3D:
+		case GL_INT_SAMPLER_CUBE:
+		case GL_INT_SAMPLER_1D_ARRAY:
+		case GL_INT_SAMPLER_2D_ARRAY:
+		case GL_INT_SAMPLER_CUBE_MAP_ARRAY:
+		case GL_INT_SAMPLER_2D_MULTISAMPLE:
+		case GL_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+		case GL_INT_SAMPLER_BUFFER:
+		case GL_INT_SAMPLER_2D_RECT:
+		case GL_UNSIGNED_INT_SAMPLER_1D:
+		case GL_UNSIGNED_INT_SAMPLER_2D:
+		case GL_UNSIGNED_INT_SAMPLER_3D:
+		case GL_UNSIGNED_INT_SAMPLER_CUBE:
+		case GL_UNSIGNED_INT_SAMPLER_1D_ARRAY:
+		case GL_UNSIGNED_INT_SAMPLER_2D_ARRAY:
+		case GL_UNSIGNED_INT_SAMPLER_CUBE_MAP_ARRAY:
+		case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE:
+		case GL_UNSIGNED_INT_SAMPLER_2D_MULTISAMPLE_ARRAY:
+		case GL_UNSIGNED_INT_SAMPLER_BUFFER:
+		case GL_UNSIGNED_INT_SAMPLER_2D_RECT:
+			return true;
+		default:
+			return false;
+		}
+	}
+}
+
 Shader::Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath)
 {
 	// 1. retrieve the vertex/fragment source code from filePath
@@ -85,75 +141,263 @@ Shader::Shader(const char* vertexPath, const char* fragmentPath, const char* geo
 	if (geometryPath != nullptr)
 		glDeleteShader(geometry);
 
+	cacheUniformLocations();
+}
+
+Shader::Shader(const char* computePath)
+{
+	// 1. retrieve the compute source code from filePath
+	std::string computeCode;
+	std::ifstream cShaderFile;
+	// ensure ifstream objects can throw exceptions:
+	cShaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
+	try
+	{
+		cShaderFile.open(computePath);
+		std::stringstream cShaderStream;
+		cShaderStream << cShaderFile.rdbuf();
+		cShaderFile.close();
+		computeCode = cShaderStream.str();
+	}
+	catch (std::ifstream::failure& e)
+	{
+		std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+	}
+
+	const char* cShaderCode = computeCode.c_str();
+	// 2. compile shader
+	unsigned int compute = glCreateShader(GL_COMPUTE_SHADER);
+	glShaderSource(compute, 1, &cShaderCode, NULL);
+	glCompileShader(compute);
+	checkCompileErrors(compute, "COMPUTE");
+	// shader Program
+	ID = glCreateProgram();
+	glAttachShader(ID, compute);
+	glLinkProgram(ID);
+	checkCompileErrors(ID, "PROGRAM");
+	// delete the shader as it's linked into our program now and no longer necessery
+	glDeleteShader(compute);
+
+	cacheUniformLocations();
 }
+
 // activate the shader
 // ------------------------------------------------------------------------
 void Shader::use()
 {
-	glUseProgram(ID);
+	GLStateCache::Default().UseProgram(ID);
+}
+
+// uniform lookup
+// ------------------------------------------------------------------------
+int Shader::GetSamplerUnit(const std::string& name) const
+{
+	const auto found = samplerUnits.find(name);
+	return found != samplerUnits.end() ? found->second : -1;
+}
+
+UniformId Shader::GetUniformId(const std::string& name) const
+{
+	const auto found = uniformLocations.find(name);
+	if (found != uniformLocations.end())
+		return { found->second };
+
+	const GLint location = glGetUniformLocation(ID, name.c_str());
+	uniformLocations.emplace(name, location);
+	return { location };
 }
 // utility uniform functions
 // ------------------------------------------------------------------------
 void Shader::setBool(const std::string& name, bool value) const
 {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+	setBool(GetUniformId(name), value);
 }
 
 void Shader::setInt(const std::string& name, int value) const
 {
-	glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+	setInt(GetUniformId(name), value);
 }
 
 void Shader::setFloat(const std::string& name, float value) const
 {
-	glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+	setFloat(GetUniformId(name), value);
 }
 
 void Shader::setVec2(const std::string& name, const glm::vec2& value) const
 {
-	glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+	setVec2(GetUniformId(name), value);
 }
 
 void Shader::setVec2(const std::string& name, float x, float y) const
 {
-	glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+	glUniform2f(GetUniformId(name).location, x, y);
 }
 
 void Shader::setVec3(const std::string& name, const glm::vec3& value) const
 {
-	glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+	setVec3(GetUniformId(name), value);
 }
 
 void Shader::setVec3(const std::string& name, float x, float y, float z) const
 {
-	glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+	glUniform3f(GetUniformId(name).location, x, y, z);
 }
 
 void Shader::setVec4(const std::string& name, const glm::vec4& value) const
 {
-	glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+	setVec4(GetUniformId(name), value);
 }
 
 void Shader::setVec4(const std::string& name, float x, float y, float z, float w) const
 {
-	glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+	glUniform4f(GetUniformId(name).location, x, y, z, w);
 }
 
 void Shader::setMat2(const std::string& name, const glm::mat2& mat) const
 {
-	glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	setMat2(GetUniformId(name), mat);
 }
 
 void Shader::setMat3(const std::string& name, const glm::mat3& mat) const
 {
-	glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	setMat3(GetUniformId(name), mat);
 }
 
 void Shader::setMat4(const std::string& name, const glm::mat4& mat) const
 {
-	glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	setMat4(GetUniformId(name), mat);
+}
+
+void Shader::setBool(UniformId id, bool value) const
+{
+	glUniform1i(id.location, (int)value);
+}
+
+void Shader::setInt(UniformId id, int value) const
+{
+	glUniform1i(id.location, value);
+}
+
+void Shader::setFloat(UniformId id, float value) const
+{
+	glUniform1f(id.location, value);
+}
+
+void Shader::setVec2(UniformId id, const glm::vec2& value) const
+{
+	glUniform2fv(id.location, 1, &value[0]);
 }
 
+void Shader::setVec3(UniformId id, const glm::vec3& value) const
+{
+	glUniform3fv(id.location, 1, &value[0]);
+}
+
+void Shader::setPositionTransform(const glm::vec3& offset, const glm::vec3& scale) const
+{
+	if (offset != positionOffset)
+	{
+		positionOffset = offset;
+		setVec3(positionOffsetId, offset);
+	}
+
+	if (scale != positionScale)
+	{
+		positionScale = scale;
+		setVec3(positionScaleId, scale);
+	}
+}
+
+void Shader::setVec4(UniformId id, const glm::vec4& value) const
+{
+	glUniform4fv(id.location, 1, &value[0]);
+}
+
+void Shader::setVec4Array(UniformId id, const glm::vec4* values, int count) const
+{
+	glUniform4fv(id.location, count, &values[0][0]);
+}
+
+void Shader::setIVec4(UniformId id, const glm::ivec4& value) const
+{
+	glUniform4iv(id.location, 1, &value[0]);
+}
+
+void Shader::setMat2(UniformId id, const glm::mat2& mat) const
+{
+	glUniformMatrix2fv(id.location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::setMat3(UniformId id, const glm::mat3& mat) const
+{
+	glUniformMatrix3fv(id.location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::setMat4(UniformId id, const glm::mat4& mat) const
+{
+	glUniformMatrix4fv(id.location, 1, GL_FALSE, &mat[0][0]);
+}
+
+void Shader::cacheUniformLocations()
+{
+	uniformLocations.clear();
+	samplerUnits.clear();
+	int nextSamplerUnit = 0;
+
+	GLint uniformCount = 0;
+	GLint maxNameLength = 0;
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::string name(static_cast<std::size_t>(maxNameLength > 0 ? maxNameLength : 1), '\0');
+	for (GLint i = 0; i < uniformCount; i++)
+	{
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(ID, static_cast<GLuint>(i), maxNameLength, &length, &size, &type, &name[0]);
+
+		const std::string uniformName = name.substr(0, static_cast<std::size_t>(length));
+		const GLint location = glGetUniformLocation(ID, uniformName.c_str());
+		// uniforms inside blocks have no location
+		if (location == -1)
+			continue;
+
+		uniformLocations.emplace(uniformName, location);
+
+		if (IsSamplerType(type))
+		{
+			// array elements take consecutive units
+			const std::string baseName = uniformName.substr(0, uniformName.rfind("[0]"));
+			samplerUnits.emplace(baseName, nextSamplerUnit);
+			for (GLint element = 0; element < size; element++)
+			{
+				const GLint elementLocation = element == 0 ? location
+					: glGetUniformLocation(ID, (baseName + "[" + std::to_string(element) + "]").c_str());
+				glProgramUniform1i(ID, elementLocation, nextSamplerUnit++);
+			}
+		}
+
+		// arrays are reported as "name[0]", register the plain name and every element as well
+		const std::size_t bracket = uniformName.rfind("[0]");
+		if (bracket != std::string::npos && bracket + 3 == uniformName.size())
+		{
+			const std::string baseName = uniformName.substr(0, bracket);
+			uniformLocations.emplace(baseName, location);
+
+			for (GLint element = 1; element < size; element++)
+			{
+				const std::string elementName = baseName + "[" + std::to_string(element) + "]";
+				uniformLocations.emplace(elementName, glGetUniformLocation(ID, elementName.c_str()));
+			}
+		}
+	}
+
+	positionOffsetId = GetUniformId("positionOffset");
+	positionScaleId = GetUniformId("positionScale");
+	positionOffset = glm::vec3(0.0f);
+	positionScale = glm::vec3(0.0f);
+}
 
 void Shader::checkCompileErrors(GLuint shader,const std::string& type)
 {
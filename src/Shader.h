@@ -7,6 +7,15 @@
 
 #include <string>
 #include <sstream>
+#include <unordered_map>
+
+// location of a uniform resolved once, setters taking it skip the name lookup entirely
+struct UniformId
+{
+    GLint location = -1;
+
+    bool IsValid() const { return location != -1; }
+};
 
 class Shader
 {
@@ -15,8 +24,15 @@ public:
     // constructor generates the shader on the fly
     // ------------------------------------------------------------------------
     Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr);
+    // constructor generating a compute shader program
+    // ------------------------------------------------------------------------
+    explicit Shader(const char* computePath);
 
     void use();
+    // resolves a uniform name through the table built after linking, keep the result for hot paths
+    UniformId GetUniformId(const std::string &name) const;
+    // texture unit the sampler uniform was pointed at after linking, -1 when the program has no such sampler
+    int GetSamplerUnit(const std::string &name) const;
     void setBool(const std::string &name, bool value) const;
     void setInt(const std::string &name, int value) const;
     void setFloat(const std::string &name, float value) const;
@@ -30,10 +46,39 @@ public:
     void setMat3(const std::string &name, const glm::mat3 &mat) const;
     void setMat4(const std::string &name, const glm::mat4 &mat) const;
 
+    void setBool(UniformId id, bool value) const;
+    void setInt(UniformId id, int value) const;
+    void setFloat(UniformId id, float value) const;
+    void setVec2(UniformId id, const glm::vec2 &value) const;
+    void setVec3(UniformId id, const glm::vec3 &value) const;
+    void setVec4(UniformId id, const glm::vec4 &value) const;
+    void setVec4Array(UniformId id, const glm::vec4* values, int count) const;
+    void setIVec4(UniformId id, const glm::ivec4 &value) const;
+    void setMat2(UniformId id, const glm::mat2 &mat) const;
+    void setMat3(UniformId id, const glm::mat3 &mat) const;
+    void setMat4(UniformId id, const glm::mat4 &mat) const;
+    // sets positionOffset and positionScale, skipping the ones the program already holds,
+    // so float layouts set the identity once and only quantized meshes keep changing them
+    void setPositionTransform(const glm::vec3 &offset, const glm::vec3 &scale) const;
+
 private:
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, const std::string& type);
+    // fills uniformLocations with every active uniform of the linked program,
+    // and gives every sampler a unit of its own, so drawing never has to set one
+    void cacheUniformLocations();
+
+    // names missing after linking are looked up once and remembered as well
+    mutable std::unordered_map<std::string, GLint> uniformLocations;
+    std::unordered_map<std::string, int> samplerUnits;
+
+    // position dequantization uniforms resolved after linking, and the values the program holds,
+    // starting at the zeros GL initializes uniforms with
+    UniformId positionOffsetId;
+    UniformId positionScaleId;
+    mutable glm::vec3 positionOffset = glm::vec3(0.0f);
+    mutable glm::vec3 positionScale = glm::vec3(0.0f);
 };
 
 
@@ -0,0 +1,124 @@
+#include "TextureArrays.h"
+
+#include "GLStateCache.h"
+#include "TextureLoader.h"
+
+#include <glad/glad.h>
+
+#include <algorithm>
+
+TextureArrays& TextureArrays::Default()
+{
+	static TextureArrays textureArrays;
+	return textureArrays;
+}
+
+bool TextureArrays::CanPack(const DecodedTexture& texture)
+{
+	if (texture.levels.empty() || texture.width <= 0 || texture.height <= 0)
+		return false;
+	if (texture.width > MaxLayerSize || texture.height > MaxLayerSize)
+		return false;
+	return texture.levels.size() == 1 || static_cast<int>(texture.levels.size()) == GetMipLevelCount(texture.width, texture.height);
+}
+
+TextureLayer TextureArrays::Add(unsigned int view, const DecodedTexture& texture, bool gamma)
+{
+	// glTextureView only takes names that were never bound, anything else is uploaded on its own
+	if (!CanPack(texture) || glIsTexture(view))
+		return {};
+
+	const unsigned int format = GetLayerFormat(texture, gamma);
+	const int levels = GetMipLevelCount(texture.width, texture.height);
+	Array& array = FindFreeArray(texture.width, texture.height, format);
+
+	TextureLayer layer;
+	layer.array = array.texture;
+	layer.layer = array.freeLayers.back();
+	array.freeLayers.pop_back();
+
+	UploadTextureLayer(array.texture, layer.layer, texture, gamma);
+
+	glTextureView(view, GL_TEXTURE_2D, array.texture, format, 0, static_cast<GLuint>(levels), static_cast<GLuint>(layer.layer), 1);
+
+	GLStateCache::Default().BindTexture(GL_TEXTURE_2D, view);
+	// only this layer, the others keep the levels they were given
+	if (texture.levels.size() == 1)
+		glGenerateMipmap(GL_TEXTURE_2D);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	return layer;
+}
+
+void TextureArrays::Remove(const TextureLayer& layer)
+{
+	const auto found = std::find_if(arrays.begin(), arrays.end(), [&layer](const Array& array) { return array.texture == layer.array; });
+	if (found == arrays.end() || !layer.IsValid())
+		return;
+
+	found->freeLayers.push_back(layer.layer);
+	if (static_cast<int>(found->freeLayers.size()) < found->layers)
+		return;
+
+	// views of the layers keep the storage alive until they are deleted as well
+	GLStateCache::Default().DeleteTextures(1, &found->texture);
+	arrays.erase(found);
+}
+
+std::size_t TextureArrays::GetArrayCount() const
+{
+	return arrays.size();
+}
+
+std::size_t TextureArrays::GetLayerCount() const
+{
+	std::size_t layers = 0;
+	for (const auto& array : arrays)
+		layers += static_cast<std::size_t>(array.layers);
+	return layers;
+}
+
+std::size_t TextureArrays::GetUsedLayerCount() const
+{
+	std::size_t used = 0;
+	for (const auto& array : arrays)
+		used += static_cast<std::size_t>(array.layers) - array.freeLayers.size();
+	return used;
+}
+
+TextureArrays::Array& TextureArrays::FindFreeArray(int width, int height, unsigned int format)
+{
+	int sameFormat = 0;
+	for (auto& array : arrays)
+	{
+		if (array.width != width || array.height != height || array.format != format)
+			continue;
+		if (!array.freeLayers.empty())
+			return array;
+		sameFormat++;
+	}
+
+	Array& array = arrays.emplace_back();
+	array.width = width;
+	array.height = height;
+	array.format = format;
+	array.layers = std::min(FirstLayers << std::min(sameFormat, 8), MaxLayers);
+	// the lowest layers are handed out first
+	for (int layer = array.layers - 1; layer >= 0; layer--)
+		array.freeLayers.push_back(layer);
+
+	glGenTextures(1, &array.texture);
+	GLStateCache::Default().BindTexture(GL_TEXTURE_2D_ARRAY, array.texture);
+	glTexStorage3D(GL_TEXTURE_2D_ARRAY, GetMipLevelCount(width, height), format, width, height, array.layers);
+
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	return array;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#ifndef TEXTURE_ARRAYS_H
+#define TEXTURE_ARRAYS_H
+
+#include <cstddef>
+#include <vector>
+
+struct DecodedTexture;
+
+// where a packed texture lives
+struct TextureLayer
+{
+	unsigned int array = 0;
+	int layer = -1;
+
+	bool IsValid() const { return layer >= 0; }
+};
+
+// Textures of the same size and format packed as layers of shared GL_TEXTURE_2D_ARRAYs, so meshes using different ones
+// can be drawn with a single binding and a layer index. Images are not resampled, only textures that already match share an array.
+// Every packed texture also gets a GL_TEXTURE_2D view of its layer under its own name, which code sampling plain textures
+// (and bindless handles) keeps using without a copy of the pixels.
+// Arrays have immutable storage, so a full one is never grown: the next array of a format gets twice the layers, up to MaxLayers.
+// Only used from the GL thread.
+class TextureArrays
+{
+public:
+	// layers of the first array of a format
+	static constexpr int FirstLayers = 2;
+	static constexpr int MaxLayers = 32;
+	// larger textures are kept on their own, a few spare layers of them would cost more than the binds they save
+	static constexpr int MaxLayerSize = 1024;
+
+	// arrays of the one context the application renders with
+	static TextureArrays& Default();
+
+	// whether Add takes the texture: not larger than MaxLayerSize, with only the base level or all of them
+	static bool CanPack(const DecodedTexture& texture);
+
+	// uploads the texture into a free layer of an array of its size and format and makes view a GL_TEXTURE_2D view of it.
+	// view must be a name from glGenTextures that was never bound, for any other the layer comes back invalid.
+	// base level only textures get their mip levels generated
+	TextureLayer Add(unsigned int view, const DecodedTexture& texture, bool gamma);
+
+	// frees the layer for the next texture of the format, an array without textures is deleted. the view is left to the caller
+	void Remove(const TextureLayer& layer);
+
+	std::size_t GetArrayCount() const;
+	std::size_t GetLayerCount() const;
+	std::size_t GetUsedLayerCount() const;
+
+private:
+	TextureArrays() = default;
+
+	struct Array
+	{
+		unsigned int texture = 0;
+		int width = 0;
+		int height = 0;
+		unsigned int format = 0;
+		int layers = 0;
+		std::vector<int> freeLayers;
+	};
+
+	// an array of the size and format with a free layer, a new one when all of them are full
+	Array& FindFreeArray(int width, int height, unsigned int format);
+
+	std::vector<Array> arrays;
+};
+
+#endif
@@ -0,0 +1,225 @@
+#include "TextureCache.h"
+
+#include "BindlessTextures.h"
+#include "CpuProfiler.h"
+#include "GLStateCache.h"
+#include "PathUtils.h"
+#include "TextureLoader.h"
+
+#include <glad/glad.h>
+
+#include <functional>
+#include <iostream>
+
+TextureCache& TextureCache::Default()
+{
+	static TextureCache cache;
+	return cache;
+}
+
+bool TextureCache::Key::operator==(const Key& other) const
+{
+	return gamma == other.gamma && path == other.path;
+}
+
+std::size_t TextureCache::KeyHash::operator()(const Key& key) const
+{
+	return std::hash<std::string>()(key.path) ^ static_cast<std::size_t>(key.gamma);
+}
+
+unsigned int TextureCache::Acquire(const std::string& path, bool gamma)
+{
+	bool isNew = false;
+	const unsigned int textureID = Reserve(path, gamma, isNew);
+	if (!isNew)
+		return textureID;
+
+	CPU_PROFILE_SCOPE("TextureCache::Acquire");
+
+	DecodedTexture texture;
+	if (LoadTextureFile(path, texture, false, gamma))
+		Upload(textureID, texture);
+	else
+		std::cout << "Texture failed to load at path: " << path << std::endl;
+
+	return textureID;
+}
+
+unsigned int TextureCache::Reserve(const std::string& path, bool gamma, bool& isNew)
+{
+	Key key{ CanonicalPath(path), gamma };
+
+	const auto found = textureIDs.find(key);
+	if (found != textureIDs.end())
+	{
+		hits++;
+		isNew = false;
+		AddReference(entries.at(found->second));
+		return found->second;
+	}
+
+	misses++;
+	isNew = true;
+
+	unsigned int textureID = 0;
+	glGenTextures(1, &textureID);
+
+	Entry& entry = entries[textureID];
+	entry.key = key;
+	entry.references = 1;
+	textureIDs.emplace(std::move(key), textureID);
+
+	return textureID;
+}
+
+void TextureCache::Upload(unsigned int textureID, const DecodedTexture& texture)
+{
+	const auto found = entries.find(textureID);
+	if (found == entries.end())
+		return;
+
+	Entry& entry = found->second;
+	if (arrayPacking && !entry.layer.IsValid())
+		entry.layer = TextureArrays::Default().Add(textureID, texture, entry.key.gamma);
+	if (!entry.layer.IsValid())
+		UploadTexture(textureID, texture, entry.key.gamma);
+
+	// levels generated by the driver add a third of the base level, baked textures bring their whole chain
+	std::size_t bytes = 0;
+	for (const auto& level : texture.levels)
+		bytes += level.size();
+	if (texture.levels.size() == 1 && !texture.compressed)
+		bytes += bytes / 3;
+
+	if (texture.compressed != entry.compressed)
+		compressedTextures = texture.compressed ? compressedTextures + 1 : compressedTextures - 1;
+	entry.compressed = texture.compressed;
+
+	residentBytes = residentBytes - entry.bytes + bytes;
+	if (entry.references == 0)
+		unusedBytes = unusedBytes - entry.bytes + bytes;
+	entry.bytes = bytes;
+}
+
+TextureLayer TextureCache::GetLayer(unsigned int textureID) const
+{
+	const auto found = entries.find(textureID);
+	return found != entries.end() ? found->second.layer : TextureLayer();
+}
+
+void TextureCache::SetArrayPacking(bool enabled)
+{
+	arrayPacking = enabled;
+}
+
+bool TextureCache::IsArrayPacking() const
+{
+	return arrayPacking;
+}
+
+bool TextureCache::IsUploaded(unsigned int textureID) const
+{
+	const auto found = entries.find(textureID);
+	return found != entries.end() && found->second.bytes > 0;
+}
+
+void TextureCache::Release(unsigned int textureID)
+{
+	const auto found = entries.find(textureID);
+	if (found == entries.end() || found->second.references == 0)
+		return;
+
+	Entry& entry = found->second;
+	if (--entry.references > 0)
+		return;
+
+	entry.unusedPosition = unusedTextures.insert(unusedTextures.end(), textureID);
+	unusedBytes += entry.bytes;
+	Evict(unusedBudget);
+}
+
+void TextureCache::SetUnusedBudget(std::size_t bytes)
+{
+	unusedBudget = bytes;
+	Evict(unusedBudget);
+}
+
+std::size_t TextureCache::GetUnusedBudget() const
+{
+	return unusedBudget;
+}
+
+void TextureCache::Trim()
+{
+	Evict(0);
+}
+
+std::size_t TextureCache::GetTextureCount() const
+{
+	return entries.size();
+}
+
+std::size_t TextureCache::GetResidentBytes() const
+{
+	return residentBytes;
+}
+
+std::size_t TextureCache::GetUnusedBytes() const
+{
+	return unusedBytes;
+}
+
+std::size_t TextureCache::GetCompressedCount() const
+{
+	return compressedTextures;
+}
+
+std::size_t TextureCache::GetHitCount() const
+{
+	return hits;
+}
+
+std::size_t TextureCache::GetMissCount() const
+{
+	return misses;
+}
+
+void TextureCache::AddReference(Entry& entry)
+{
+	if (entry.references++ > 0)
+		return;
+
+	unusedTextures.erase(entry.unusedPosition);
+	unusedBytes -= entry.bytes;
+}
+
+void TextureCache::Evict(std::size_t budget)
+{
+	// with no budget even textures that never got their data go, they weigh nothing but still hold a name
+	while (!unusedTextures.empty() && (unusedBytes > budget || budget == 0))
+	{
+		const unsigned int textureID = unusedTextures.front();
+		unusedTextures.pop_front();
+		Delete(textureID);
+	}
+}
+
+void TextureCache::Delete(unsigned int textureID)
+{
+	const auto found = entries.find(textureID);
+	if (found == entries.end())
+		return;
+
+	residentBytes -= found->second.bytes;
+	unusedBytes -= found->second.bytes;
+	if (found->second.compressed)
+		compressedTextures--;
+	if (found->second.layer.IsValid())
+		TextureArrays::Default().Remove(found->second.layer);
+	textureIDs.erase(found->second.key);
+	entries.erase(found);
+
+	// a resident handle has to go before its texture
+	BindlessTextures::Default().Forget(textureID);
+	GLStateCache::Default().DeleteTextures(1, &textureID);
+}
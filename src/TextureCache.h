@@ -0,0 +1,116 @@
+#pragma once
+#ifndef TEXTURE_CACHE_H
+#define TEXTURE_CACHE_H
+
+#include <cstddef>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+#include "TextureArrays.h"
+
+struct DecodedTexture;
+
+// Process-wide cache of GL textures, keyed by the canonical path of the image and whether it is sRGB.
+// Every Acquire or Reserve takes a reference and every reference is given back with Release.
+// Textures nobody references stay resident in least recently released order until they exceed the unused budget,
+// so a model loaded again shortly after being freed does not decode its textures twice.
+// Only used from the GL thread.
+class TextureCache
+{
+public:
+	// cache shared by all models
+	static TextureCache& Default();
+
+	TextureCache() = default;
+	// GL names are left to the context, which may already be gone when the default cache is destroyed
+	~TextureCache() = default;
+
+	TextureCache(const TextureCache&) = delete;
+	TextureCache& operator=(const TextureCache&) = delete;
+
+	// the texture of the image at path, decoded and uploaded on a miss.
+	// an image that fails to decode still gets a name, which samples black
+	unsigned int Acquire(const std::string& path, bool gamma = false);
+
+	// like Acquire, but a miss only reserves the name: isNew asks the caller to decode the image and pass it to Upload
+	unsigned int Reserve(const std::string& path, bool gamma, bool& isNew);
+
+	// fills a texture returned by Reserve
+	void Upload(unsigned int textureID, const DecodedTexture& texture);
+
+	// the layer of a texture Upload packed into TextureArrays, invalid for the ones uploaded on their own or not yet uploaded
+	TextureLayer GetLayer(unsigned int textureID) const;
+
+	// textures uploaded afterwards are packed into TextureArrays where they fit, on by default.
+	// the texture name stays the one to bind either way, it becomes a view of the layer
+	void SetArrayPacking(bool enabled);
+	bool IsArrayPacking() const;
+
+	// false while a reserved texture waits for Upload, for images that failed to decode and for names the cache doesn't know
+	bool IsUploaded(unsigned int textureID) const;
+
+	// gives back one reference, the texture becomes unused when it was the last one
+	void Release(unsigned int textureID);
+
+	// bytes of unused textures kept resident before the least recently released are deleted
+	void SetUnusedBudget(std::size_t bytes);
+	std::size_t GetUnusedBudget() const;
+
+	// deletes every unused texture
+	void Trim();
+
+	std::size_t GetTextureCount() const;
+	// estimated from the uploaded levels
+	std::size_t GetResidentBytes() const;
+	std::size_t GetUnusedBytes() const;
+	// textures uploaded from a bake of texbake
+	std::size_t GetCompressedCount() const;
+	std::size_t GetHitCount() const;
+	std::size_t GetMissCount() const;
+
+private:
+	struct Key
+	{
+		std::string path;
+		bool gamma;
+
+		bool operator==(const Key& other) const;
+	};
+
+	struct KeyHash
+	{
+		std::size_t operator()(const Key& key) const;
+	};
+
+	struct Entry
+	{
+		Key key;
+		unsigned int references = 0;
+		std::size_t bytes = 0;
+		bool compressed = false;
+		TextureLayer layer;
+		// position in unusedTextures while nobody references the texture
+		std::list<unsigned int>::iterator unusedPosition;
+	};
+
+	// takes a reference, reviving the texture if it was unused
+	void AddReference(Entry& entry);
+	void Evict(std::size_t budget);
+	void Delete(unsigned int textureID);
+
+	std::unordered_map<Key, unsigned int, KeyHash> textureIDs;
+	std::unordered_map<unsigned int, Entry> entries;
+	// least recently released first
+	std::list<unsigned int> unusedTextures;
+
+	bool arrayPacking = true;
+	std::size_t unusedBudget = 64 * 1024 * 1024;
+	std::size_t residentBytes = 0;
+	std::size_t unusedBytes = 0;
+	std::size_t compressedTextures = 0;
+	std::size_t hits = 0;
+	std::size_t misses = 0;
+};
+
+#endif
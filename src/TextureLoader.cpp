@@ -0,0 +1,257 @@
+#include "TextureLoader.h"
+
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include "KtxFile.h"
+#include "MeshCache.h"
+
+#include <glad/glad.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+
+// from EXT_texture_compression_s3tc and EXT_texture_sRGB, which glad was generated without
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+#ifndef GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT 0x8C4F
+#endif
+
+namespace
+{
+	// averages 2x2 blocks, the last row or column is repeated on odd sizes
+	std::vector<unsigned char> Downsample(const std::vector<unsigned char>& source, int width, int height, int components)
+	{
+		const int nextWidth = std::max(width / 2, 1);
+		const int nextHeight = std::max(height / 2, 1);
+		std::vector<unsigned char> level(static_cast<std::size_t>(nextWidth) * nextHeight * components);
+
+		for (int y = 0; y < nextHeight; y++)
+		{
+			const int y0 = std::min(2 * y, height - 1);
+			const int y1 = std::min(2 * y + 1, height - 1);
+			for (int x = 0; x < nextWidth; x++)
+			{
+				const int x0 = std::min(2 * x, width - 1);
+				const int x1 = std::min(2 * x + 1, width - 1);
+				for (int c = 0; c < components; c++)
+				{
+					const int sum = source[(y0 * width + x0) * components + c] + source[(y0 * width + x1) * components + c] +
+						source[(y1 * width + x0) * components + c] + source[(y1 * width + x1) * components + c];
+					level[(y * nextWidth + x) * components + c] = static_cast<unsigned char>((sum + 2) / 4);
+				}
+			}
+		}
+
+		return level;
+	}
+
+	GLenum FormatFromComponents(int components)
+	{
+		switch (components)
+		{
+		case 1:
+			return GL_RED;
+		case 2:
+			return GL_RG;
+		case 3:
+			return GL_RGB;
+		default:
+			return GL_RGBA;
+		}
+	}
+
+	// RGTC has no sRGB variant, normal maps never need one
+	GLenum CompressedFormat(BlockFormat format, bool gamma)
+	{
+		switch (format)
+		{
+		case BlockFormat::BC1:
+			return gamma ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case BlockFormat::BC3:
+			return gamma ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+		default:
+			return GL_COMPRESSED_RG_RGTC2;
+		}
+	}
+}
+
+bool DecodeTextureFile(const std::string& filename, DecodedTexture& texture, bool generateMipmaps)
+{
+	int width, height, nrComponents;
+	unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
+	if (!data)
+		return false;
+
+	texture.width = width;
+	texture.height = height;
+	texture.components = nrComponents;
+	texture.levels.clear();
+	texture.levels.emplace_back(data, data + static_cast<std::size_t>(width) * height * nrComponents);
+	stbi_image_free(data);
+
+	if (generateMipmaps)
+	{
+		while (width > 1 || height > 1)
+		{
+			texture.levels.emplace_back(Downsample(texture.levels.back(), width, height, nrComponents));
+			width = std::max(width / 2, 1);
+			height = std::max(height / 2, 1);
+		}
+	}
+
+	return true;
+}
+
+bool LoadBakedTexture(const std::string& filename, DecodedTexture& texture, bool gamma)
+{
+	KtxTexture baked;
+	if (!ReadKtxFile(GetBakedTexturePath(filename), baked) || !IsBlockFormatSupported(baked.format, gamma))
+		return false;
+
+	std::uint64_t sourceHash = 0;
+	if (HashFile(filename, sourceHash) && sourceHash != baked.sourceHash)
+		return false;
+
+	texture.width = baked.width;
+	texture.height = baked.height;
+	texture.components = baked.format == BlockFormat::BC5 ? 2 : baked.format == BlockFormat::BC3 ? 4 : 3;
+	texture.levels = std::move(baked.levels);
+	texture.compressed = true;
+	texture.blockFormat = baked.format;
+	return true;
+}
+
+bool LoadTextureFile(const std::string& filename, DecodedTexture& texture, bool generateMipmaps, bool gamma)
+{
+	return LoadBakedTexture(filename, texture, gamma) || DecodeTextureFile(filename, texture, generateMipmaps);
+}
+
+bool IsBlockFormatSupported(BlockFormat format, bool gamma)
+{
+	if (format == BlockFormat::BC5)
+		return true;
+	return HasGLExtension("GL_EXT_texture_compression_s3tc") && (!gamma || HasGLExtension("GL_EXT_texture_sRGB"));
+}
+
+void UploadTexture(unsigned int textureID, const DecodedTexture& texture, bool gamma)
+{
+	if (texture.compressed)
+	{
+		GLStateCache::Default().BindTexture(GL_TEXTURE_2D, textureID);
+
+		const GLenum internalFormat = CompressedFormat(texture.blockFormat, gamma);
+		int width = texture.width;
+		int height = texture.height;
+		for (std::size_t level = 0; level < texture.levels.size(); level++)
+		{
+			glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), internalFormat, width, height, 0,
+				static_cast<GLsizei>(texture.levels[level].size()), texture.levels[level].data());
+			width = std::max(width / 2, 1);
+			height = std::max(height / 2, 1);
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(texture.levels.size()) - 1);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		return;
+	}
+
+	const GLenum format = FormatFromComponents(texture.components);
+	GLenum internalFormat = format;
+	if (gamma && texture.components == 3)
+		internalFormat = GL_SRGB8;
+	else if (gamma && texture.components == 4)
+		internalFormat = GL_SRGB8_ALPHA8;
+
+	GLStateCache::Default().BindTexture(GL_TEXTURE_2D, textureID);
+	// rows of 1 and 3 component images are not 4 byte aligned
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	int width = texture.width;
+	int height = texture.height;
+	for (std::size_t level = 0; level < texture.levels.size(); level++)
+	{
+		glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, texture.levels[level].data());
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+
+	if (texture.levels.size() == 1)
+		glGenerateMipmap(GL_TEXTURE_2D);
+	else
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(texture.levels.size()) - 1);
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+}
+
+unsigned int GetLayerFormat(const DecodedTexture& texture, bool gamma)
+{
+	if (texture.compressed)
+		return CompressedFormat(texture.blockFormat, gamma);
+
+	switch (texture.components)
+	{
+	case 1:
+		return GL_R8;
+	case 2:
+		return GL_RG8;
+	default:
+		return gamma ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+	}
+}
+
+int GetMipLevelCount(int width, int height)
+{
+	int levels = 1;
+	for (int size = std::max(width, height); size > 1; size /= 2)
+		levels++;
+	return levels;
+}
+
+void UploadTextureLayer(unsigned int arrayID, int layer, const DecodedTexture& texture, bool gamma)
+{
+	GLStateCache::Default().BindTexture(GL_TEXTURE_2D_ARRAY, arrayID);
+
+	const GLenum internalFormat = GetLayerFormat(texture, gamma);
+	const GLenum format = FormatFromComponents(texture.components);
+	// rows of 1 and 3 component images are not 4 byte aligned
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	int width = texture.width;
+	int height = texture.height;
+	for (std::size_t level = 0; level < texture.levels.size(); level++)
+	{
+		if (texture.compressed)
+		{
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(level), 0, 0, layer, width, height, 1,
+				internalFormat, static_cast<GLsizei>(texture.levels[level].size()), texture.levels[level].data());
+		}
+		else
+		{
+			// 3 component rows are widened to the array's RGBA by GL, with an alpha of 1
+			glTexSubImage3D(GL_TEXTURE_2D_ARRAY, static_cast<GLint>(level), 0, 0, layer, width, height, 1,
+				format, GL_UNSIGNED_BYTE, texture.levels[level].data());
+		}
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <string>
+#include <vector>
+
+#include "BlockCompression.h"
+
+// an image decoded on the CPU, ready to be uploaded
+struct DecodedTexture
+{
+	int width = 0;
+	int height = 0;
+	int components = 0;
+	// level 0 first, either the full mip chain or the base level only
+	std::vector<std::vector<unsigned char>> levels;
+	// set when the levels hold the blocks of a baked texture instead of pixels, the chain is then always complete
+	bool compressed = false;
+	BlockFormat blockFormat = BlockFormat::BC1;
+};
+
+// decodes the image file, optionally followed by a box filtered mip chain down to 1x1.
+// touches no GL state, so it can run on any thread. false when the file can't be decoded
+bool DecodeTextureFile(const std::string& filename, DecodedTexture& texture, bool generateMipmaps);
+
+// the texture baked by texbake next to the image, when it is still current and the context can sample its format.
+// a bake whose image is gone is used as is
+bool LoadBakedTexture(const std::string& filename, DecodedTexture& texture, bool gamma);
+
+// LoadBakedTexture, falling back to DecodeTextureFile
+bool LoadTextureFile(const std::string& filename, DecodedTexture& texture, bool generateMipmaps, bool gamma);
+
+// whether uploads of the format work in the current context, the sRGB variants of BC1 and BC3 with gamma.
+// needs InitGLExtensions, afterwards it can be asked from any thread
+bool IsBlockFormatSupported(BlockFormat format, bool gamma);
+
+// fills the GL texture with the decoded levels and sets the usual sampling parameters,
+// the remaining mip levels are generated by the driver when only the base level was decoded.
+// gamma stores 3 and 4 component images as sRGB
+void UploadTexture(unsigned int textureID, const DecodedTexture& texture, bool gamma = false);
+
+// sized internal format a texture is stored with in a GL_TEXTURE_2D_ARRAY. 3 and 4 component images share GL_RGBA8,
+// which is how drivers store RGB8 anyway
+unsigned int GetLayerFormat(const DecodedTexture& texture, bool gamma);
+
+// levels of the complete mip chain of a texture of the size
+int GetMipLevelCount(int width, int height);
+
+// fills one layer of a GL_TEXTURE_2D_ARRAY allocated with GetLayerFormat and the texture's size, level by level.
+// generates no mip levels, a base level only texture leaves that to the caller
+void UploadTextureLayer(unsigned int arrayID, int layer, const DecodedTexture& texture, bool gamma = false);
+
+#endif
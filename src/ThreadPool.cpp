@@ -0,0 +1,109 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+{
+	const unsigned int workerCount = threadCount > 1 ? threadCount - 1 : 0;
+
+	workers.reserve(workerCount);
+	for (unsigned int i = 0; i < workerCount; i++)
+		workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wakeWorkers.notify_all();
+
+	for (auto& worker : workers)
+		worker.join();
+}
+
+unsigned int ThreadPool::GetThreadCount() const
+{
+	return static_cast<unsigned int>(workers.size()) + 1;
+}
+
+void ThreadPool::ParallelFor(std::size_t count, std::size_t minChunk, const std::function<void(std::size_t, std::size_t)>& task)
+{
+	if (count == 0)
+		return;
+
+	// a few chunks per thread keeps the load balanced when some ranges are cheaper than others
+	const std::size_t threadCount = GetThreadCount();
+	const std::size_t chunkSize = std::max<std::size_t>(std::max<std::size_t>(minChunk, 1), (count + threadCount * 4 - 1) / (threadCount * 4));
+
+	if (workers.empty() || count <= chunkSize)
+	{
+		task(0, count);
+		return;
+	}
+
+	auto job = std::make_shared<Job>();
+	job->task = &task;
+	job->count = count;
+	job->chunkSize = chunkSize;
+	job->chunkCount = (count + chunkSize - 1) / chunkSize;
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		currentJob = job;
+		jobGeneration++;
+	}
+	wakeWorkers.notify_all();
+
+	RunChunks(*job);
+
+	std::unique_lock<std::mutex> lock(mutex);
+	jobFinished.wait(lock, [&job] { return job->finishedChunks.load() == job->chunkCount; });
+	currentJob.reset();
+}
+
+void ThreadPool::WorkerLoop()
+{
+	unsigned long long seenGeneration = 0;
+
+	while (true)
+	{
+		std::shared_ptr<Job> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wakeWorkers.wait(lock, [&] { return stopping || (currentJob && jobGeneration != seenGeneration); });
+
+			if (stopping)
+				return;
+
+			seenGeneration = jobGeneration;
+			job = currentJob;
+		}
+
+		if (RunChunks(*job))
+		{
+			// taking the lock makes sure the caller is either not waiting yet or already notified
+			std::lock_guard<std::mutex> lock(mutex);
+			jobFinished.notify_all();
+		}
+	}
+}
+
+bool ThreadPool::RunChunks(Job& job)
+{
+	bool finishedLast = false;
+
+	for (std::size_t chunk = job.nextChunk++; chunk < job.chunkCount; chunk = job.nextChunk++)
+	{
+		const std::size_t begin = chunk * job.chunkSize;
+		const std::size_t end = std::min(begin + job.chunkSize, job.count);
+
+		(*job.task)(begin, end);
+
+		if (job.finishedChunks.fetch_add(1) + 1 == job.chunkCount)
+			finishedLast = true;
+	}
+
+	return finishedLast;
+}
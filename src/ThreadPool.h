@@ -0,0 +1,57 @@
+#pragma once
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads used to split data parallel work into chunks.
+// The calling thread takes part in the work, so a pool of N threads runs N-1 workers.
+class ThreadPool
+{
+public:
+	explicit ThreadPool(unsigned int threadCount);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// total number of threads working on a ParallelFor, including the caller
+	unsigned int GetThreadCount() const;
+
+	// calls task(begin, end) for consecutive ranges covering [0, count) and blocks until all of them finished.
+	// ranges are never smaller than minChunk (except the last one), small inputs run inline on the caller.
+	void ParallelFor(std::size_t count, std::size_t minChunk, const std::function<void(std::size_t, std::size_t)>& task);
+
+private:
+	struct Job
+	{
+		const std::function<void(std::size_t, std::size_t)>* task = nullptr;
+		std::size_t count = 0;
+		std::size_t chunkSize = 0;
+		std::size_t chunkCount = 0;
+		std::atomic<std::size_t> nextChunk{ 0 };
+		std::atomic<std::size_t> finishedChunks{ 0 };
+	};
+
+	void WorkerLoop();
+	// processes chunks of the job until none are left, returns true if this call finished the last chunk
+	static bool RunChunks(Job& job);
+
+	std::vector<std::thread> workers;
+
+	std::mutex mutex;
+	std::condition_variable wakeWorkers;
+	std::condition_variable jobFinished;
+	std::shared_ptr<Job> currentJob;
+	unsigned long long jobGeneration = 0;
+	bool stopping = false;
+};
+
+#endif
@@ -1,149 +1,170 @@
 #include "Transform.h"
 
-#include "glm/trigonometric.hpp"
-#include "glm/ext/matrix_transform.hpp"
+#include "CpuProfiler.h"
 
-#define GLM_ENABLE_EXPERIMENTAL
-#include "glm/gtx/matrix_decompose.hpp"
+#include <utility>
 
-Transform::Transform() = default;
+Transform::Transform() : Transform(TransformStore::Default())
+{
+}
 
-Transform::Transform(const glm::mat4 & model) : modelMatrix(model)
+Transform::Transform(TransformStore& owningStore) : store(&owningStore), handle(owningStore.Create())
 {
-	glm::quat rot;
-	glm::vec4 perspective;
-	glm::vec3 skew;
-	glm::decompose(model, scale, rot, pos, skew, perspective);
-	eulerRot = glm::eulerAngles(rot);
+}
 
+Transform::Transform(const glm::mat4 & model) : Transform()
+{
+	store->SetModelMatrix(handle, model);
 }
 
-void Transform::Update(bool parentDirty)
+Transform::Transform(const Transform & other) : Transform(*other.store)
 {
-	parentDirty |= dirty;
-	if (parentDirty)
-	{
-		ComputeModelMatrix();
-	}
+	*this = other;
+}
 
-	for (const auto& child : children)
-	{
-		child->Update(parentDirty);
-	}
+Transform::Transform(Transform && other) noexcept : store(other.store), handle(other.handle)
+{
+	other.handle = TransformStore::InvalidHandle;
+}
 
+Transform::~Transform()
+{
+	if (handle != TransformStore::InvalidHandle)
+		store->Destroy(handle);
 }
 
-void Transform::ComputeModelMatrix()
+Transform& Transform::operator=(const Transform & other)
 {
-	const glm::mat4 transformX = glm::rotate(glm::mat4(1.0f),
-		glm::radians(eulerRot.x),
-		glm::vec3(1.0f, 0.0f, 0.0f));
-	const glm::mat4 transformY = glm::rotate(glm::mat4(1.0f),
-		glm::radians(eulerRot.y),
-		glm::vec3(0.0f, 1.0f, 0.0f));
-	const glm::mat4 transformZ = glm::rotate(glm::mat4(1.0f),
-		glm::radians(eulerRot.z),
-		glm::vec3(0.0f, 0.0f, 1.0f));
+	if (this == &other)
+		return *this;
 
-	const glm::mat4 rotationMatrix = transformY * transformX * transformZ;
+	store->SetLocalPosition(handle, other.GetLocalPosition());
+	store->SetLocalRotation(handle, other.GetLocalRotation());
+	store->SetLocalScale(handle, other.GetLocalScale());
 
-	modelMatrix = glm::translate(glm::mat4(1.0f), pos) * rotationMatrix * glm::scale(glm::mat4(1.0f), scale);
+	if (store == other.store)
+		store->SetParent(handle, store->GetParent(other.handle));
 
-	if(parent != nullptr)
-		modelMatrix = parent->GetModelMatrix() * modelMatrix;
+	return *this;
+}
 
-	dirty = false;
+Transform& Transform::operator=(Transform && other) noexcept
+{
+	std::swap(store, other.store);
+	std::swap(handle, other.handle);
+	return *this;
 }
 
-void Transform::ComputeModelMatrix(const glm::mat4 & parentGlobalMatrix)
+void Transform::Update(bool parentDirty)
+{
+	CPU_PROFILE_SCOPE("Transform::Update");
+
+	if (parentDirty)
+		store->MarkDirty(handle);
+
+	store->Update();
+}
+
+void Transform::ComputeModelMatrix()
 {
-	ComputeModelMatrix();
+	store->ComputeNode(handle);
+}
 
-	modelMatrix = parentGlobalMatrix * modelMatrix;
+void Transform::ComputeModelMatrix(const glm::mat4 & parentGlobalMatrix)
+{
+	store->ComputeNode(handle, parentGlobalMatrix);
 }
 
 void Transform::SetParent(Transform * parent)
 {
-	this->parent = parent;
 	parent->AddChild(this);
 }
 
 void Transform::AddChild(Transform * child)
 {
-	children.emplace_back(child);
+	// nodes can only be linked within one store
+	if (child->store == store)
+		store->SetParent(child->handle, handle);
 }
 
 void Transform::SetLocalRotation(const glm::vec3 & newRotation)
 {
-	eulerRot = newRotation;
-	dirty = true;
+	store->SetLocalRotation(handle, newRotation);
 }
 
 void Transform::SetLocalPosition(const glm::vec3 & newPosition)
 {
-	pos = newPosition;
-	dirty = true;
+	store->SetLocalPosition(handle, newPosition);
 }
 
 void Transform::SetLocalRotationX(const float newX)
 {
-	eulerRot.x = newX;
-	dirty = true;
+	glm::vec3 rotation = GetLocalRotation();
+	rotation.x = newX;
+	store->SetLocalRotation(handle, rotation);
 }
 
 void Transform::SetLocalRotationY(const float newY)
 {
-	eulerRot.y = newY;
-	dirty = true;
+	glm::vec3 rotation = GetLocalRotation();
+	rotation.y = newY;
+	store->SetLocalRotation(handle, rotation);
 }
 
 void Transform::SetLocalRotationZ(const float newZ)
 {
-	eulerRot.z = newZ;
-	dirty = true;
+	glm::vec3 rotation = GetLocalRotation();
+	rotation.z = newZ;
+	store->SetLocalRotation(handle, rotation);
 }
 
 void Transform::SetModelMatrix(const glm::mat4 & newModel)
 {
-	modelMatrix = newModel;
-	glm::quat rot;
-	glm::vec4 perspective;
-	glm::vec3 skew;
-
-	glm::decompose(modelMatrix, scale, rot, pos, skew, perspective);
-	eulerRot = glm::eulerAngles(rot);
-	dirty = true;
+	store->SetModelMatrix(handle, newModel);
 }
 
 void Transform::SetLocalScale(const glm::vec3 & newScale)
 {
-	scale = newScale;
-	dirty = true;
+	store->SetLocalScale(handle, newScale);
 }
 
 
 const glm::vec3& Transform::GetLocalPosition() const
 {
-	return pos;
+	return store->GetLocalPosition(handle);
 }
 
 const glm::vec3& Transform::GetLocalRotation() const
 {
-	return eulerRot;
+	return store->GetLocalRotation(handle);
 }
 
 const glm::vec3& Transform::GetLocalScale() const
 {
-	return scale;
+	return store->GetLocalScale(handle);
 }
 
 const glm::mat4& Transform::GetModelMatrix() const
 {
-	return modelMatrix;
+	return store->GetModelMatrix(handle);
+}
+
+unsigned int Transform::GetModelVersion() const
+{
+	return store->GetModelVersion(handle);
 }
 
 bool Transform::isDirty() const
 {
-	return dirty;
+	return store->IsDirty(handle);
+}
+
+unsigned int Transform::GetHandle() const
+{
+	return handle;
 }
 
+TransformStore& Transform::GetStore() const
+{
+	return *store;
+}
@@ -2,15 +2,26 @@
 #ifndef TRANSFORM_H
 #define TRANSFORM_H
 
-#include <vector>
 #include <glm/glm.hpp>
 
+#include "TransformStore.h"
+
+// Lightweight handle to a node living in a TransformStore.
+// Owns its node: the node is created with the handle and released when the handle is destroyed.
 class Transform
 {
 public:
 	Transform();
+	explicit Transform(TransformStore& owningStore);
 	Transform(const glm::mat4& model);
+	Transform(const Transform& other);
+	Transform(Transform&& other) noexcept;
+	~Transform();
+
+	Transform& operator=(const Transform& other);
+	Transform& operator=(Transform&& other) noexcept;
 
+	// propagates pending changes of the whole store the node lives in
 	void Update(bool parentDirty = false);
 	void ComputeModelMatrix();
 	void ComputeModelMatrix(const glm::mat4& parentGlobalMatrix);
@@ -28,23 +39,20 @@ public:
 	const glm::vec3& GetLocalPosition() const;
 	const glm::vec3& GetLocalRotation() const;
 	const glm::vec3& GetLocalScale() const;
+	// references returned by the getters stay valid only until the store is modified
 	const glm::mat4& GetModelMatrix() const;
+	// changes whenever the model matrix gets recomputed, lets users detect which nodes moved since they last looked
+	unsigned int GetModelVersion() const;
 
 	bool isDirty() const;
 
-private:
+	unsigned int GetHandle() const;
+	TransformStore& GetStore() const;
 
-	unsigned instanceVBO = 0;
-
-	glm::vec3 pos = { 0,0,0 };
-	glm::vec3 eulerRot = { 0,0,0 };
-	glm::vec3 scale = { 1.0f, 1.0f, 1.0f };
-	glm::mat4 modelMatrix = glm::mat4(1.0f);
+private:
 
-	//scene graph
-	bool dirty = true;
-	Transform* parent = nullptr;
-	std::vector<Transform*> children;
+	TransformStore* store = nullptr;
+	unsigned int handle = TransformStore::InvalidHandle;
 };
 
 #endif
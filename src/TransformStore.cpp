@@ -0,0 +1,495 @@
+#include "TransformStore.h"
+
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+#include "glm/trigonometric.hpp"
+#include "glm/ext/matrix_transform.hpp"
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include "glm/gtx/matrix_decompose.hpp"
+
+namespace
+{
+	// reorders data so that data[newSlot] = data[order[newSlot]]
+	template <typename T>
+	void Permute(std::vector<T>& data, const std::vector<unsigned int>& order)
+	{
+		std::vector<T> sorted;
+		sorted.reserve(order.size());
+		for (const auto oldSlot : order)
+			sorted.emplace_back(data[oldSlot]);
+		data.swap(sorted);
+	}
+}
+
+TransformStore& TransformStore::Default()
+{
+	static TransformStore store;
+	return store;
+}
+
+TransformStore::TransformStore() = default;
+
+TransformStore::~TransformStore() = default;
+
+void TransformStore::Reserve(std::size_t count)
+{
+	positions.reserve(count);
+	rotations.reserve(count);
+	scales.reserve(count);
+	localMatrices.reserve(count);
+	worldMatrices.reserve(count);
+	parents.reserve(count);
+	dirty.reserve(count);
+	versions.reserve(count);
+	slotHandles.reserve(count);
+	changeGroups.reserve(count);
+	handleSlots.reserve(count);
+}
+
+unsigned int TransformStore::Create()
+{
+	unsigned int handle;
+	if (!freeHandles.empty())
+	{
+		handle = freeHandles.back();
+		freeHandles.pop_back();
+	}
+	else
+	{
+		handle = static_cast<unsigned int>(handleSlots.size());
+		handleSlots.emplace_back(InvalidHandle);
+	}
+
+	const auto slot = static_cast<unsigned int>(parents.size());
+
+	positions.emplace_back(0.0f);
+	rotations.emplace_back(0.0f);
+	scales.emplace_back(1.0f);
+	localMatrices.emplace_back(1.0f);
+	worldMatrices.emplace_back(1.0f);
+	parents.emplace_back(NoParent);
+	dirty.emplace_back(1);
+	versions.emplace_back(0);
+	slotHandles.emplace_back(handle);
+	changeGroups.emplace_back(NoChangeGroup);
+
+	handleSlots[handle] = slot;
+	anyDirty = true;
+	levelsValid = false;
+	changeCount++;
+
+	return handle;
+}
+
+void TransformStore::Destroy(unsigned int handle)
+{
+	const unsigned int slot = handleSlots[handle];
+
+	// the slot stays in place until the next sort, children of a destroyed node become roots then
+	slotHandles[slot] = InvalidHandle;
+	handleSlots[handle] = InvalidHandle;
+	freeHandles.emplace_back(handle);
+
+	deadSlots++;
+	needsSort = true;
+}
+
+void TransformStore::SetParent(unsigned int handle, unsigned int parentHandle)
+{
+	const unsigned int slot = handleSlots[handle];
+
+	if (parentHandle == InvalidHandle)
+	{
+		parents[slot] = NoParent;
+		MarkDirty(handle);
+		levelsValid = false;
+		return;
+	}
+
+	const unsigned int parentSlot = handleSlots[parentHandle];
+
+	// refuse to create a cycle
+	if (parentSlot == slot || IsAncestor(slot, parentSlot))
+		return;
+
+	parents[slot] = parentSlot;
+	MarkDirty(handle);
+	levelsValid = false;
+
+	if (parentSlot > slot)
+		needsSort = true;
+}
+
+unsigned int TransformStore::GetParent(unsigned int handle) const
+{
+	const unsigned int parentSlot = parents[handleSlots[handle]];
+
+	if (parentSlot == NoParent)
+		return InvalidHandle;
+
+	return slotHandles[parentSlot];
+}
+
+void TransformStore::SetLocalPosition(unsigned int handle, const glm::vec3& newPosition)
+{
+	positions[handleSlots[handle]] = newPosition;
+	MarkDirty(handle);
+}
+
+void TransformStore::SetLocalRotation(unsigned int handle, const glm::vec3& newRotation)
+{
+	rotations[handleSlots[handle]] = newRotation;
+	MarkDirty(handle);
+}
+
+void TransformStore::SetLocalScale(unsigned int handle, const glm::vec3& newScale)
+{
+	scales[handleSlots[handle]] = newScale;
+	MarkDirty(handle);
+}
+
+void TransformStore::SetModelMatrix(unsigned int handle, const glm::mat4& newModel)
+{
+	const unsigned int slot = handleSlots[handle];
+
+	worldMatrices[slot] = newModel;
+	versions[slot]++;
+	changeCount++;
+	CountGroupChange(slot);
+	glm::quat rot;
+	glm::vec4 perspective;
+	glm::vec3 skew;
+
+	glm::decompose(newModel, scales[slot], rot, positions[slot], skew, perspective);
+	rotations[slot] = glm::eulerAngles(rot);
+	MarkDirty(handle);
+}
+
+const glm::vec3& TransformStore::GetLocalPosition(unsigned int handle) const
+{
+	return positions[handleSlots[handle]];
+}
+
+const glm::vec3& TransformStore::GetLocalRotation(unsigned int handle) const
+{
+	return rotations[handleSlots[handle]];
+}
+
+const glm::vec3& TransformStore::GetLocalScale(unsigned int handle) const
+{
+	return scales[handleSlots[handle]];
+}
+
+const glm::mat4& TransformStore::GetLocalMatrix(unsigned int handle) const
+{
+	return localMatrices[handleSlots[handle]];
+}
+
+const glm::mat4& TransformStore::GetModelMatrix(unsigned int handle) const
+{
+	return worldMatrices[handleSlots[handle]];
+}
+
+unsigned int TransformStore::GetModelVersion(unsigned int handle) const
+{
+	return versions[handleSlots[handle]];
+}
+
+std::size_t TransformStore::GetChangeCount() const
+{
+	return changeCount;
+}
+
+unsigned int TransformStore::CreateChangeGroup()
+{
+	groupChangeCounts.emplace_back(0);
+	return static_cast<unsigned int>(groupChangeCounts.size());
+}
+
+bool TransformStore::SetChangeGroup(unsigned int handle, unsigned int group)
+{
+	const unsigned int slot = handleSlots[handle];
+
+	if (changeGroups[slot] != NoChangeGroup && changeGroups[slot] != group)
+		return false;
+
+	changeGroups[slot] = group;
+	CountGroupChange(slot);
+	return true;
+}
+
+std::size_t TransformStore::GetGroupChangeCount(unsigned int group) const
+{
+	return groupChangeCounts[group - 1].load(std::memory_order_relaxed);
+}
+
+void TransformStore::MarkDirty(unsigned int handle)
+{
+	dirty[handleSlots[handle]] = 1;
+	anyDirty = true;
+}
+
+bool TransformStore::IsDirty(unsigned int handle) const
+{
+	return dirty[handleSlots[handle]] != 0;
+}
+
+void TransformStore::ComputeNode(unsigned int handle)
+{
+	const unsigned int slot = handleSlots[handle];
+
+	ComputeSlot(slot);
+	dirty[slot] = 0;
+	changeCount++;
+	CountGroupChange(slot);
+}
+
+void TransformStore::ComputeNode(unsigned int handle, const glm::mat4& parentGlobalMatrix)
+{
+	ComputeNode(handle);
+
+	const unsigned int slot = handleSlots[handle];
+	worldMatrices[slot] = parentGlobalMatrix * worldMatrices[slot];
+	versions[slot]++;
+}
+
+void TransformStore::Update()
+{
+	// the parallel path needs every depth level in a contiguous range
+	if (needsSort || (threadPool && !levelsValid))
+		SortByDepth();
+
+	if (!anyDirty)
+		return;
+
+	const std::size_t count = parents.size();
+
+	if (!threadPool || count < minChunkSize * 2)
+	{
+		PropagateRange(0, count);
+	}
+	else
+	{
+		// nodes of one level only read their parents' results, which are final once the previous level is done
+		for (std::size_t level = 0; level + 1 < levelOffsets.size(); level++)
+		{
+			const std::size_t begin = levelOffsets[level];
+			const std::size_t end = levelOffsets[level + 1];
+
+			if (end - begin < minChunkSize)
+			{
+				PropagateRange(begin, end);
+				continue;
+			}
+
+			threadPool->ParallelFor(end - begin, minChunkSize, [this, begin](std::size_t chunkBegin, std::size_t chunkEnd)
+			{
+				PropagateRange(begin + chunkBegin, begin + chunkEnd);
+			});
+		}
+	}
+
+	std::fill(dirty.begin(), dirty.end(), static_cast<unsigned char>(0));
+	anyDirty = false;
+	// counted once here, ComputeSlot runs on the workers
+	changeCount++;
+}
+
+void TransformStore::SetWorkerCount(unsigned int count)
+{
+	if (count == GetWorkerCount())
+		return;
+
+	if (count > 1)
+		threadPool = std::make_unique<ThreadPool>(count);
+	else
+		threadPool.reset();
+}
+
+unsigned int TransformStore::GetWorkerCount() const
+{
+	return threadPool ? threadPool->GetThreadCount() : 1;
+}
+
+void TransformStore::SetMinChunkSize(std::size_t size)
+{
+	minChunkSize = std::max<std::size_t>(size, 1);
+}
+
+std::size_t TransformStore::GetMinChunkSize() const
+{
+	return minChunkSize;
+}
+
+std::size_t TransformStore::Size() const
+{
+	return parents.size() - deadSlots;
+}
+
+void TransformStore::ComputeSlot(unsigned int slot)
+{
+	const glm::vec3& eulerRot = rotations[slot];
+
+	const glm::mat4 transformX = glm::rotate(glm::mat4(1.0f),
+		glm::radians(eulerRot.x),
+		glm::vec3(1.0f, 0.0f, 0.0f));
+	const glm::mat4 transformY = glm::rotate(glm::mat4(1.0f),
+		glm::radians(eulerRot.y),
+		glm::vec3(0.0f, 1.0f, 0.0f));
+	const glm::mat4 transformZ = glm::rotate(glm::mat4(1.0f),
+		glm::radians(eulerRot.z),
+		glm::vec3(0.0f, 0.0f, 1.0f));
+
+	const glm::mat4 rotationMatrix = transformY * transformX * transformZ;
+
+	localMatrices[slot] = glm::translate(glm::mat4(1.0f), positions[slot]) * rotationMatrix * glm::scale(glm::mat4(1.0f), scales[slot]);
+
+	const unsigned int parent = parents[slot];
+	if (parent != NoParent && slotHandles[parent] != InvalidHandle)
+		worldMatrices[slot] = worldMatrices[parent] * localMatrices[slot];
+	else
+		worldMatrices[slot] = localMatrices[slot];
+
+	versions[slot]++;
+}
+
+void TransformStore::PropagateRange(std::size_t begin, std::size_t end)
+{
+	// a group's nodes are mostly created together, so runs of one group are counted once instead of per node
+	unsigned int countedGroup = NoChangeGroup;
+
+	// parents precede children, so a parent's dirty flag is final by the time its children are visited
+	for (std::size_t slot = begin; slot < end; slot++)
+	{
+		const unsigned int parent = parents[slot];
+		if (parent != NoParent && dirty[parent])
+			dirty[slot] = 1;
+
+		if (!dirty[slot])
+			continue;
+
+		ComputeSlot(static_cast<unsigned int>(slot));
+
+		if (changeGroups[slot] != countedGroup)
+		{
+			countedGroup = changeGroups[slot];
+			CountGroupChange(static_cast<unsigned int>(slot));
+		}
+	}
+}
+
+void TransformStore::SortByDepth()
+{
+	constexpr unsigned int unknownDepth = ~0u;
+	const std::size_t count = parents.size();
+
+	// children of destroyed nodes become roots
+	for (std::size_t slot = 0; slot < count; slot++)
+	{
+		const unsigned int parent = parents[slot];
+		if (parent != NoParent && slotHandles[parent] == InvalidHandle)
+		{
+			parents[slot] = NoParent;
+			dirty[slot] = 1;
+			anyDirty = true;
+		}
+	}
+
+	// depth of every live slot, resolved by walking up until a known depth is found
+	std::vector<unsigned int> depths(count, unknownDepth);
+	std::vector<unsigned int> chain;
+	unsigned int maxDepth = 0;
+
+	for (std::size_t slot = 0; slot < count; slot++)
+	{
+		if (slotHandles[slot] == InvalidHandle || depths[slot] != unknownDepth)
+			continue;
+
+		auto current = static_cast<unsigned int>(slot);
+		chain.clear();
+		while (depths[current] == unknownDepth && parents[current] != NoParent)
+		{
+			chain.emplace_back(current);
+			current = parents[current];
+		}
+
+		if (depths[current] == unknownDepth)
+			depths[current] = 0;
+
+		unsigned int depth = depths[current];
+		for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+			depths[*it] = ++depth;
+
+		maxDepth = std::max(maxDepth, depth);
+	}
+
+	// stable counting sort by depth, dropping destroyed slots
+	std::vector<unsigned int> levelStarts(maxDepth + 2, 0);
+	for (std::size_t slot = 0; slot < count; slot++)
+	{
+		if (slotHandles[slot] != InvalidHandle)
+			levelStarts[depths[slot] + 1]++;
+	}
+
+	for (std::size_t level = 1; level < levelStarts.size(); level++)
+		levelStarts[level] += levelStarts[level - 1];
+
+	levelOffsets = levelStarts;
+
+	std::vector<unsigned int> order(count - deadSlots);
+	std::vector<unsigned int> newSlots(count, NoParent);
+	for (std::size_t slot = 0; slot < count; slot++)
+	{
+		if (slotHandles[slot] == InvalidHandle)
+			continue;
+
+		const unsigned int newSlot = levelStarts[depths[slot]]++;
+		order[newSlot] = static_cast<unsigned int>(slot);
+		newSlots[slot] = newSlot;
+	}
+
+	Permute(positions, order);
+	Permute(rotations, order);
+	Permute(scales, order);
+	Permute(localMatrices, order);
+	Permute(worldMatrices, order);
+	Permute(parents, order);
+	Permute(dirty, order);
+	Permute(versions, order);
+	Permute(slotHandles, order);
+	Permute(changeGroups, order);
+
+	for (auto& parent : parents)
+	{
+		if (parent != NoParent)
+			parent = newSlots[parent];
+	}
+
+	for (std::size_t slot = 0; slot < slotHandles.size(); slot++)
+		handleSlots[slotHandles[slot]] = static_cast<unsigned int>(slot);
+
+	deadSlots = 0;
+	needsSort = false;
+	levelsValid = true;
+}
+
+void TransformStore::CountGroupChange(unsigned int slot)
+{
+	const unsigned int group = changeGroups[slot];
+	if (group != NoChangeGroup)
+		groupChangeCounts[group - 1].fetch_add(1, std::memory_order_relaxed);
+}
+
+bool TransformStore::IsAncestor(unsigned int ancestorSlot, unsigned int slot) const
+{
+	for (unsigned int current = parents[slot]; current != NoParent; current = parents[current])
+	{
+		if (current == ancestorSlot)
+			return true;
+	}
+
+	return false;
+}
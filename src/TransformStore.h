@@ -0,0 +1,126 @@
+#pragma once
+#ifndef TRANSFORM_STORE_H
+#define TRANSFORM_STORE_H
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+class ThreadPool;
+
+// Structure-of-arrays storage for the whole transform hierarchy.
+// Nodes are addressed by stable handles, while the underlying slots are kept sorted
+// so that every parent lives in a lower slot than its children. Thanks to that the
+// world matrices can be propagated with a single linear pass over the arrays.
+// Large hierarchies can additionally be propagated level by level on a thread pool,
+// which produces exactly the same matrices as the single threaded pass.
+class TransformStore
+{
+public:
+	static constexpr unsigned int InvalidHandle = ~0u;
+	static constexpr unsigned int NoChangeGroup = 0;
+
+	// store used by default constructed Transforms
+	static TransformStore& Default();
+
+	TransformStore();
+	~TransformStore();
+	TransformStore(const TransformStore&) = delete;
+	TransformStore& operator=(const TransformStore&) = delete;
+
+	void Reserve(std::size_t count);
+
+	unsigned int Create();
+	void Destroy(unsigned int handle);
+
+	void SetParent(unsigned int handle, unsigned int parentHandle);
+	unsigned int GetParent(unsigned int handle) const;
+
+	void SetLocalPosition(unsigned int handle, const glm::vec3& newPosition);
+	void SetLocalRotation(unsigned int handle, const glm::vec3& newRotation);
+	void SetLocalScale(unsigned int handle, const glm::vec3& newScale);
+	void SetModelMatrix(unsigned int handle, const glm::mat4& newModel);
+
+	const glm::vec3& GetLocalPosition(unsigned int handle) const;
+	const glm::vec3& GetLocalRotation(unsigned int handle) const;
+	const glm::vec3& GetLocalScale(unsigned int handle) const;
+	const glm::mat4& GetLocalMatrix(unsigned int handle) const;
+	const glm::mat4& GetModelMatrix(unsigned int handle) const;
+	// incremented every time the world matrix of the node is recomputed
+	unsigned int GetModelVersion(unsigned int handle) const;
+	// incremented whenever a model version of any node may have changed, equal counts mean no node moved in between
+	std::size_t GetChangeCount() const;
+
+	// change groups count recomputations of their own nodes only, so a user of a few nodes does not have to
+	// look at them again just because an unrelated part of the store moved
+	unsigned int CreateChangeGroup();
+	// a node belongs to at most one group, false when it is already taken by another one
+	bool SetChangeGroup(unsigned int handle, unsigned int group);
+	// incremented whenever a model version of a node in the group may have changed
+	std::size_t GetGroupChangeCount(unsigned int group) const;
+
+	void MarkDirty(unsigned int handle);
+	bool IsDirty(unsigned int handle) const;
+
+	// recomputes the local and world matrix of a single node using the current world matrix of its parent
+	void ComputeNode(unsigned int handle);
+	void ComputeNode(unsigned int handle, const glm::mat4& parentGlobalMatrix);
+
+	// propagates all pending changes through the hierarchy
+	void Update();
+
+	// number of threads used by Update, 1 keeps everything on the calling thread
+	void SetWorkerCount(unsigned int count);
+	unsigned int GetWorkerCount() const;
+
+	// depth levels with fewer nodes than this are processed without the thread pool
+	void SetMinChunkSize(std::size_t size);
+	std::size_t GetMinChunkSize() const;
+
+	std::size_t Size() const;
+
+private:
+	static constexpr unsigned int NoParent = ~0u;
+
+	void ComputeSlot(unsigned int slot);
+	void PropagateRange(std::size_t begin, std::size_t end);
+	void SortByDepth();
+	bool IsAncestor(unsigned int ancestorSlot, unsigned int slot) const;
+	void CountGroupChange(unsigned int slot);
+
+	// per slot data, parents always precede their children
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec3> rotations;
+	std::vector<glm::vec3> scales;
+	std::vector<glm::mat4> localMatrices;
+	std::vector<glm::mat4> worldMatrices;
+	std::vector<unsigned int> parents;
+	std::vector<unsigned char> dirty;
+	std::vector<unsigned int> versions;
+	std::vector<unsigned int> slotHandles;
+	std::vector<unsigned int> changeGroups;
+
+	// handle indirection, so slots can be reordered without invalidating Transforms
+	std::vector<unsigned int> handleSlots;
+	std::vector<unsigned int> freeHandles;
+
+	// first slot of every depth level, valid only while levelsValid is set
+	std::vector<unsigned int> levelOffsets;
+
+	// indexed by group - 1, atomic because the workers count their chunks concurrently
+	std::deque<std::atomic<std::size_t>> groupChangeCounts;
+
+	std::unique_ptr<ThreadPool> threadPool;
+	std::size_t minChunkSize = 4096;
+
+	std::size_t deadSlots = 0;
+	std::size_t changeCount = 0;
+	bool needsSort = false;
+	bool levelsValid = false;
+	bool anyDirty = false;
+};
+
+#endif
@@ -0,0 +1,151 @@
+#include "VertexLayout.h"
+
+#include "Mesh.h"
+
+#include <glm/gtc/packing.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+	// half floats step by 2^-10 between 1 and 2, about a texel of a 1024 texture. repeating coordinates beyond that keep floats
+	constexpr float HalfTexCoordLimit = 2.0f;
+
+	constexpr GLuint PositionLocation = 0;
+	constexpr GLuint NormalLocation = 1;
+	constexpr GLuint TexCoordsLocation = 2;
+
+	// signed normalized 10:10:10:2, as read by GL_INT_2_10_10_10_REV with normalization
+	std::uint32_t PackNormal(const glm::vec3& normal)
+	{
+		const auto pack = [](float value)
+		{
+			const int quantized = static_cast<int>(std::lround(std::clamp(value, -1.0f, 1.0f) * 511.0f));
+			return static_cast<std::uint32_t>(quantized) & 0x3FFu;
+		};
+		return pack(normal.x) | pack(normal.y) << 10 | pack(normal.z) << 20;
+	}
+
+	bool FitsHalfTexCoords(const std::vector<Vertex>& vertices)
+	{
+		return std::all_of(vertices.begin(), vertices.end(), [](const Vertex& vertex)
+		{
+			return std::fabs(vertex.TexCoords.x) <= HalfTexCoordLimit && std::fabs(vertex.TexCoords.y) <= HalfTexCoordLimit;
+		});
+	}
+}
+
+VertexLayout ChooseVertexLayout(const std::vector<Vertex>& vertices, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+	VertexCompression compression)
+{
+	VertexLayout layout;
+	layout.compression = compression;
+
+	if (compression == VertexCompression::None)
+	{
+		layout.stride = sizeof(Vertex);
+		layout.attributes = {
+			{ PositionLocation, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Position) },
+			{ NormalLocation, 3, GL_FLOAT, GL_FALSE, offsetof(Vertex, Normal) },
+			{ TexCoordsLocation, 2, GL_FLOAT, GL_FALSE, offsetof(Vertex, TexCoords) } };
+		return layout;
+	}
+
+	std::size_t offset = 0;
+	if (compression == VertexCompression::Quantized)
+	{
+		// the fourth component only keeps the next attribute 4 byte aligned
+		layout.attributes.push_back({ PositionLocation, 4, GL_UNSIGNED_SHORT, GL_TRUE, offset });
+		offset += 4 * sizeof(std::uint16_t);
+		layout.positionOffset = boundsMin;
+		layout.positionScale = boundsMax - boundsMin;
+	}
+	else
+	{
+		layout.attributes.push_back({ PositionLocation, 3, GL_FLOAT, GL_FALSE, offset });
+		offset += 3 * sizeof(float);
+	}
+
+	layout.attributes.push_back({ NormalLocation, 4, GL_INT_2_10_10_10_REV, GL_TRUE, offset });
+	offset += sizeof(std::uint32_t);
+
+	layout.halfTexCoords = FitsHalfTexCoords(vertices);
+	if (layout.halfTexCoords)
+	{
+		layout.attributes.push_back({ TexCoordsLocation, 2, GL_HALF_FLOAT, GL_FALSE, offset });
+		offset += 2 * sizeof(std::uint16_t);
+	}
+	else
+	{
+		layout.attributes.push_back({ TexCoordsLocation, 2, GL_FLOAT, GL_FALSE, offset });
+		offset += 2 * sizeof(float);
+	}
+
+	layout.stride = offset;
+	return layout;
+}
+
+std::vector<unsigned char> PackVertices(const std::vector<Vertex>& vertices, const VertexLayout& layout)
+{
+	std::vector<unsigned char> packed(vertices.size() * layout.stride);
+	if (layout.compression == VertexCompression::None)
+	{
+		std::memcpy(packed.data(), vertices.data(), packed.size());
+		return packed;
+	}
+
+	// flat axes of the bounds have a zero scale, every position on them is the offset
+	const glm::vec3 inverseScale(
+		layout.positionScale.x > 0.0f ? 1.0f / layout.positionScale.x : 0.0f,
+		layout.positionScale.y > 0.0f ? 1.0f / layout.positionScale.y : 0.0f,
+		layout.positionScale.z > 0.0f ? 1.0f / layout.positionScale.z : 0.0f);
+
+	for (std::size_t i = 0; i < vertices.size(); i++)
+	{
+		const Vertex& vertex = vertices[i];
+		unsigned char* out = packed.data() + i * layout.stride;
+
+		if (layout.compression == VertexCompression::Quantized)
+		{
+			const glm::vec3 normalized = glm::clamp((vertex.Position - layout.positionOffset) * inverseScale, 0.0f, 1.0f);
+			const std::uint16_t position[4] = {
+				static_cast<std::uint16_t>(std::lround(normalized.x * 65535.0f)),
+				static_cast<std::uint16_t>(std::lround(normalized.y * 65535.0f)),
+				static_cast<std::uint16_t>(std::lround(normalized.z * 65535.0f)), 0 };
+			std::memcpy(out, position, sizeof(position));
+			out += sizeof(position);
+		}
+		else
+		{
+			std::memcpy(out, &vertex.Position, sizeof(vertex.Position));
+			out += sizeof(vertex.Position);
+		}
+
+		const std::uint32_t normal = PackNormal(vertex.Normal);
+		std::memcpy(out, &normal, sizeof(normal));
+		out += sizeof(normal);
+
+		if (layout.halfTexCoords)
+		{
+			const std::uint16_t texCoords[2] = { glm::packHalf1x16(vertex.TexCoords.x), glm::packHalf1x16(vertex.TexCoords.y) };
+			std::memcpy(out, texCoords, sizeof(texCoords));
+		}
+		else
+			std::memcpy(out, &vertex.TexCoords, sizeof(vertex.TexCoords));
+	}
+
+	return packed;
+}
+
+void ApplyVertexLayout(const VertexLayout& layout)
+{
+	for (const auto& attribute : layout.attributes)
+	{
+		glEnableVertexAttribArray(attribute.location);
+		glVertexAttribPointer(attribute.location, attribute.components, attribute.type, attribute.normalized,
+			static_cast<GLsizei>(layout.stride), reinterpret_cast<const void*>(attribute.offset));
+	}
+}
@@ -0,0 +1,57 @@
+#pragma once
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+struct Vertex;
+
+// how much the vertices of a mesh are squeezed when it is uploaded, the CPU side Vertex stays in floats
+enum class VertexCompression
+{
+	// 32 bytes: float position, normal and texture coordinates
+	None,
+	// 20 bytes: float position, 10:10:10:2 normal, half float texture coordinates
+	Packed,
+	// 16 bytes: position as unorm16 within the mesh bounds, 10:10:10:2 normal, half float texture coordinates
+	Quantized
+};
+
+// one glVertexAttribPointer call
+struct VertexAttribute
+{
+	GLuint location;
+	GLint components;
+	GLenum type;
+	GLboolean normalized;
+	std::size_t offset;
+};
+
+// Byte layout of a mesh's vertex buffer, chosen per mesh when it is created.
+// Texture coordinates stay in floats when they leave the range half floats keep precise enough,
+// so a layout may be larger than its compression suggests.
+// Shaders rebuild the position as positionOffset + positionScale * aPos, which is the identity for float positions.
+struct VertexLayout
+{
+	VertexCompression compression = VertexCompression::None;
+	bool halfTexCoords = false;
+	std::size_t stride = 0;
+	std::vector<VertexAttribute> attributes;
+	glm::vec3 positionOffset = glm::vec3(0.0f);
+	glm::vec3 positionScale = glm::vec3(1.0f);
+};
+
+VertexLayout ChooseVertexLayout(const std::vector<Vertex>& vertices, const glm::vec3& boundsMin, const glm::vec3& boundsMax,
+	VertexCompression compression);
+
+// the vertices encoded as the layout describes, ready for glBufferData
+std::vector<unsigned char> PackVertices(const std::vector<Vertex>& vertices, const VertexLayout& layout);
+
+// enables and points the layout's attributes at the buffer bound to GL_ARRAY_BUFFER, for the bound VAO
+void ApplyVertexLayout(const VertexLayout& layout);
+
+#endif
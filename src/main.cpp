@@ -10,10 +10,14 @@
 
 #include <glad/glad.h>  // Initialize with gladLoadGL()
 #include <GLFW/glfw3.h> // Include glfw3.h after our OpenGL definitions
-#include <glm/gtc/type_ptr.hpp>
 
 #include "Camera.h"
-#include "Object.h"
+#include "CpuProfiler.h"
+#include "GLExtensions.h"
+#include "GLStateCache.h"
+#include "GpuProfiler.h"
+#include "HeadlessRunner.h"
+#include "Scene.h"
 
 float lastX = 1280.0f / 2.0f;
 float lastY = 720.0f / 2.0f;
@@ -26,6 +30,9 @@ bool cursor = false;
 
 Camera camera(glm::vec3(0.0f, 5.0f, 0.0f));
 
+// time per frame spent on GL uploads of models loading in the background
+constexpr double LoadingBudgetMilliseconds = 2.0;
+
 static void glfw_error_callback(int error, const char* description)
 {
 	fprintf(stderr, "Glfw Error %d: %s\n", error, description);
@@ -95,8 +102,19 @@ static void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
 		camera.ProcessMouseScroll(yoffset);
 }
 
-int main(int, char**)
+int main(int argc, char** argv)
 {
+	if (IsHeadlessRun(argc, argv))
+	{
+		HeadlessOptions options;
+		if (!ParseHeadlessOptions(argc, argv, options))
+			return static_cast<int>(HeadlessResult::BadArguments);
+
+		const HeadlessResult result = RunHeadless(options);
+		CPU_PROFILE_EXPORT("cpu_trace.json");
+		return static_cast<int>(result);
+	}
+
 	// Setup window
 	glfwSetErrorCallback(glfw_error_callback);
 
@@ -129,6 +147,7 @@ int main(int, char**)
 		fprintf(stderr, "Failed to initialize OpenGL loader!\n");
 		return 1;
 	}
+	InitGLExtensions((GLADloadproc)glfwGetProcAddress);
 
 	// Setup Dear ImGui binding
 	IMGUI_CHECKVERSION();
@@ -143,417 +162,84 @@ int main(int, char**)
 	// Setup style
 	ImGui::StyleColorsDark();
 
-	ImVec4 clear_color = ImVec4(.22f, .22f, .22f, 1.00f);
-
-	Shader basicShader("res/shaders/basic.vert", "res/shaders/basic.frag");
-	Shader lightShader("res/shaders/light.vert", "res/shaders/light.frag");
-	Shader texturedShader("res/shaders/textured.vert", "res/shaders/light.frag");
-
 	float deltaTime = 0;
 	float lastFrame = 0;
 
-	float shininess = 2.0f;
-	bool isBlinn = false;
-	float blinnExponent = 32.0f;
-
-	//DIR LIGHT PROPERTIES
-	bool isDirLight = true;
-	glm::vec3 direction(0, 0, 0);
-	glm::vec3 ambient(.19f);
-	glm::vec3 diffuse(0);
-	glm::vec3 specular(0);
-
-	//POINT LIGHT PROPERTIES
-	bool isPointLight = false;
-	glm::vec3 pointLightPosition(0.0f);
-	glm::vec3 pointLightAmbient(1.0f);
-	glm::vec3 pointLightDiffuse(1.0f);
-	glm::vec3 pointLightSpecular(1.0f);
-	float pointLightConstant = 1.0f;
-	float pointLightLinear = .7f;
-	float pointLightQuadratic = 1.8f;
-
-	//SPOTLIGHT PROPERTIES
-	bool isSpotActive = false;
-	glm::vec3 spotLightPosition(0.0f);
-	glm::vec3 spotLightDirection(0.0f);
-	glm::vec3 spotLightAmbient(1.0f);
-	glm::vec3 spotLightDiffuse(1.0f);
-	glm::vec3 spotLightSpecular(1.0f);
-	float spotLightConstant = 1.0f;
-	float spotLightLinear = .7f;
-	float spotLightQuadratic = 1.8f;
-	float spotLightCutOff = 12.5f;
-	float spotLightOuterCutOff = 17.5f;
-
-	bool isSpot1Active = false;
-	glm::vec3 spotLight1Position(0.0f);
-	glm::vec3 spotLight1Direction(0.0f);
-	glm::vec3 spotLight1Ambient(1.0f);
-	glm::vec3 spotLight1Diffuse(1.0f);
-	glm::vec3 spotLight1Specular(1.0f);
-	float spotLight1Constant = 1.0f;
-	float spotLight1Linear = .7f;
-	float spotLight1Quadratic = 1.8f;
-	float spotLight1CutOff = 12.5f;
-	float spotLight1OuterCutOff = 17.5f;
-
-	//instanced matrices preparation
-	int rows = 200, columns = 200;
-	int amount = rows * columns;
-
-	std::vector<Transform*> houseTransforms;
-	std::vector<Transform*> roofTransforms;
-
-	auto cubeModel = new Model("res/models/cube/cube.obj");
-	auto pyramidModel = new Model("res/models/pyramid/pyramid.obj");
-	auto plane = new Model("res/models/plane/plane.obj");
-
-
-	auto neighbourhood = new Object(plane, &texturedShader);
-
-	auto neighTransform = &neighbourhood->transform;
-
-	glm::mat4 temp = glm::translate(glm::mat4(1.0f), { -400,0,-400 });
-	for (auto i = 0; i < columns; i++)
 	{
-		glm::mat4 model(1.0f);
-		for (auto j = 0; j < rows; j++)
-		{
-			auto houseTransform = new Transform();
-			auto roofTransform = new Transform();
-
-			temp = glm::translate(temp, glm::vec3(3.0f, 0.0f, 0.0f));
-			model = glm::translate(temp, { 0,1.5f,0 });
-
-			houseTransform->SetModelMatrix(model);
-			houseTransform->SetParent(neighTransform);
-
-			houseTransforms.emplace_back(houseTransform);
-
-			roofTransform->SetLocalPosition(glm::vec3(0.0f, 2.0f, 0.0f));
-			roofTransform->SetParent(houseTransforms.back());
-
-			roofTransforms.emplace_back(roofTransform);
-		}
-		temp = glm::translate(temp, glm::vec3(-1.0f * static_cast<float>(rows) * 3.0f, 0.0f, 3.0f));
-	}
-
-	auto house = new InstancedObject(cubeModel, &lightShader, houseTransforms);
-	auto roof = new InstancedObject(pyramidModel, &lightShader, roofTransforms);
-
-	Object spotLightGizmo("res/models/pyramid/pyramid.obj", &basicShader);
-	Object spotLight1Gizmo("res/models/pyramid/pyramid.obj", &basicShader);
-	Object pointLight("res/models/cube/cube.obj", &basicShader);
-
-	const auto gizmoScale = glm::vec3(0.2f);
-	spotLightGizmo.transform.SetLocalScale(gizmoScale);
-	spotLight1Gizmo.transform.SetLocalScale(gizmoScale);
-	pointLight.transform.SetLocalScale(gizmoScale);
-
-	spotLightGizmo.transform.SetParent(neighTransform);
-	spotLight1Gizmo.transform.SetParent(neighTransform);
-	pointLight.transform.SetParent(neighTransform);
-
-	neighbourhood->Update();
-
-	int chosenBuilding = 0;
-
-	glm::vec3 buildingLocalPos(0.0f);
-	glm::vec3 prevBuildingLocalPos = buildingLocalPos;
-	glm::vec3 housesLocalPos(0.0f); //house.transform->GetLocalPosition();
-	glm::vec3 prevHousesLocalPos = housesLocalPos;
-	glm::vec3 neigbourhoodLocalPos(0.0f);
-
-	// Main loop
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_CULL_FACE);
-	glCullFace(GL_BACK);
-
-	while (!glfwWindowShouldClose(window))
-	{
-		auto currentFrame = static_cast<float>(glfwGetTime());
-		deltaTime = currentFrame - lastFrame;
-		lastFrame = currentFrame;
-
-		glfwPollEvents();
-		processInput(window, deltaTime);
-
-		glClearColor(clear_color.x, clear_color.y, clear_color.z, clear_color.w);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		// Start the Dear ImGui frame
-		ImGui_ImplOpenGL3_NewFrame();
-		ImGui_ImplGlfw_NewFrame();
-		ImGui::NewFrame();
-
-		//UI
-		{
-			ImGui::Begin("Inspector");
-
-			ImGui::InputInt("Chosen building", &chosenBuilding);
-			ImGui::SliderFloat3("Building local pos", glm::value_ptr(buildingLocalPos), -10.0f, 10.0f);
-			ImGui::InputFloat3("Plane local pos", glm::value_ptr(housesLocalPos));
-
-			ImGui::InputFloat3("N loc", glm::value_ptr(neigbourhoodLocalPos));
-
-			ImGui::Text("MAERIAL");
-			ImGui::SliderFloat("Shininess", &shininess, 0.0f, 256.0f);
-
-			ImGui::Text("MISCELLANEOUS");
-			ImGui::ColorEdit3("clear color", reinterpret_cast<float*>(&clear_color));
-			ImGui::Checkbox("Blinn-Phong lighting", &isBlinn);
-			ImGui::SliderFloat("Blinn-Phong exponent", &blinnExponent, 2.0f, 256.0f);
-
-			ImGui::Checkbox("Directional light", &isDirLight);
-			ImGui::SliderFloat3("Direction", glm::value_ptr(direction), -1.0f, 1.0f);
-			ImGui::ColorEdit3("Ambient", glm::value_ptr(ambient));
-			ImGui::ColorEdit3("Diffuse", glm::value_ptr(diffuse));
-			ImGui::ColorEdit3("Specular", glm::value_ptr(specular));
-
-			ImGui::Text("POINT LIGHT");
-			ImGui::Checkbox("Point light", &isPointLight);
-		
-			ImGui::ColorEdit3("Point light ambient", glm::value_ptr(pointLightAmbient));
-			ImGui::ColorEdit3("Point light diffuse", glm::value_ptr(pointLightDiffuse));
-			ImGui::ColorEdit3("Point light specular", glm::value_ptr(pointLightSpecular));
-			ImGui::InputFloat("Point light constant", &pointLightConstant);
-			ImGui::InputFloat("Point light linear", &pointLightLinear);
-			ImGui::InputFloat("Point light quadratic", &pointLightQuadratic);
-
-			ImGui::Text("SPOT LIGHT");
-			ImGui::Checkbox("Spot light", &isSpotActive);
-			ImGui::DragFloat3("Spot light position", glm::value_ptr(spotLightPosition), .1f, -10.0f, 10.0f);
-			ImGui::SliderFloat3("Spot light direction", glm::value_ptr(spotLightDirection), -1.0f, 1.0f);
-
-			ImGui::ColorEdit3("Spot light ambient", glm::value_ptr(spotLightAmbient));
-			ImGui::ColorEdit3("Spot light diffuse", glm::value_ptr(spotLightDiffuse));
-			ImGui::ColorEdit3("Spot light specular", glm::value_ptr(spotLightSpecular));
-			ImGui::InputFloat("Spot light constant", &spotLightConstant);
-			ImGui::InputFloat("Spot light linear", &spotLightLinear);
-			ImGui::InputFloat("Spot light quadratic", &spotLightQuadratic);
-			ImGui::InputFloat("Spot light cut off", &spotLightCutOff);
-			ImGui::InputFloat("Spot light outer cut off", &spotLightOuterCutOff);
-
-			ImGui::Text("SPOT LIGHT 1");
-			ImGui::Checkbox("Spot light 1", &isSpot1Active);
-			ImGui::DragFloat3("Spot light 1 position", glm::value_ptr(spotLight1Position), .1f, -10.0f, 10.0f);
-			ImGui::SliderFloat3("Spot light 1 direction", glm::value_ptr(spotLight1Direction), -1.0f, 1.0f);
-
-			ImGui::ColorEdit3("Spot light 1 ambient", glm::value_ptr(spotLight1Ambient));
-			ImGui::ColorEdit3("Spot light 1 diffuse", glm::value_ptr(spotLight1Diffuse));
-			ImGui::ColorEdit3("Spot light 1 specular", glm::value_ptr(spotLight1Specular));
-			ImGui::InputFloat("Spot light 1 constant", &spotLight1Constant);
-			ImGui::InputFloat("Spot light 1 linear", &spotLight1Linear);
-			ImGui::InputFloat("Spot light 1 quadratic", &spotLight1Quadratic);
-			ImGui::InputFloat("Spot light 1 cut off", &spotLight1CutOff);
-			ImGui::InputFloat("Spot light 1 outer cut off", &spotLight1OuterCutOff);
-
-			ImGui::Text("Application average %.3f ms/frame (%.1f FPS)", 1000.0f / ImGui::GetIO().Framerate, ImGui::GetIO().Framerate);
-			ImGui::End();
-		}
-
-		pointLightPosition = pointLight.transform.GetLocalPosition();
-
-		glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), 1280.0f / 720.0f, 0.1f, 100.0f);
-		glm::mat4 VP = projection * camera.GetViewMatrix();
-
-		//...::SHADER UPDATES::...
-		lightShader.use();
-		lightShader.setMat4("VP", VP);
-		lightShader.setVec3("viewPos", camera.Position);
-
-		lightShader.setFloat("shininess", shininess);
-		lightShader.setVec3("offset", buildingLocalPos);
-		lightShader.setInt("chosenInstance", chosenBuilding);
-
-		lightShader.setBool("isBlinn", isBlinn);
-		lightShader.setFloat("blinnExponent", blinnExponent);
-
-		lightShader.setBool("dirLight.isActive", isDirLight);
-		lightShader.setVec3("dirLight.direction", direction);
-		lightShader.setVec3("dirLight.colors.ambient", ambient);
-		lightShader.setVec3("dirLight.colors.diffuse", diffuse);
-		lightShader.setVec3("dirLight.colors.specular", specular);
-
-		//POINT LIGHT
-		lightShader.setBool("pointLights[0].isActive", isPointLight);
-
-		lightShader.setVec3("pointLights[0].position", pointLightPosition);
-		lightShader.setFloat("pointLights[0].att.constant", pointLightConstant);
-		lightShader.setFloat("pointLights[0].att.linear", pointLightLinear);
-		lightShader.setFloat("pointLights[0].att.quadratic", pointLightQuadratic);
-
-		lightShader.setVec3("pointLights[0].colors.ambient", pointLightAmbient);
-		lightShader.setVec3("pointLights[0].colors.diffuse", pointLightDiffuse);
-		lightShader.setVec3("pointLights[0].colors.specular", pointLightSpecular);
-
-		//SPOT LIGHT 
-		lightShader.setBool("spotLights[0].isActive", isSpotActive);
-
-		lightShader.setVec3("spotLights[0].position", spotLightPosition);
-		lightShader.setVec3("spotLights[0].direction", spotLightDirection);
-
-		lightShader.setFloat("spotLights[0].att.constant", spotLightConstant);
-		lightShader.setFloat("spotLights[0].att.linear", spotLightLinear);
-		lightShader.setFloat("spotLights[0].att.quadratic", spotLightQuadratic);
-
-		lightShader.setVec3("spotLights[0].colors.ambient", spotLightAmbient);
-		lightShader.setVec3("spotLights[0].colors.diffuse", spotLightDiffuse);
-		lightShader.setVec3("spotLights[0].colors.specular", spotLightSpecular);
-
-		lightShader.setFloat("spotLights[0].cutOff", glm::cos(glm::radians(spotLightCutOff)));
-		lightShader.setFloat("spotLights[0].outerCutOff", glm::cos(glm::radians(spotLightOuterCutOff)));
+		Scene scene;
+		GpuProfiler gpuProfiler;
+		scene.SetGpuProfiler(&gpuProfiler);
 
-		//SPOT LIGHT 
-		lightShader.setBool("spotLights[1].isActive", isSpot1Active);
-
-		lightShader.setVec3("spotLights[1].position", spotLight1Position);
-		lightShader.setVec3("spotLights[1].direction", spotLight1Direction);
-		lightShader.setFloat("spotLights[1].att.constant", spotLight1Constant);
-		lightShader.setFloat("spotLights[1].att.linear", spotLight1Linear);
-		lightShader.setFloat("spotLights[1].att.quadratic", spotLight1Quadratic);
-
-		lightShader.setVec3("spotLights[1].colors.ambient", spotLight1Ambient);
-		lightShader.setVec3("spotLights[1].colors.diffuse", spotLight1Diffuse);
-		lightShader.setVec3("spotLights[1].colors.specular", spotLight1Specular);
-
-		lightShader.setFloat("spotLights[1].cutOff", glm::cos(glm::radians(spotLight1CutOff)));
-		lightShader.setFloat("spotLights[1].outerCutOff", glm::cos(glm::radians(spotLight1OuterCutOff)));
-
-
-		texturedShader.use();
-		texturedShader.setMat4("VP", VP);
-		texturedShader.setVec3("viewPos", camera.Position);
-
-		texturedShader.setFloat("shininess", shininess);
-
-		texturedShader.setBool("isBlinn", isBlinn);
-		texturedShader.setFloat("blinnExponent", blinnExponent);
-
-
-		texturedShader.setBool("dirLight.isActive", isDirLight);
-		texturedShader.setVec3("dirLight.direction", direction);
-		texturedShader.setVec3("dirLight.colors.ambient", ambient);
-		texturedShader.setVec3("dirLight.colors.diffuse", diffuse);
-		texturedShader.setVec3("dirLight.colors.specular", specular);
-
-		//POINT LIGHT
-		texturedShader.setBool("pointLights[0].isActive", isPointLight);
-
-		texturedShader.setVec3("pointLights[0].position", pointLightPosition);
-		texturedShader.setFloat("pointLights[0].att.constant", pointLightConstant);
-		texturedShader.setFloat("pointLights[0].att.linear", pointLightLinear);
-		texturedShader.setFloat("pointLights[0].att.quadratic", pointLightQuadratic);
-
-		texturedShader.setVec3("pointLights[0].colors.ambient", pointLightAmbient);
-		texturedShader.setVec3("pointLights[0].colors.diffuse", pointLightDiffuse);
-		texturedShader.setVec3("pointLights[0].colors.specular", pointLightSpecular);
-
-		//SPOT LIGHT 
-		texturedShader.setBool("spotLights[0].isActive", isSpotActive);
-
-		texturedShader.setVec3("spotLights[0].position", spotLightPosition);
-		texturedShader.setVec3("spotLights[0].direction", spotLightDirection);
-
-		texturedShader.setFloat("spotLights[0].att.constant", spotLightConstant);
-		texturedShader.setFloat("spotLights[0].att.linear", spotLightLinear);
-		texturedShader.setFloat("spotLights[0].att.quadratic", spotLightQuadratic);
-
-		texturedShader.setVec3("spotLights[0].colors.ambient", spotLightAmbient);
-		texturedShader.setVec3("spotLights[0].colors.diffuse", spotLightDiffuse);
-		texturedShader.setVec3("spotLights[0].colors.specular", spotLightSpecular);
-
-		texturedShader.setFloat("spotLights[0].cutOff", glm::cos(glm::radians(spotLightCutOff)));
-		texturedShader.setFloat("spotLights[0].outerCutOff", glm::cos(glm::radians(spotLightOuterCutOff)));
-
-		//SPOT LIGHT 
-		texturedShader.setBool("spotLights[1].isActive", isSpot1Active);
-
-		texturedShader.setVec3("spotLights[1].position", spotLight1Position);
-		texturedShader.setVec3("spotLights[1].direction", spotLight1Direction);
-		texturedShader.setFloat("spotLights[1].att.constant", spotLight1Constant);
-		texturedShader.setFloat("spotLights[1].att.linear", spotLight1Linear);
-		texturedShader.setFloat("spotLights[1].att.quadratic", spotLight1Quadratic);
-
-		texturedShader.setVec3("spotLights[1].colors.ambient", spotLight1Ambient);
-		texturedShader.setVec3("spotLights[1].colors.diffuse", spotLight1Diffuse);
-		texturedShader.setVec3("spotLights[1].colors.specular", spotLight1Specular);
-
-		texturedShader.setFloat("spotLights[1].cutOff", glm::cos(glm::radians(spotLight1CutOff)));
-		texturedShader.setFloat("spotLights[1].outerCutOff", glm::cos(glm::radians(spotLight1OuterCutOff)));
-
-		basicShader.use();
-		basicShader.setMat4("VP", VP);
-		basicShader.setVec3("diffuse", pointLightDiffuse * pointLightAmbient * pointLightSpecular);
-		//...::SHADER UPDATES END::...
-
-
-		spotLightGizmo.transform.SetLocalPosition(spotLightPosition);
-		spotLightGizmo.transform.SetLocalRotation(spotLightDirection);
-
-		spotLight1Gizmo.transform.SetLocalPosition(spotLight1Position);
-		spotLight1Gizmo.transform.SetLocalRotation(spotLight1Direction);
-
-		if (buildingLocalPos != prevBuildingLocalPos)
-		{
-			prevBuildingLocalPos = buildingLocalPos;
-			house->instanceTransforms[chosenBuilding]->SetLocalPosition(buildingLocalPos);
-		}
-
-		if (housesLocalPos != prevHousesLocalPos)
+		// Main loop
+		while (!glfwWindowShouldClose(window))
 		{
-			prevHousesLocalPos = housesLocalPos;
-			neighTransform->SetLocalPosition(housesLocalPos);
+			auto currentFrame = static_cast<float>(glfwGetTime());
+			deltaTime = currentFrame - lastFrame;
+			lastFrame = currentFrame;
+
+			CPU_PROFILE_SCOPE("Frame");
+
+			{
+				CPU_PROFILE_SCOPE("Input");
+				glfwPollEvents();
+				processInput(window, deltaTime);
+			}
+
+			{
+				CPU_PROFILE_SCOPE("UI");
+				// Start the Dear ImGui frame
+				ImGui_ImplOpenGL3_NewFrame();
+				ImGui_ImplGlfw_NewFrame();
+				ImGui::NewFrame();
+
+				//UI
+				scene.DrawInspector();
+			}
+
+			int display_w, display_h;
+			glfwGetFramebufferSize(window, &display_w, &display_h);
+
+			{
+				CPU_PROFILE_SCOPE("Scene update");
+				scene.ProcessLoading(LoadingBudgetMilliseconds);
+				scene.Update(currentFrame);
+			}
+
+			gpuProfiler.BeginFrame();
+			{
+				CPU_PROFILE_SCOPE("Scene render");
+				scene.Render(camera, display_w, display_h);
+			}
+
+			// Rendering
+			{
+				CPU_PROFILE_SCOPE("ImGui render");
+				ImGui::Render();
+
+				GpuProfiler::Scope scope(&gpuProfiler, "ImGui");
+				ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+				// the backend binds its own objects with plain GL calls
+				GLStateCache::Default().Invalidate();
+			}
+			gpuProfiler.EndFrame();
+
+			{
+				CPU_PROFILE_SCOPE("Swap");
+				glfwMakeContextCurrent(window);
+				glfwSwapBuffers(window);
+			}
 		}
-
-		house->transform.SetLocalPosition(neigbourhoodLocalPos);
-		house->transform.Update();
-
-
-		const auto a = static_cast<float>(glfwGetTime());
-		pointLight.transform.SetLocalRotationX(15 * a);
-		pointLight.transform.SetLocalRotationY(15 * a);
-		pointLight.transform.SetLocalPosition({ 10 * glm::sin(a), 10 + 10 * glm::cos(a), 0 });
-
-
-		neighTransform->Update();
-
-		neighbourhood->Draw();
-		house->Draw();
-		roof->Draw();
-		basicShader.setVec3("diffuse", pointLightDiffuse * pointLightAmbient * pointLightSpecular);
-
-		pointLight.Draw();
-		basicShader.setVec3("diffuse", spotLightDiffuse * spotLightAmbient * spotLightSpecular);
-
-		spotLightGizmo.Draw();
-		basicShader.setVec3("diffuse", spotLight1Diffuse * spotLight1Ambient * spotLight1Specular);
-
-		spotLight1Gizmo.Draw();
-
-		// Rendering
-		ImGui::Render();
-
-		int display_w, display_h;
-		glfwMakeContextCurrent(window);
-		glfwGetFramebufferSize(window, &display_w, &display_h);
-
-		ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
-
-		glfwMakeContextCurrent(window);
-		glfwSwapBuffers(window);
 	}
 
+	CPU_PROFILE_EXPORT("cpu_trace.json");
+
 	// Cleanup
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
 	ImGui::DestroyContext();
 
-	delete neighbourhood;
-
 	glfwDestroyWindow(window);
 	glfwTerminate();
 
 	return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,250 @@
+#include "BlockCompression.h"
+#include "KtxFile.h"
+#include "MeshCache.h"
+#include "TextureLoader.h"
+
+#include <assimp/Importer.hpp>
+#include <assimp/scene.h>
+#include <stb_image.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const char* BlockFormatNames[] = { "BC1", "BC3", "BC5" };
+
+	// an image to bake, normal maps keep only x and y
+	struct BakeJob
+	{
+		std::string path;
+		bool normalMap = false;
+	};
+
+	// one row of the memory footprint report
+	struct BakeResult
+	{
+		std::string path;
+		int width = 0;
+		int height = 0;
+		BlockFormat format = BlockFormat::BC1;
+		// what the loader keeps resident for the plain image: the base level plus a third for the driver's mips
+		std::size_t plainBytes = 0;
+		std::size_t bakedBytes = 0;
+		bool upToDate = false;
+	};
+
+	void PrintUsage()
+	{
+		std::cout << "usage: texbake [--normal] [--force] FILE...\n"
+			"FILE is an image, or a model whose material textures are all baked, its normal maps as BC5.\n"
+			"--normal bakes the images that follow as normal maps, --force bakes images whose bake is current" << std::endl;
+	}
+
+	void AddJob(std::vector<BakeJob>& jobs, const std::string& path, bool normalMap)
+	{
+		const auto found = std::find_if(jobs.begin(), jobs.end(), [&path](const BakeJob& job) { return job.path == path; });
+		if (found == jobs.end())
+			jobs.push_back({ path, normalMap });
+	}
+
+	bool IsModelFile(const std::string& path)
+	{
+		const auto dot = path.find_last_of('.');
+		return dot != std::string::npos && Assimp::Importer().IsExtensionSupported(path.substr(dot));
+	}
+
+	// the textures referenced by the model's materials, with the types Model loads them as
+	bool AddModelJobs(std::vector<BakeJob>& jobs, const std::string& path)
+	{
+		Assimp::Importer importer;
+		const aiScene* scene = importer.ReadFile(path, 0);
+		if (!scene)
+			return false;
+
+		const std::string directory = path.substr(0, path.find_last_of('/'));
+		const std::pair<aiTextureType, bool> types[] = {
+			{ aiTextureType_DIFFUSE, false }, { aiTextureType_SPECULAR, false },
+			{ aiTextureType_HEIGHT, true }, { aiTextureType_NORMALS, true }, { aiTextureType_AMBIENT, false } };
+
+		for (unsigned int i = 0; i < scene->mNumMaterials; i++)
+		{
+			const aiMaterial* material = scene->mMaterials[i];
+			for (const auto& [type, normalMap] : types)
+			{
+				for (unsigned int t = 0; t < material->GetTextureCount(type); t++)
+				{
+					aiString texturePath;
+					material->GetTexture(type, t, &texturePath);
+					AddJob(jobs, directory + '/' + texturePath.C_Str(), normalMap);
+				}
+			}
+		}
+		return true;
+	}
+
+	// widens a level to RGBA the way GL samples it: missing color channels read 0 and a missing alpha 1
+	std::vector<unsigned char> ToRgba(const std::vector<unsigned char>& pixels, int components)
+	{
+		const std::size_t count = pixels.size() / components;
+		std::vector<unsigned char> rgba(count * 4, 0);
+		for (std::size_t i = 0; i < count; i++)
+		{
+			for (int c = 0; c < std::min(components, 3); c++)
+				rgba[i * 4 + c] = pixels[i * components + c];
+			rgba[i * 4 + 3] = components == 4 ? pixels[i * components + 3] : 255;
+		}
+		return rgba;
+	}
+
+	BlockFormat ChooseFormat(const DecodedTexture& texture, bool normalMap)
+	{
+		if (normalMap)
+			return BlockFormat::BC5;
+		if (texture.components != 4)
+			return BlockFormat::BC1;
+
+		const auto& pixels = texture.levels.front();
+		for (std::size_t i = 3; i < pixels.size(); i += 4)
+		{
+			if (pixels[i] != 255)
+				return BlockFormat::BC3;
+		}
+		return BlockFormat::BC1;
+	}
+
+	bool Bake(const BakeJob& job, bool force, BakeResult& result)
+	{
+		std::uint64_t sourceHash = 0;
+		if (!HashFile(job.path, sourceHash))
+			return false;
+
+		result.path = job.path;
+		const std::string bakedPath = GetBakedTexturePath(job.path);
+
+		int width, height, components;
+		if (!stbi_info(job.path.c_str(), &width, &height, &components))
+			return false;
+		result.width = width;
+		result.height = height;
+		result.plainBytes = static_cast<std::size_t>(width) * height * components;
+		result.plainBytes += result.plainBytes / 3;
+
+		KtxTexture baked;
+		if (!force && ReadKtxFile(bakedPath, baked) && baked.sourceHash == sourceHash)
+			result.upToDate = true;
+		else
+		{
+			DecodedTexture texture;
+			if (!DecodeTextureFile(job.path, texture, true))
+				return false;
+
+			baked = KtxTexture();
+			baked.format = ChooseFormat(texture, job.normalMap);
+			baked.width = texture.width;
+			baked.height = texture.height;
+			baked.sourceHash = sourceHash;
+
+			int levelWidth = texture.width;
+			int levelHeight = texture.height;
+			for (const auto& level : texture.levels)
+			{
+				const std::vector<unsigned char> rgba = ToRgba(level, texture.components);
+				baked.levels.emplace_back(CompressImage(rgba.data(), levelWidth, levelHeight, baked.format));
+				levelWidth = std::max(levelWidth / 2, 1);
+				levelHeight = std::max(levelHeight / 2, 1);
+			}
+
+			if (!WriteKtxFile(bakedPath, baked))
+			{
+				std::cout << "ERROR::TEXBAKE::NOT_WRITTEN " << bakedPath << std::endl;
+				return false;
+			}
+		}
+
+		result.format = baked.format;
+		for (const auto& level : baked.levels)
+			result.bakedBytes += level.size();
+		return true;
+	}
+
+	void PrintReport(const std::vector<BakeResult>& results)
+	{
+		std::size_t plainTotal = 0;
+		std::size_t bakedTotal = 0;
+
+		std::printf("%-48s %11s %6s %12s %12s %7s\n", "texture", "size", "format", "plain KB", "baked KB", "ratio");
+		for (const auto& result : results)
+		{
+			std::printf("%-48s %5dx%-5d %6s %12.1f %12.1f %6.1fx%s\n", result.path.c_str(), result.width, result.height,
+				BlockFormatNames[static_cast<int>(result.format)], result.plainBytes / 1024.0, result.bakedBytes / 1024.0,
+				static_cast<double>(result.plainBytes) / static_cast<double>(result.bakedBytes), result.upToDate ? " (up to date)" : "");
+			plainTotal += result.plainBytes;
+			bakedTotal += result.bakedBytes;
+		}
+
+		if (bakedTotal > 0)
+		{
+			std::printf("%zu textures: %.2f MB plain, %.2f MB baked, %.1fx smaller\n", results.size(), plainTotal / (1024.0 * 1024.0),
+				bakedTotal / (1024.0 * 1024.0), static_cast<double>(plainTotal) / static_cast<double>(bakedTotal));
+		}
+	}
+}
+
+// Bakes images into block compressed KTX2 files next to them, which the texture loader prefers over the images,
+// and prints how much GPU memory the baked textures take compared with the plain ones.
+int main(int argc, char** argv)
+{
+	std::vector<BakeJob> jobs;
+	bool normalMaps = false;
+	bool force = false;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string argument = argv[i];
+		if (argument == "--normal")
+			normalMaps = true;
+		else if (argument == "--force")
+			force = true;
+		else if (argument.rfind("--", 0) == 0)
+		{
+			PrintUsage();
+			return 1;
+		}
+		else if (IsModelFile(argument))
+		{
+			if (!AddModelJobs(jobs, argument))
+			{
+				std::cout << "ERROR::TEXBAKE::MODEL_NOT_IMPORTED " << argument << std::endl;
+				return 1;
+			}
+		}
+		else
+			AddJob(jobs, argument, normalMaps);
+	}
+
+	if (jobs.empty())
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	int result = 0;
+	std::vector<BakeResult> results;
+	for (const auto& job : jobs)
+	{
+		BakeResult& baked = results.emplace_back();
+		if (!Bake(job, force, baked))
+		{
+			std::cout << "ERROR::TEXBAKE::FAILED " << job.path << std::endl;
+			results.pop_back();
+			result = 2;
+		}
+	}
+
+	PrintReport(results);
+	return result;
+}
@@ -2,6 +2,10 @@
 find_package(OpenGL REQUIRED)
 set(OPENGL_LIBRARY ${OPENGL_LIBRARIES})
 
+# EGL, optional, only the headless mode needs it
+find_library(EGL_LIBRARY "EGL" "/usr/lib" "/usr/local/lib")
+find_path(EGL_INCLUDE_DIR "EGL/egl.h" "/usr/include" "/usr/local/include")
+
 # assimp
 find_library(ASSIMP_LIBRARY "assimp" "/usr/lib" "/usr/local/lib")
 find_path(ASSIMP_INCLUDE_DIR "assimp/mesh.h" "/usr/include" "/usr/local/include")